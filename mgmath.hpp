@@ -1,15 +1,62 @@
 #pragma once
 #include <cassert>
+#include <charconv>
 #include <cmath>
 #include <cstdint>
+#include <exception>
+#include <limits>
 #include <memory.h>
+#include <new>
 #include <ostream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <type_traits>
+#include <vector>
+
+#if defined(MGMATH_PROFILE) || defined(MGMATH_CHECK_FLOATS)
+#include <atomic>
+#endif
+#if defined(MGMATH_PROFILE)
+#include <chrono>
+#include <mutex>
+#endif
+
+#if defined(MGMATH_IO)
+#if __cplusplus < 202002L && (!defined(_MSVC_LANG) || _MSVC_LANG < 202002L)
+#error "MGMATH_IO needs C++20 (std::span)"
+#endif
+#include <cstdio>
+#include <span>
+#if defined(_WIN32)
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif
 
 #if defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)
 #include <smmintrin.h>
 #include <xmmintrin.h>
+#if !defined(MGMATH_SSE4_1) && (defined(__SSE4_1__) || defined(__AVX__))
+#define MGMATH_SSE4_1
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA) || (defined(_MSC_VER) && defined(__AVX2__))
+#define MGMATH_FMA
 #endif
 
 #define ASSURE_SIZE(SIZE) luint VectorSize = S, typename std::enable_if<VectorSize >= SIZE, bool>::type = true
@@ -21,10 +68,6 @@ namespace mgm {
     static constexpr double mgmath_pi = 3.14159265358979323846264338327950288419716939;
     static constexpr float mgmath_fpi = static_cast<float>(mgmath_pi);
 
-    //=========
-    // VECTORS
-    //=========
-
     using uint8 = uint8_t;
     using int8 = int8_t;
     using uint16 = uint16_t;
@@ -48,6 +91,514 @@ namespace mgm {
     using uptr = uintptr_t;
 
 
+    //===========
+    // PROFILING
+    //===========
+
+    // With MGMATH_PROFILE defined, the operations below count their calls per component type, and whether they ran
+    // SIMD or scalar code; the batch functions also count the elements they process, and measure their time when
+    // MGMATH_PROFILE_TIMERS is defined too. Without MGMATH_PROFILE, the macros expand to nothing
+#if defined(MGMATH_PROFILE)
+    enum class profile_op : uint32 {
+        vec_normalize,
+        mat_mul,
+        mat_transform,
+        mat_inverse,
+        mat_transpose,
+        quat_mul,
+        quat_rotate,
+        quat_slerp,
+        batch_saturated,
+        batch_transpose,
+        batch_fixed,
+        batch_svd,
+        batch_polar,
+        batch_eigen,
+        batch_decompose,
+        batch_compose,
+        batch_track_sample,
+        batch_spline,
+        batch_random,
+        batch_noise,
+        batch_pack,
+        batch_unpack,
+        batch_convert,
+        batch_overlap,
+        count
+    };
+
+    static constexpr const char* profile_op_names[] = {
+        "vec_normalize", "mat_mul", "mat_transform", "mat_inverse", "mat_transpose", "quat_mul", "quat_rotate", "quat_slerp",
+        "batch_saturated", "batch_transpose", "batch_fixed", "batch_svd", "batch_polar", "batch_eigen", "batch_decompose",
+        "batch_compose", "batch_track_sample", "batch_spline", "batch_random", "batch_noise", "batch_pack", "batch_unpack",
+        "batch_convert", "batch_overlap",
+    };
+    static_assert(sizeof(profile_op_names) / sizeof(profile_op_names[0]) == static_cast<uint32>(profile_op::count), "Every operation needs a name");
+
+    enum class profile_type : uint32 { f32, f64, integer, other, count };
+    static constexpr const char* profile_type_names[] = {"float", "double", "integer", "other"};
+
+    template<typename T>
+    constexpr profile_type profile_type_of() {
+        if constexpr (std::is_same_v<T, float>)
+            return profile_type::f32;
+        else if constexpr (std::is_same_v<T, double>)
+            return profile_type::f64;
+        else if constexpr (std::is_integral_v<T>)
+            return profile_type::integer;
+        else
+            return profile_type::other;
+    }
+
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+    static constexpr bool profile_simd_build = true;
+#else
+    static constexpr bool profile_simd_build = false;
+#endif
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+    static constexpr bool profile_simd_sse4_1_build = true;
+#else
+    static constexpr bool profile_simd_sse4_1_build = false;
+#endif
+
+    // Whether the products, sums and dot products of vec<S, T> use SIMD in this build
+    template<luint S, typename T>
+    constexpr bool profile_simd_vec() {
+        return profile_simd_build && (std::is_same_v<T, float> || std::is_same_v<T, double>) && S >= 2 && S <= 4;
+    }
+
+    /**
+     * @brief Calls, processed elements and nanoseconds of every operation, component type and path (scalar, then SIMD)
+     */
+    struct profile_counters {
+        static constexpr uint32 ops = static_cast<uint32>(profile_op::count);
+        static constexpr uint32 types = static_cast<uint32>(profile_type::count);
+
+        uint64 calls[ops][types][2]{};
+        uint64 items[ops][types][2]{};
+        uint64 nanoseconds[ops][types][2]{};
+
+        profile_counters& operator+=(const profile_counters& c) {
+            for (uint32 i = 0; i < ops; i++)
+                for (uint32 j = 0; j < types; j++)
+                    for (uint32 k = 0; k < 2; k++) {
+                        calls[i][j][k] += c.calls[i][j][k];
+                        items[i][j][k] += c.items[i][j][k];
+                        nanoseconds[i][j][k] += c.nanoseconds[i][j][k];
+                    }
+            return *this;
+        }
+
+        /**
+         * @brief Export the counters of every operation that was called as JSON
+         */
+        std::string to_json() const {
+            std::string res = "{\"operations\":[";
+            bool first = true;
+            for (uint32 i = 0; i < ops; i++)
+                for (uint32 j = 0; j < types; j++)
+                    for (uint32 k = 0; k < 2; k++) {
+                        if (calls[i][j][k] == 0)
+                            continue;
+                        res += first ? "\n" : ",\n";
+                        res += "{\"operation\":\"";
+                        res += profile_op_names[i];
+                        res += "\",\"type\":\"";
+                        res += profile_type_names[j];
+                        res += k ? "\",\"path\":\"simd\",\"calls\":" : "\",\"path\":\"scalar\",\"calls\":";
+                        res += std::to_string(calls[i][j][k]);
+                        res += ",\"items\":";
+                        res += std::to_string(items[i][j][k]);
+                        res += ",\"nanoseconds\":";
+                        res += std::to_string(nanoseconds[i][j][k]);
+                        res += "}";
+                        first = false;
+                    }
+            res += "\n]}\n";
+            return res;
+        }
+    };
+
+    /**
+     * @brief The counters of a single thread; only that thread writes to them, so relaxed atomics cost no more than plain integers
+     */
+    struct profile_thread_counters {
+        std::atomic<uint64> calls[profile_counters::ops][profile_counters::types][2]{};
+        std::atomic<uint64> items[profile_counters::ops][profile_counters::types][2]{};
+        std::atomic<uint64> nanoseconds[profile_counters::ops][profile_counters::types][2]{};
+
+        profile_thread_counters();
+        ~profile_thread_counters();
+
+        void add(const profile_op op, const profile_type type, const bool simd, const luint n, const uint64 ns) {
+            const auto bump = [](std::atomic<uint64>& c, const uint64 v) { c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed); };
+            const uint32 i = static_cast<uint32>(op), j = static_cast<uint32>(type), k = simd;
+            bump(calls[i][j][k], 1);
+            bump(items[i][j][k], n);
+            if (ns != 0)
+                bump(nanoseconds[i][j][k], ns);
+        }
+
+        void read_into(profile_counters& dst) const {
+            for (uint32 i = 0; i < profile_counters::ops; i++)
+                for (uint32 j = 0; j < profile_counters::types; j++)
+                    for (uint32 k = 0; k < 2; k++) {
+                        dst.calls[i][j][k] += calls[i][j][k].load(std::memory_order_relaxed);
+                        dst.items[i][j][k] += items[i][j][k].load(std::memory_order_relaxed);
+                        dst.nanoseconds[i][j][k] += nanoseconds[i][j][k].load(std::memory_order_relaxed);
+                    }
+        }
+
+        void clear() {
+            for (uint32 i = 0; i < profile_counters::ops; i++)
+                for (uint32 j = 0; j < profile_counters::types; j++)
+                    for (uint32 k = 0; k < 2; k++) {
+                        calls[i][j][k].store(0, std::memory_order_relaxed);
+                        items[i][j][k].store(0, std::memory_order_relaxed);
+                        nanoseconds[i][j][k].store(0, std::memory_order_relaxed);
+                    }
+        }
+    };
+
+    /**
+     * @brief The counters of every running thread, and the sum of the counters of the threads that exited
+     */
+    class profile_registry {
+        std::mutex lock;
+        std::vector<profile_thread_counters*> threads;
+        profile_counters exited;
+
+      public:
+        static profile_registry& instance() {
+            static profile_registry registry;
+            return registry;
+        }
+
+        void attach(profile_thread_counters* t) {
+            const std::lock_guard<std::mutex> guard(lock);
+            threads.push_back(t);
+        }
+
+        void detach(profile_thread_counters* t) {
+            const std::lock_guard<std::mutex> guard(lock);
+            t->read_into(exited);
+            for (luint i = 0; i < threads.size(); i++)
+                if (threads[i] == t) {
+                    threads[i] = threads.back();
+                    threads.pop_back();
+                    break;
+                }
+        }
+
+        profile_counters snapshot() {
+            const std::lock_guard<std::mutex> guard(lock);
+            profile_counters res = exited;
+            for (const profile_thread_counters* t : threads)
+                t->read_into(res);
+            return res;
+        }
+
+        void reset() {
+            const std::lock_guard<std::mutex> guard(lock);
+            exited = profile_counters{};
+            for (profile_thread_counters* t : threads)
+                t->clear();
+        }
+    };
+
+    inline profile_thread_counters::profile_thread_counters() {
+        profile_registry::instance().attach(this);
+    }
+    inline profile_thread_counters::~profile_thread_counters() {
+        profile_registry::instance().detach(this);
+    }
+
+    inline void profile_count(const profile_op op, const profile_type type, const bool simd, const luint n, const uint64 ns = 0) {
+        thread_local profile_thread_counters counters;
+        counters.add(op, type, simd, n, ns);
+    }
+
+    /**
+     * @brief Counts a call to a batch function when it goes out of scope, with its duration when MGMATH_PROFILE_TIMERS is defined
+     */
+    class profile_timer {
+        profile_op op;
+        profile_type type;
+        bool simd;
+        luint n;
+#if defined(MGMATH_PROFILE_TIMERS)
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#endif
+
+      public:
+        profile_timer(const profile_op op, const profile_type type, const bool simd, const luint n)
+            : op(op), type(type), simd(simd), n(n) {}
+        profile_timer(const profile_timer&) = delete;
+        profile_timer& operator=(const profile_timer&) = delete;
+
+        ~profile_timer() {
+#if defined(MGMATH_PROFILE_TIMERS)
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            profile_count(op, type, simd, n, static_cast<uint64>(ns) + (ns == 0));
+#else
+            profile_count(op, type, simd, n);
+#endif
+        }
+    };
+
+    /**
+     * @brief The sum of the counters of every thread (including the threads that exited) since the start or the last profile_reset
+     */
+    inline profile_counters profile_snapshot() {
+        return profile_registry::instance().snapshot();
+    }
+
+    /**
+     * @brief Set every counter of every thread back to 0 (counts made by other threads at the same time may be lost)
+     */
+    inline void profile_reset() {
+        profile_registry::instance().reset();
+    }
+
+    /**
+     * @brief The sum of the counters of every thread as JSON: `{"operations":[{"operation":"mat_mul","type":"float","path":"simd","calls":...,"items":...,"nanoseconds":...},...]}`
+     */
+    inline std::string profile_report_json() {
+        return profile_snapshot().to_json();
+    }
+
+#define MGMATH_PROFILE_COUNT(OP, T, ...) ::mgm::profile_count(::mgm::profile_op::OP, ::mgm::profile_type_of<T>(), (__VA_ARGS__), 1)
+#define MGMATH_PROFILE_BATCH(OP, T, ITEMS, ...) const ::mgm::profile_timer mgmath_profile_batch(::mgm::profile_op::OP, ::mgm::profile_type_of<T>(), (__VA_ARGS__), (ITEMS))
+#else
+#define MGMATH_PROFILE_COUNT(OP, T, ...) ((void)0)
+#define MGMATH_PROFILE_BATCH(OP, T, ITEMS, ...) ((void)0)
+#endif
+
+
+    //============================
+    // FLOATING POINT ENVIRONMENT
+    //============================
+
+    /**
+     * @brief Flush denormal floats to zero (FTZ and DAZ on x86, FZ on ARM64) until the end of the scope, then restore the previous mode
+     *
+     * Arithmetic producing or reading denormals (values decaying towards zero) can be 10 to 100 times slower than usual.
+     * The mode belongs to the current thread, so every thread needs its own scope
+     */
+    class flush_denormals_scope {
+#if defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)
+        unsigned int saved;
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+        uint64 saved;
+#endif
+
+      public:
+        /**
+         * @param flush Whether to flush denormals to zero (false keeps them until the end of the scope instead)
+         */
+        explicit flush_denormals_scope(const bool flush = true) {
+#if defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)
+            // Bit 15 of MXCSR flushes denormal results to zero, bit 6 reads denormal inputs as zero
+            constexpr unsigned int bits = 0x8040;
+            saved = _mm_getcsr();
+            _mm_setcsr(flush ? saved | bits : saved & ~bits);
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+            // Bit 24 of FPCR flushes both denormal inputs and results to zero
+            constexpr uint64 bits = uint64(1) << 24;
+            __asm__ __volatile__("mrs %0, fpcr" : "=r"(saved));
+            const uint64 mode = flush ? saved | bits : saved & ~bits;
+            __asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+#else
+            (void)flush;
+#endif
+        }
+
+        flush_denormals_scope(const flush_denormals_scope&) = delete;
+        flush_denormals_scope& operator=(const flush_denormals_scope&) = delete;
+
+        ~flush_denormals_scope() {
+#if defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)
+            _mm_setcsr(saved);
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+            __asm__ __volatile__("msr fpcr, %0" : : "r"(saved));
+#endif
+        }
+    };
+
+    enum float_issue : uint32 {
+        float_nan = 1,
+        float_infinity = 2,
+        float_denormal = 4,
+    };
+
+    /**
+     * @brief The float_issue bits of the NaN, infinite and denormal values in an array (always 0 for other types than float and double)
+     *
+     * The bits are read directly, so the result is the same with fast math, and when denormals are flushed to zero
+     */
+    template<typename T>
+    inline uint32 float_issues(const T* values, const luint count) {
+        uint32 res = 0;
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+            using bits = std::conditional_t<sizeof(T) == 4, uint32, uint64>;
+            constexpr int mantissa = std::numeric_limits<T>::digits - 1;
+            constexpr bits exponent = (~bits(0) >> 1) >> mantissa << mantissa;
+            constexpr bits fraction = (bits(1) << mantissa) - 1;
+            for (luint i = 0; i < count; i++) {
+                bits b;
+                memcpy(&b, values + i, sizeof(b));
+                if ((b & exponent) == exponent)
+                    res |= (b & fraction) != 0 ? float_nan : float_infinity;
+                else if ((b & exponent) == 0 && (b & fraction) != 0)
+                    res |= float_denormal;
+            }
+        }
+        return res;
+    }
+
+    // With MGMATH_CHECK_FLOATS defined, the arithmetic of float and double vectors, the products, transforms and inverses
+    // of matrices, quaternion products and the batch functions of floats look for NaN, infinite and denormal values in
+    // their inputs and outputs. Every operation that finds any is counted, and passed to the handler set with
+    // set_float_check_handler (which can log it, break into a debugger, or throw with float_check_throw)
+#if defined(MGMATH_CHECK_FLOATS)
+    /**
+     * @brief An operation that found NaN, infinite or denormal values, with the float_issue bits of its inputs and outputs
+     *
+     * An issue in the output that isn't in the inputs was created by this operation
+     */
+    struct float_issue_report {
+        const char* operation;
+        uint32 input;
+        uint32 output;
+    };
+
+    using float_check_handler = void (*)(const float_issue_report& report);
+
+    /**
+     * @brief The number of operations that found each kind of issue, in their inputs and in their outputs
+     */
+    struct float_check_counts {
+        uint64 input_nan = 0, input_infinity = 0, input_denormal = 0;
+        uint64 output_nan = 0, output_infinity = 0, output_denormal = 0;
+    };
+
+    struct float_check_state {
+        std::atomic<float_check_handler> handler{nullptr};
+        std::atomic<uint64> counts[2][3]{};
+
+        static float_check_state& instance() {
+            static float_check_state state;
+            return state;
+        }
+    };
+
+    /**
+     * @brief Set the function called for every operation that finds NaN, infinite or denormal values (nullptr to only count them), and return the previous one
+     */
+    inline float_check_handler set_float_check_handler(const float_check_handler handler) {
+        return float_check_state::instance().handler.exchange(handler);
+    }
+
+    /**
+     * @brief A handler throwing a std::runtime_error naming the operation, when it created NaN, infinite or denormal values its inputs didn't have
+     */
+    inline void float_check_throw(const float_issue_report& report) {
+        const uint32 created = report.output & ~report.input;
+        if (created == 0)
+            return;
+        std::string message = std::string("mgmath: ") + report.operation + " produced";
+        if (created & float_nan)
+            message += " NaN";
+        if (created & float_infinity)
+            message += " infinity";
+        if (created & float_denormal)
+            message += " denormal";
+        throw std::runtime_error(message);
+    }
+
+    inline float_check_counts float_check_snapshot() {
+        auto& c = float_check_state::instance().counts;
+        float_check_counts res;
+        res.input_nan = c[0][0].load(std::memory_order_relaxed);
+        res.input_infinity = c[0][1].load(std::memory_order_relaxed);
+        res.input_denormal = c[0][2].load(std::memory_order_relaxed);
+        res.output_nan = c[1][0].load(std::memory_order_relaxed);
+        res.output_infinity = c[1][1].load(std::memory_order_relaxed);
+        res.output_denormal = c[1][2].load(std::memory_order_relaxed);
+        return res;
+    }
+
+    inline void float_check_reset() {
+        for (auto& direction : float_check_state::instance().counts)
+            for (auto& count : direction)
+                count.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Checks the inputs of an operation when created, and its output when destroyed, at the end of the operation
+     */
+    class float_check_scope {
+        const char* operation;
+        const void* output;
+        luint output_count;
+        uint32 (*output_issues)(const void*, luint);
+        uint32 input = 0;
+
+        template<typename U>
+        static uint32 issues_of(const void* values, const luint count) {
+            return float_issues(static_cast<const U*>(values), count);
+        }
+
+        void add_inputs() {}
+        template<typename I, typename... Rest>
+        void add_inputs(const I* values, const luint count, const Rest&... rest) {
+            input |= float_issues(values, count);
+            add_inputs(rest...);
+        }
+
+      public:
+        /**
+         * @param operation The name of the operation
+         * @param output The output array (nullptr if it isn't floating point)
+         * @param count The number of values in the output
+         * @param inputs Pairs of input arrays and numbers of values
+         */
+        template<typename U, typename... Inputs>
+        float_check_scope(const char* operation, const U* output, const luint count, const Inputs&... inputs)
+            : operation(operation), output(output), output_count(output == nullptr ? 0 : count), output_issues(&issues_of<U>) {
+            add_inputs(inputs...);
+        }
+
+        float_check_scope(const float_check_scope&) = delete;
+        float_check_scope& operator=(const float_check_scope&) = delete;
+
+        ~float_check_scope() noexcept(false) {
+            const uint32 out = output_issues(output, output_count);
+            if ((input | out) == 0)
+                return;
+            auto& state = float_check_state::instance();
+            for (uint32 k = 0; k < 3; k++) {
+                if (input & (1u << k))
+                    state.counts[0][k].fetch_add(1, std::memory_order_relaxed);
+                if (out & (1u << k))
+                    state.counts[1][k].fetch_add(1, std::memory_order_relaxed);
+            }
+            const float_check_handler handler = state.handler.load(std::memory_order_relaxed);
+            if (handler != nullptr && std::uncaught_exceptions() == 0)
+                handler(float_issue_report{operation, input, out});
+        }
+    };
+
+#define MGMATH_CHECK_FLOATS_SCOPE(...) const ::mgm::float_check_scope mgmath_float_check(__VA_ARGS__)
+#else
+#define MGMATH_CHECK_FLOATS_SCOPE(...) ((void)0)
+#endif
+
+
+    //=========
+    // VECTORS
+    //=========
+
     template<typename T>
     constexpr inline T min(const T& _a, const T& _b) {
         return (_a > _b ? _b : _a);
@@ -84,143 +635,912 @@ namespace mgm {
         return lerp(_a, static_cast<T>(_b), static_cast<T>(_factor));
     }
 
+    /**
+     * @brief Multiply two values and add a third `a * b + c`, rounding only once for floating point types (slow if the target has no hardware FMA)
+     */
+    template<typename T>
+    inline T fma(const T& _a, const T& _b, const T& _c) {
+        if constexpr (std::is_floating_point_v<T>)
+            return std::fma(_a, _b, _c);
+        else
+            return _a * _b + _c;
+    }
 
-    template<luint S, typename T>
-    class vec_storage {
-      public:
-        T _data[S];
-
-        template<ASSURE_SIZE(1)>
-        T& _x() { return _data[0]; }
-        template<ASSURE_SIZE(2)>
-        T& _y() { return _data[1]; }
-        template<ASSURE_SIZE(3)>
-        T& _z() { return _data[2]; }
-        template<ASSURE_SIZE(4)>
-        T& _w() { return _data[3]; }
-
-        template<ASSURE_SIZE(1)>
-        const T& _x() const { return _data[0]; }
-        template<ASSURE_SIZE(2)>
-        const T& _y() const { return _data[1]; }
-        template<ASSURE_SIZE(3)>
-        const T& _z() const { return _data[2]; }
-        template<ASSURE_SIZE(4)>
-        const T& _w() const { return _data[3]; }
-
-        T& operator[](const luint i) {
-#if !defined(NDEBUG)
-            if (i > S)
-                throw std::runtime_error{"Index out of range"};
-#endif
-            return _data[i];
-        }
-        const T& operator[](const luint i) const {
-#if !defined(NDEBUG)
-            if (i > S)
-                throw std::runtime_error{"Index out of range"};
+    /**
+     * @brief Multiply two values and add a third `a * b + c`, fused into a single instruction only if the target has hardware FMA
+     *
+     * Always fast, but the last bit of the result may differ between targets. Use fma when the single rounding is required
+     */
+    template<typename T>
+    inline T mad(const T& _a, const T& _b, const T& _c) {
+#if defined(MGMATH_FMA)
+        if constexpr (std::is_floating_point_v<T>)
+            return std::fma(_a, _b, _c);
+        else
 #endif
-            return _data[i];
-        }
-
-        vec_storage(const T& k = T{})
-            : _data(k) {}
+            return _a * _b + _c;
+    }
 
-        template<typename... Ts>
-        vec_storage(Ts&&... args)
-            : _data(std::forward<Ts>(args)...) {}
 
-        vec_storage(const vec_storage&) = default;
-        vec_storage(vec_storage&&) = default;
-        vec_storage& operator=(const vec_storage&) = default;
-        vec_storage& operator=(vec_storage&&) = default;
+    // Vectors with more components than this use loops (vectorized explicitly when MGMATH_SIMD is defined)
+    // instead of fully unrolled operations
+#if !defined(MGMATH_UNROLL_LIMIT)
+#define MGMATH_UNROLL_LIMIT 16
+#endif
 
-        T* data() { return _data; }
-        const T* data() const { return _data; }
+    enum class vec_op : uint8 {
+        add,
+        sub,
+        mul,
+        div,
+        mod,
+        min,
+        max,
+        bit_and,
+        bit_or,
+        bit_xor,
+        shift_left,
+        shift_right,
+        less,
+        greater,
+        equal,
+        add_saturated,
+        sub_saturated
     };
 
-    template<typename T>
-    class vec_storage<4, T> {
-      public:
-        T x{}, y{}, z{}, w{};
+#if defined(MGMATH_CHECK_FLOATS)
+    static constexpr const char* vec_op_names[] = {
+        "vec_add", "vec_sub", "vec_mul", "vec_div", "vec_mod", "vec_min", "vec_max", "vec_and", "vec_or", "vec_xor",
+        "vec_shift_left", "vec_shift_right", "vec_less", "vec_greater", "vec_equal", "vec_add_saturated", "vec_sub_saturated",
+    };
+#endif
 
-        T& _x() { return x; }
-        T& _y() { return y; }
-        T& _z() { return z; }
-        T& _w() { return w; }
+    template<vec_op Op, typename T>
+    inline T apply_vec_op(const T& a, const T& b) {
+        if constexpr (Op == vec_op::add) return a + b;
+        else if constexpr (Op == vec_op::sub) return a - b;
+        else if constexpr (Op == vec_op::mul) return a * b;
+        else if constexpr (Op == vec_op::div) return a / b;
+        else if constexpr (Op == vec_op::mod) return a % b;
+        else if constexpr (Op == vec_op::min) return a < b ? a : b;
+        else if constexpr (Op == vec_op::max) return a > b ? a : b;
+        else if constexpr (Op == vec_op::bit_and) return a & b;
+        else if constexpr (Op == vec_op::bit_or) return a | b;
+        else if constexpr (Op == vec_op::bit_xor) return a ^ b;
+        else if constexpr (Op == vec_op::shift_left) return a << b;
+        else if constexpr (Op == vec_op::shift_right) return a >> b;
+        else if constexpr (Op == vec_op::less) return a < b ? static_cast<T>(~T(0)) : T(0);
+        else if constexpr (Op == vec_op::greater) return a > b ? static_cast<T>(~T(0)) : T(0);
+        else if constexpr (Op == vec_op::equal) return a == b ? static_cast<T>(~T(0)) : T(0);
+        else if constexpr (Op == vec_op::add_saturated) {
+            if constexpr (std::is_unsigned_v<T>)
+                return a > std::numeric_limits<T>::max() - b ? std::numeric_limits<T>::max() : T(a + b);
+            else if (b > 0 && a > std::numeric_limits<T>::max() - b)
+                return std::numeric_limits<T>::max();
+            else if (b < 0 && a < std::numeric_limits<T>::min() - b)
+                return std::numeric_limits<T>::min();
+            else
+                return a + b;
+        }
+        else {
+            if constexpr (std::is_unsigned_v<T>)
+                return a < b ? T(0) : T(a - b);
+            else if (b < 0 && a > std::numeric_limits<T>::max() + b)
+                return std::numeric_limits<T>::max();
+            else if (b > 0 && a < std::numeric_limits<T>::min() + b)
+                return std::numeric_limits<T>::min();
+            else
+                return a - b;
+        }
+    }
 
-        const T& _x() const { return x; }
-        const T& _y() const { return y; }
-        const T& _z() const { return z; }
-        const T& _w() const { return w; }
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+    template<vec_op Op>
+    inline __m128 apply_vec_op(const __m128 a, const __m128 b) {
+        if constexpr (Op == vec_op::add) return _mm_add_ps(a, b);
+        else if constexpr (Op == vec_op::sub) return _mm_sub_ps(a, b);
+        else if constexpr (Op == vec_op::mul) return _mm_mul_ps(a, b);
+        else if constexpr (Op == vec_op::div) return _mm_div_ps(a, b);
+        else if constexpr (Op == vec_op::min) return _mm_min_ps(a, b);
+        else return _mm_max_ps(a, b);
+    }
+    template<vec_op Op>
+    inline __m128d apply_vec_op(const __m128d a, const __m128d b) {
+        if constexpr (Op == vec_op::add) return _mm_add_pd(a, b);
+        else if constexpr (Op == vec_op::sub) return _mm_sub_pd(a, b);
+        else if constexpr (Op == vec_op::mul) return _mm_mul_pd(a, b);
+        else if constexpr (Op == vec_op::div) return _mm_div_pd(a, b);
+        else if constexpr (Op == vec_op::min) return _mm_min_pd(a, b);
+        else return _mm_max_pd(a, b);
+    }
+#if defined(__AVX__)
+    template<vec_op Op>
+    inline __m256 apply_vec_op(const __m256 a, const __m256 b) {
+        if constexpr (Op == vec_op::add) return _mm256_add_ps(a, b);
+        else if constexpr (Op == vec_op::sub) return _mm256_sub_ps(a, b);
+        else if constexpr (Op == vec_op::mul) return _mm256_mul_ps(a, b);
+        else if constexpr (Op == vec_op::div) return _mm256_div_ps(a, b);
+        else if constexpr (Op == vec_op::min) return _mm256_min_ps(a, b);
+        else return _mm256_max_ps(a, b);
+    }
+    template<vec_op Op>
+    inline __m256d apply_vec_op(const __m256d a, const __m256d b) {
+        if constexpr (Op == vec_op::add) return _mm256_add_pd(a, b);
+        else if constexpr (Op == vec_op::sub) return _mm256_sub_pd(a, b);
+        else if constexpr (Op == vec_op::mul) return _mm256_mul_pd(a, b);
+        else if constexpr (Op == vec_op::div) return _mm256_div_pd(a, b);
+        else if constexpr (Op == vec_op::min) return _mm256_min_pd(a, b);
+        else return _mm256_max_pd(a, b);
+    }
+#endif
 
-        T& operator[](const luint i) {
-            switch (i) {
-                case 0: return x;
-                case 1: return y;
-                case 2: return z;
-                case 3: return w;
-                default:
-#if !defined(NDEBUG)
-                    throw std::runtime_error{"Index out of range"};
+    /**
+     * @brief Multiply two registers and add a third, in a single fused instruction if the target has FMA
+     */
+    inline __m128 simd_mad(const __m128 a, const __m128 b, const __m128 c) {
+#if defined(MGMATH_FMA)
+        return _mm_fmadd_ps(a, b, c);
 #else
-                    return x;
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
 #endif
-            }
-        }
-        const T& operator[](const luint i) const {
-            switch (i) {
-                case 0: return x;
-                case 1: return y;
-                case 2: return z;
-                case 3: return w;
-                default:
-#if !defined(NDEBUG)
-                    throw std::runtime_error{"Index out of range"};
+    }
+    inline __m128d simd_mad(const __m128d a, const __m128d b, const __m128d c) {
+#if defined(MGMATH_FMA)
+        return _mm_fmadd_pd(a, b, c);
 #else
-                    return x;
+        return _mm_add_pd(_mm_mul_pd(a, b), c);
+#endif
+    }
+#if defined(__AVX__)
+    inline __m256 simd_mad(const __m256 a, const __m256 b, const __m256 c) {
+#if defined(MGMATH_FMA)
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+    inline __m256d simd_mad(const __m256d a, const __m256d b, const __m256d c) {
+#if defined(MGMATH_FMA)
+        return _mm256_fmadd_pd(a, b, c);
+#else
+        return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+    }
 #endif
-            }
-        }
 
-        vec_storage(const T& k = T{})
-            : x(k),
-              y(k),
-              z(k),
-              w(k) {}
+    inline float horizontal_sum(const __m128 v) {
+        const __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+    }
+    inline double horizontal_sum(const __m128d v) {
+        return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+    }
 
-        vec_storage(const T& x_v, const T& y_v, const T& z_v = 0, const T& w_v = 0)
-            : x(x_v),
-              y(y_v),
-              z(z_v),
-              w(w_v) {}
+    /**
+     * @brief Load the first Bytes bytes of a register (2, 3, 4, 6, 8, 12 or 16), without reading past them, zeroing the others
+     */
+    template<luint Bytes>
+    inline __m128i simd_load_bytes(const void* src) {
+        const char* p = static_cast<const char*>(src);
+        if constexpr (Bytes == 16)
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        else if constexpr (Bytes == 12)
+            return _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), simd_load_bytes<4>(p + 8));
+        else if constexpr (Bytes == 8)
+            return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        else if constexpr (Bytes == 6) {
+            uint16 high;
+            memcpy(&high, p + 4, sizeof(high));
+            return _mm_insert_epi16(simd_load_bytes<4>(p), high, 2);
+        }
+        else {
+            static_assert(Bytes >= 2 && Bytes <= 4, "Unsupported load size");
+            int32 bits = 0;
+            memcpy(&bits, p, Bytes);
+            return _mm_cvtsi32_si128(bits);
+        }
+    }
+
+    /**
+     * @brief Store the first Bytes bytes of a register (2, 3, 4, 6, 8, 12 or 16), without writing past them
+     */
+    template<luint Bytes>
+    inline void simd_store_bytes(void* dst, const __m128i v) {
+        char* p = static_cast<char*>(dst);
+        if constexpr (Bytes == 16)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+        else if constexpr (Bytes == 12) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), v);
+            simd_store_bytes<4>(p + 8, _mm_srli_si128(v, 8));
+        }
+        else if constexpr (Bytes == 8)
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), v);
+        else if constexpr (Bytes == 6) {
+            simd_store_bytes<4>(p, v);
+            const uint16 high = static_cast<uint16>(_mm_extract_epi16(v, 2));
+            memcpy(p + 4, &high, sizeof(high));
+        }
+        else {
+            static_assert(Bytes >= 2 && Bytes <= 4, "Unsupported store size");
+            const int32 bits = _mm_cvtsi128_si32(v);
+            memcpy(p, &bits, Bytes);
+        }
+    }
+
+    /**
+     * @brief Load S integers (S from 2 to 4, up to 32 bits wide) into the 32-bit lanes of a register, sign or zero
+     * extending them, with zeros in the lanes past S
+     */
+    template<luint S, typename T>
+    inline __m128i simd_load_widened_int4(const T* src) {
+        const __m128i v = simd_load_bytes<S * sizeof(T)>(src);
+        if constexpr (sizeof(T) == 4)
+            return v;
+        else if constexpr (sizeof(T) == 2) {
+            if constexpr (std::is_signed_v<T>)
+                return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            else
+                return _mm_unpacklo_epi16(v, _mm_setzero_si128());
+        }
+        else {
+            if constexpr (std::is_signed_v<T>) {
+                const __m128i v16 = _mm_unpacklo_epi8(v, v);
+                return _mm_srai_epi32(_mm_unpacklo_epi16(v16, v16), 24);
+            }
+            else
+                return _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, _mm_setzero_si128()), _mm_setzero_si128());
+        }
+    }
+
+    /**
+     * @brief Store the first S 32-bit lanes of a register as integers, truncating them the same way a cast would
+     */
+    template<luint S, typename T>
+    inline void simd_store_narrowed_int4(T* dst, const __m128i v) {
+        if constexpr (sizeof(T) == 4)
+            simd_store_bytes<S * sizeof(T)>(dst, v);
+        else if constexpr (sizeof(T) == 2) {
+            // Sign extending the low bits first means the saturating pack never actually saturates
+            const __m128i low = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+            simd_store_bytes<S * sizeof(T)>(dst, _mm_packs_epi32(low, low));
+        }
+        else {
+            const __m128i low = _mm_srai_epi32(_mm_slli_epi32(v, 24), 24);
+            const __m128i low16 = _mm_packs_epi32(low, low);
+            simd_store_bytes<S * sizeof(T)>(dst, _mm_packs_epi16(low16, low16));
+        }
+    }
+
+    /**
+     * @brief Load S integers (S from 2 to 4, up to 32 bits wide) into the low bytes of a register, as they are
+     */
+    template<luint S, typename T>
+    inline __m128i simd_load_packed_int4(const T* src) {
+        return simd_load_bytes<S * sizeof(T)>(src);
+    }
+
+    /**
+     * @brief Store S integers from the low bytes of a register, as they are
+     */
+    template<luint S, typename T>
+    inline void simd_store_packed_int4(T* dst, const __m128i v) {
+        simd_store_bytes<S * sizeof(T)>(dst, v);
+    }
+
+    inline __m128i simd_select(const __m128i mask, const __m128i a, const __m128i b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    inline __m128i simd_mullo_epi32(const __m128i a, const __m128i b) {
+#if defined(MGMATH_SSE4_1)
+        return _mm_mullo_epi32(a, b);
+#else
+        const __m128i even = _mm_mul_epu32(a, b);
+        const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+    }
+
+    /**
+     * @brief Compare the 32-bit lanes of two registers holding widened T values, with the signedness of T
+     */
+    template<typename T>
+    inline __m128i simd_cmpgt_int4(const __m128i a, const __m128i b) {
+        if constexpr (sizeof(T) == 4 && std::is_unsigned_v<T>) {
+            const __m128i bias = _mm_set1_epi32(std::numeric_limits<int32>::min());
+            return _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+        }
+        else
+            return _mm_cmpgt_epi32(a, b);
+    }
+
+    /**
+     * @brief Convert two of the 32-bit lanes of a register holding widened T values to doubles (exact for every 32-bit value)
+     */
+    template<typename T, bool High>
+    inline __m128d simd_int4_half_to_pd(const __m128i v) {
+        const __m128i half = High ? _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)) : v;
+        if constexpr (sizeof(T) == 4 && std::is_unsigned_v<T>)
+            return _mm_add_pd(_mm_cvtepi32_pd(_mm_xor_si128(half, _mm_set1_epi32(std::numeric_limits<int32>::min()))), _mm_set1_pd(2147483648.0));
+        else
+            return _mm_cvtepi32_pd(half);
+    }
+
+    /**
+     * @brief Truncate two pairs of doubles back to the 32-bit lanes of one register, as T values
+     */
+    template<typename T>
+    inline __m128i simd_pd_to_int4(const __m128d lo, const __m128d hi) {
+        if constexpr (sizeof(T) == 4 && std::is_unsigned_v<T>) {
+            // Biased values below zero need to be rounded down to truncate the unbiased ones
+            const auto floor_half = [](const __m128d v) {
+                const __m128i t = _mm_cvttpd_epi32(v);
+                const __m128d over = _mm_cmpgt_pd(_mm_cvtepi32_pd(t), v);
+                return _mm_add_epi32(t, _mm_shuffle_epi32(_mm_castpd_si128(over), _MM_SHUFFLE(3, 1, 2, 0)));
+            };
+            const __m128d bias = _mm_set1_pd(2147483648.0);
+            const __m128i v = _mm_unpacklo_epi64(floor_half(_mm_sub_pd(lo, bias)), floor_half(_mm_sub_pd(hi, bias)));
+            return _mm_xor_si128(v, _mm_set1_epi32(std::numeric_limits<int32>::min()));
+        }
+        else
+            return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+    }
+
+    /**
+     * @brief Saturating addition or subtraction of the 8 or 16-bit integers packed in two registers
+     */
+    template<vec_op Op, typename T>
+    inline __m128i simd_saturated(const __m128i a, const __m128i b) {
+        if constexpr (Op == vec_op::add_saturated) {
+            if constexpr (sizeof(T) == 1) return std::is_signed_v<T> ? _mm_adds_epi8(a, b) : _mm_adds_epu8(a, b);
+            else return std::is_signed_v<T> ? _mm_adds_epi16(a, b) : _mm_adds_epu16(a, b);
+        }
+        else {
+            if constexpr (sizeof(T) == 1) return std::is_signed_v<T> ? _mm_subs_epi8(a, b) : _mm_subs_epu8(a, b);
+            else return std::is_signed_v<T> ? _mm_subs_epi16(a, b) : _mm_subs_epu16(a, b);
+        }
+    }
+#if defined(__AVX2__)
+    template<vec_op Op, typename T>
+    inline __m256i simd_saturated(const __m256i a, const __m256i b) {
+        if constexpr (Op == vec_op::add_saturated) {
+            if constexpr (sizeof(T) == 1) return std::is_signed_v<T> ? _mm256_adds_epi8(a, b) : _mm256_adds_epu8(a, b);
+            else return std::is_signed_v<T> ? _mm256_adds_epi16(a, b) : _mm256_adds_epu16(a, b);
+        }
+        else {
+            if constexpr (sizeof(T) == 1) return std::is_signed_v<T> ? _mm256_subs_epi8(a, b) : _mm256_subs_epu8(a, b);
+            else return std::is_signed_v<T> ? _mm256_subs_epi16(a, b) : _mm256_subs_epu16(a, b);
+        }
+    }
+#endif
+
+    /**
+     * @brief Apply an arithmetic operation (not modulus) to two double vectors of 2 to 4 components
+     */
+    template<vec_op Op, luint S>
+    inline void simd_pd_apply(const double* a, const double* b, double* r) {
+        if constexpr (S == 2)
+            _mm_storeu_pd(r, apply_vec_op<Op>(_mm_loadu_pd(a), _mm_loadu_pd(b)));
+        else if constexpr (S == 3) {
+            _mm_storeu_pd(r, apply_vec_op<Op>(_mm_loadu_pd(a), _mm_loadu_pd(b)));
+            _mm_store_sd(r + 2, apply_vec_op<Op>(_mm_load_sd(a + 2), _mm_load_sd(b + 2)));
+        }
+        else {
+#if defined(__AVX__)
+            _mm256_storeu_pd(r, apply_vec_op<Op>(_mm256_loadu_pd(a), _mm256_loadu_pd(b)));
+#else
+            _mm_storeu_pd(r, apply_vec_op<Op>(_mm_loadu_pd(a), _mm_loadu_pd(b)));
+            _mm_storeu_pd(r + 2, apply_vec_op<Op>(_mm_loadu_pd(a + 2), _mm_loadu_pd(b + 2)));
+#endif
+        }
+    }
+
+    /**
+     * @brief Dot product of two double vectors of 2 to 4 components
+     */
+    template<luint S>
+    inline double simd_pd_dot(const double* a, const double* b) {
+        const __m128d lo = _mm_mul_pd(_mm_loadu_pd(a), _mm_loadu_pd(b));
+        if constexpr (S == 2)
+            return horizontal_sum(lo);
+        else if constexpr (S == 3)
+            return horizontal_sum(simd_mad(_mm_load_sd(a + 2), _mm_load_sd(b + 2), lo));
+        else
+            return horizontal_sum(simd_mad(_mm_loadu_pd(a + 2), _mm_loadu_pd(b + 2), lo));
+    }
+
+    /**
+     * @brief Load a float vector of 2 to 4 components into a register, with the unused lanes set to zero
+     */
+    template<luint S>
+    inline __m128 simd_load_ps(const float* src) {
+        if constexpr (S == 2)
+            return _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src));
+        else if constexpr (S == 3)
+            return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src)), _mm_load_ss(src + 2));
+        else
+            return _mm_loadu_ps(src);
+    }
+
+    /**
+     * @brief Store the first 2 to 4 lanes of a register
+     */
+    template<luint S>
+    inline void simd_store_ps(float* dst, const __m128 v) {
+        if constexpr (S == 2)
+            _mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+        else if constexpr (S == 3) {
+            _mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+            _mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+        }
+        else
+            _mm_storeu_ps(dst, v);
+    }
+
+    /**
+     * @brief Dot product of the first S lanes of two registers (the rest must be zero in at least one of them), in every lane of the result
+     */
+    template<luint S>
+    inline __m128 simd_dot_ps(const __m128 a, const __m128 b) {
+#if defined(MGMATH_SSE4_1)
+        return _mm_dp_ps(a, b, ((1 << S) - 1) << 4 | 0x0F);
+#else
+        const __m128 m = _mm_mul_ps(a, b);
+        const __m128 pairs = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2)));
+#endif
+    }
+
+    /**
+     * @brief Reduce the first S lanes of a register to their minimum or maximum, in every lane of the result
+     */
+    template<vec_op Op, luint S>
+    inline __m128 simd_reduce_ps(__m128 v) {
+        if constexpr (S == 2)
+            v = _mm_unpacklo_ps(v, v);
+        else if constexpr (S == 3)
+            v = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 1, 0));
+        v = apply_vec_op<Op>(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return apply_vec_op<Op>(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+
+    /**
+     * @brief Divide the lanes of a register by the square root of the lanes of another
+     *
+     * By default this is a full square root and division. With MGMATH_FAST_RSQRT defined, it multiplies by the
+     * approximate reciprocal square root instead, refined with one Newton-Raphson step (relative error below 4e-7)
+     */
+    inline __m128 simd_div_sqrt_ps(const __m128 v, const __m128 d) {
+#if defined(MGMATH_FAST_RSQRT)
+        const __m128 r = _mm_rsqrt_ps(d);
+        const __m128 refined = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(d, r), r)));
+        return _mm_mul_ps(v, refined);
+#else
+        return _mm_div_ps(v, _mm_sqrt_ps(d));
+#endif
+    }
+
+    /**
+     * @brief Multiply two row major 4x4 double matrices, every line of the result being a sum of the lines of b, scaled by the components of the same line of a
+     */
+    inline void simd_mat4d_mul(const double* a, const double* b, double* r) {
+#if defined(__AVX__)
+        const __m256d b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b + 4), b2 = _mm256_loadu_pd(b + 8), b3 = _mm256_loadu_pd(b + 12);
+        for (luint i = 0; i < 4; i++) {
+            const double* line = a + i * 4;
+            __m256d res = _mm256_mul_pd(_mm256_broadcast_sd(line), b0);
+            res = simd_mad(_mm256_broadcast_sd(line + 1), b1, res);
+            res = simd_mad(_mm256_broadcast_sd(line + 2), b2, res);
+            res = simd_mad(_mm256_broadcast_sd(line + 3), b3, res);
+            _mm256_storeu_pd(r + i * 4, res);
+        }
+#else
+        for (luint i = 0; i < 4; i++) {
+            const double* line = a + i * 4;
+            __m128d lo = _mm_setzero_pd(), hi = _mm_setzero_pd();
+            for (luint k = 0; k < 4; k++) {
+                const __m128d s = _mm_set1_pd(line[k]);
+                lo = simd_mad(s, _mm_loadu_pd(b + k * 4), lo);
+                hi = simd_mad(s, _mm_loadu_pd(b + k * 4 + 2), hi);
+            }
+            _mm_storeu_pd(r + i * 4, lo);
+            _mm_storeu_pd(r + i * 4 + 2, hi);
+        }
+#endif
+    }
+
+    /**
+     * @brief Transpose a 4x4 float matrix (src and dst can be the same)
+     */
+    inline void simd_transpose_mat4f(const float* src, float* dst) {
+        __m128 r0 = _mm_loadu_ps(src), r1 = _mm_loadu_ps(src + 4), r2 = _mm_loadu_ps(src + 8), r3 = _mm_loadu_ps(src + 12);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(dst, r0);
+        _mm_storeu_ps(dst + 4, r1);
+        _mm_storeu_ps(dst + 8, r2);
+        _mm_storeu_ps(dst + 12, r3);
+    }
+
+    /**
+     * @brief Check if an operation on S component vectors of T has an integer SIMD kernel
+     *
+     * Vectors of 2 or 3 components narrower than 32 bits take several instructions to load and store, which is only
+     * worth it for division and modulus, every other operation is faster on the components
+     */
+    template<vec_op Op, typename T, luint S>
+    constexpr bool simd_int4_supports() {
+        if constexpr (!std::is_integral_v<T> || std::is_same_v<T, bool> || sizeof(T) > 4 || S < 2 || S > 4)
+            return false;
+        else if constexpr (S < 4 && sizeof(T) < 4 && Op != vec_op::div && Op != vec_op::mod)
+            return false;
+        else
+            return (Op != vec_op::add_saturated && Op != vec_op::sub_saturated) || sizeof(T) <= 2;
+    }
+
+    /**
+     * @brief Apply an operation to two integer vectors of S components (2 to 4), with the same results as the scalar operators
+     *
+     * Smaller vectors are loaded with zeros in the lanes past S, which are never stored. Components are either processed at their own width, or widened to 32 bits (multiplication, comparisons, shifts),
+     * then truncated back. Division and modulus go through float for 8 and 16-bit components, and through double for
+     * 32-bit ones, which is exact, since the truncated quotient of two integers can't be rounded to the next integer
+     * when the dividend has fewer bits than the mantissa
+     */
+    template<vec_op Op, luint S, typename T>
+    inline void simd_int4_apply(const T* a, const T* b, T* r) {
+        constexpr luint bits = sizeof(T) * 8;
+        if constexpr (Op == vec_op::bit_and || Op == vec_op::bit_or || Op == vec_op::bit_xor || Op == vec_op::add || Op == vec_op::sub
+                      || Op == vec_op::equal || Op == vec_op::add_saturated || Op == vec_op::sub_saturated || (Op == vec_op::mul && bits == 16)) {
+            const __m128i x = simd_load_packed_int4<S>(a), y = simd_load_packed_int4<S>(b);
+            __m128i res;
+            if constexpr (Op == vec_op::bit_and) res = _mm_and_si128(x, y);
+            else if constexpr (Op == vec_op::bit_or) res = _mm_or_si128(x, y);
+            else if constexpr (Op == vec_op::bit_xor) res = _mm_xor_si128(x, y);
+            else if constexpr (Op == vec_op::mul) res = _mm_mullo_epi16(x, y);
+            else if constexpr (bits == 8) {
+                if constexpr (Op == vec_op::add) res = _mm_add_epi8(x, y);
+                else if constexpr (Op == vec_op::sub) res = _mm_sub_epi8(x, y);
+                else if constexpr (Op == vec_op::equal) res = _mm_cmpeq_epi8(x, y);
+                else res = simd_saturated<Op, T>(x, y);
+            }
+            else if constexpr (bits == 16) {
+                if constexpr (Op == vec_op::add) res = _mm_add_epi16(x, y);
+                else if constexpr (Op == vec_op::sub) res = _mm_sub_epi16(x, y);
+                else if constexpr (Op == vec_op::equal) res = _mm_cmpeq_epi16(x, y);
+                else res = simd_saturated<Op, T>(x, y);
+            }
+            else {
+                if constexpr (Op == vec_op::add) res = _mm_add_epi32(x, y);
+                else if constexpr (Op == vec_op::sub) res = _mm_sub_epi32(x, y);
+                else res = _mm_cmpeq_epi32(x, y);
+            }
+            simd_store_packed_int4<S>(r, res);
+        }
+        else {
+            const __m128i x = simd_load_widened_int4<S>(a), y = simd_load_widened_int4<S>(b);
+            __m128i res;
+            if constexpr (Op == vec_op::mul) res = simd_mullo_epi32(x, y);
+            else if constexpr (Op == vec_op::less) res = simd_cmpgt_int4<T>(y, x);
+            else if constexpr (Op == vec_op::greater) res = simd_cmpgt_int4<T>(x, y);
+            else if constexpr (Op == vec_op::min || Op == vec_op::max) {
+#if defined(MGMATH_SSE4_1)
+                if constexpr (sizeof(T) == 4 && std::is_unsigned_v<T>)
+                    res = Op == vec_op::min ? _mm_min_epu32(x, y) : _mm_max_epu32(x, y);
+                else
+                    res = Op == vec_op::min ? _mm_min_epi32(x, y) : _mm_max_epi32(x, y);
+#else
+                const __m128i gt = simd_cmpgt_int4<T>(x, y);
+                res = Op == vec_op::min ? simd_select(gt, y, x) : simd_select(gt, x, y);
+#endif
+            }
+            else if constexpr (Op == vec_op::shift_left)
+                res = _mm_sll_epi32(x, _mm_cvtsi32_si128(static_cast<int32>(b[0])));
+            else if constexpr (Op == vec_op::shift_right) {
+                if constexpr (std::is_signed_v<T>)
+                    res = _mm_sra_epi32(x, _mm_cvtsi32_si128(static_cast<int32>(b[0])));
+                else
+                    res = _mm_srl_epi32(x, _mm_cvtsi32_si128(static_cast<int32>(b[0])));
+            }
+            else if constexpr (bits < 32) {
+                const __m128 fx = _mm_cvtepi32_ps(x), fy = _mm_cvtepi32_ps(y);
+                const __m128i q = _mm_cvttps_epi32(_mm_div_ps(fx, fy));
+                if constexpr (Op == vec_op::div)
+                    res = q;
+                else
+                    res = _mm_cvttps_epi32(_mm_sub_ps(fx, _mm_mul_ps(_mm_cvtepi32_ps(q), fy)));
+            }
+            else {
+                const __m128d xl = simd_int4_half_to_pd<T, false>(x), xh = simd_int4_half_to_pd<T, true>(x);
+                const __m128d yl = simd_int4_half_to_pd<T, false>(y), yh = simd_int4_half_to_pd<T, true>(y);
+                const __m128i q = simd_pd_to_int4<T>(_mm_div_pd(xl, yl), _mm_div_pd(xh, yh));
+                if constexpr (Op == vec_op::div)
+                    res = q;
+                else {
+                    const __m128d ql = simd_int4_half_to_pd<T, false>(q), qh = simd_int4_half_to_pd<T, true>(q);
+                    res = simd_pd_to_int4<T>(_mm_sub_pd(xl, _mm_mul_pd(ql, yl)), _mm_sub_pd(xh, _mm_mul_pd(qh, yh)));
+                }
+            }
+            simd_store_narrowed_int4<S>(r, res);
+        }
+    }
+#endif
+
+    /**
+     * @brief Apply an operation to every pair of components of two arrays, using SIMD for float and double
+     */
+    template<vec_op Op, luint N, typename T>
+    inline void vec_loop(const T* a, const T* b, T* r) {
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+        if constexpr (std::is_same_v<T, float> && Op <= vec_op::max && Op != vec_op::mod) {
+            constexpr luint body = N / 4 * 4;
+#if defined(__AVX__)
+            for (; i + 8 <= body; i += 8)
+                _mm256_storeu_ps(r + i, apply_vec_op<Op>(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+#endif
+            for (; i < body; i += 4)
+                _mm_storeu_ps(r + i, apply_vec_op<Op>(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            for (luint j = body; j < N; j++)
+                r[j] = apply_vec_op<Op>(a[j], b[j]);
+            return;
+        }
+        else if constexpr (std::is_same_v<T, double> && Op <= vec_op::max && Op != vec_op::mod) {
+            constexpr luint body = N / 2 * 2;
+#if defined(__AVX__)
+            for (; i + 4 <= body; i += 4)
+                _mm256_storeu_pd(r + i, apply_vec_op<Op>(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+#endif
+            for (; i < body; i += 2)
+                _mm_storeu_pd(r + i, apply_vec_op<Op>(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            for (luint j = body; j < N; j++)
+                r[j] = apply_vec_op<Op>(a[j], b[j]);
+            return;
+        }
+#endif
+        for (; i < N; i++)
+            r[i] = apply_vec_op<Op>(a[i], b[i]);
+    }
+
+    /**
+     * @brief Dot product of two arrays, using SIMD for float and double
+     */
+    template<luint N, typename T>
+    inline T dot_loop(const T* a, const T* b) {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+        if constexpr (std::is_same_v<T, float>) {
+            constexpr luint body = N / 4 * 4;
+            luint i = 0;
+            __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+            for (; i + 8 <= body; i += 8) {
+                acc0 = simd_mad(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i), acc0);
+                acc1 = simd_mad(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4), acc1);
+            }
+            for (; i < body; i += 4)
+                acc0 = simd_mad(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i), acc0);
+            float sum = horizontal_sum(_mm_add_ps(acc0, acc1));
+            for (luint j = body; j < N; j++)
+                sum = mad(a[j], b[j], sum);
+            return sum;
+        }
+        else if constexpr (std::is_same_v<T, double>) {
+            constexpr luint body = N / 2 * 2;
+            luint i = 0;
+            __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+            for (; i + 4 <= body; i += 4) {
+                acc0 = simd_mad(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i), acc0);
+                acc1 = simd_mad(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2), acc1);
+            }
+            for (; i < body; i += 2)
+                acc0 = simd_mad(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i), acc0);
+            double sum = horizontal_sum(_mm_add_pd(acc0, acc1));
+            for (luint j = body; j < N; j++)
+                sum = mad(a[j], b[j], sum);
+            return sum;
+        }
+#endif
+        T sum = T(0);
+        for (luint i = 0; i < N; i++)
+            sum = mad(a[i], b[i], sum);
+        return sum;
+    }
+
+    /**
+     * @brief Multiply two arrays and add a third, using SIMD for float and double
+     *
+     * @tparam Exact Round only once, even if the target has no hardware FMA
+     */
+    template<bool Exact, luint N, typename T>
+    inline void mad_loop(const T* a, const T* b, const T* c, T* r) {
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(MGMATH_FMA)
+        constexpr bool vectorize = true;
+#else
+        constexpr bool vectorize = !Exact;
+#endif
+        if constexpr (vectorize && std::is_same_v<T, float>) {
+            constexpr luint body = N / 4 * 4;
+#if defined(__AVX__)
+            for (; i + 8 <= body; i += 8)
+                _mm256_storeu_ps(r + i, simd_mad(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), _mm256_loadu_ps(c + i)));
+#endif
+            for (; i < body; i += 4)
+                _mm_storeu_ps(r + i, simd_mad(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i), _mm_loadu_ps(c + i)));
+            for (luint j = body; j < N; j++)
+                r[j] = mad(a[j], b[j], c[j]);
+            return;
+        }
+        else if constexpr (vectorize && std::is_same_v<T, double>) {
+            constexpr luint body = N / 2 * 2;
+#if defined(__AVX__)
+            for (; i + 4 <= body; i += 4)
+                _mm256_storeu_pd(r + i, simd_mad(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), _mm256_loadu_pd(c + i)));
+#endif
+            for (; i < body; i += 2)
+                _mm_storeu_pd(r + i, simd_mad(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i), _mm_loadu_pd(c + i)));
+            for (luint j = body; j < N; j++)
+                r[j] = mad(a[j], b[j], c[j]);
+            return;
+        }
+#endif
+        for (; i < N; i++)
+            r[i] = Exact ? fma(a[i], b[i], c[i]) : mad(a[i], b[i], c[i]);
+    }
+
+    /**
+     * @brief Saturating addition or subtraction of two arrays of integers, using SIMD for 8 and 16-bit integers
+     */
+    template<vec_op Op, typename T>
+    inline void saturated_loop(const T* a, const T* b, T* r, const luint n) {
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+        if constexpr (std::is_integral_v<T> && sizeof(T) <= 2) {
+#if defined(__AVX2__)
+            for (; i + 32 / sizeof(T) <= n; i += 32 / sizeof(T)) {
+                const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), simd_saturated<Op, T>(x, y));
+            }
+#endif
+            for (; i + 16 / sizeof(T) <= n; i += 16 / sizeof(T)) {
+                const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), simd_saturated<Op, T>(x, y));
+            }
+        }
+#endif
+        for (; i < n; i++)
+            r[i] = apply_vec_op<Op>(a[i], b[i]);
+    }
+
+
+#if defined(MGMATH_SWIZZLE)
+    template<luint S, typename T>
+    class vec;
+
+    template<luint S, typename T, luint... I>
+    class swizzle_ref;
+
+    // Named swizzles (`xy()`, `zyx()`, `wzwz()`...) are generated from the component letters below, and only declared
+    // on the storage of the sizes that have those components. They always return a new vector, writing through a
+    // swizzle is spelled explicitly with `ref<I...>()`. The vector is returned const, so `v.xz() = ...` doesn't compile
+    // instead of silently assigning to a copy
+#define MGMATH_SWIZZLE_INDEX_x 0
+#define MGMATH_SWIZZLE_INDEX_y 1
+#define MGMATH_SWIZZLE_INDEX_z 2
+#define MGMATH_SWIZZLE_INDEX_w 3
+#define MGMATH_SWIZZLE_GET(N, NAME, ...) \
+    const auto NAME() const { return static_cast<const vec<N, T>&>(*this).template swizzle<__VA_ARGS__>(); }
+#define MGMATH_SWIZZLE2(M, N, a, b) M(N, a##b, MGMATH_SWIZZLE_INDEX_##a, MGMATH_SWIZZLE_INDEX_##b)
+#define MGMATH_SWIZZLE3(M, N, a, b, c) M(N, a##b##c, MGMATH_SWIZZLE_INDEX_##a, MGMATH_SWIZZLE_INDEX_##b, MGMATH_SWIZZLE_INDEX_##c)
+#define MGMATH_SWIZZLE4(M, N, a, b, c, d) M(N, a##b##c##d, MGMATH_SWIZZLE_INDEX_##a, MGMATH_SWIZZLE_INDEX_##b, MGMATH_SWIZZLE_INDEX_##c, MGMATH_SWIZZLE_INDEX_##d)
+
+// The preprocessor doesn't expand a macro inside itself, so every letter position needs its own loop over the letters
+#define MGMATH_SWIZZLE_EACH_A_2(F, ...) F(__VA_ARGS__, x) F(__VA_ARGS__, y)
+#define MGMATH_SWIZZLE_EACH_B_2(F, ...) F(__VA_ARGS__, x) F(__VA_ARGS__, y)
+#define MGMATH_SWIZZLE_EACH_C_2(F, ...) F(__VA_ARGS__, x) F(__VA_ARGS__, y)
+#define MGMATH_SWIZZLE_EACH_D_2(F, ...) F(__VA_ARGS__, x) F(__VA_ARGS__, y)
+#define MGMATH_SWIZZLE_EACH_A_3(F, ...) MGMATH_SWIZZLE_EACH_A_2(F, __VA_ARGS__) F(__VA_ARGS__, z)
+#define MGMATH_SWIZZLE_EACH_B_3(F, ...) MGMATH_SWIZZLE_EACH_B_2(F, __VA_ARGS__) F(__VA_ARGS__, z)
+#define MGMATH_SWIZZLE_EACH_C_3(F, ...) MGMATH_SWIZZLE_EACH_C_2(F, __VA_ARGS__) F(__VA_ARGS__, z)
+#define MGMATH_SWIZZLE_EACH_D_3(F, ...) MGMATH_SWIZZLE_EACH_D_2(F, __VA_ARGS__) F(__VA_ARGS__, z)
+#define MGMATH_SWIZZLE_EACH_A_4(F, ...) MGMATH_SWIZZLE_EACH_A_3(F, __VA_ARGS__) F(__VA_ARGS__, w)
+#define MGMATH_SWIZZLE_EACH_B_4(F, ...) MGMATH_SWIZZLE_EACH_B_3(F, __VA_ARGS__) F(__VA_ARGS__, w)
+#define MGMATH_SWIZZLE_EACH_C_4(F, ...) MGMATH_SWIZZLE_EACH_C_3(F, __VA_ARGS__) F(__VA_ARGS__, w)
+#define MGMATH_SWIZZLE_EACH_D_4(F, ...) MGMATH_SWIZZLE_EACH_D_3(F, __VA_ARGS__) F(__VA_ARGS__, w)
+
+#define MGMATH_SWIZZLE_GET_FROM3(N, L, a, b, c) \
+    MGMATH_SWIZZLE3(MGMATH_SWIZZLE_GET, N, a, b, c) \
+    MGMATH_SWIZZLE_EACH_D_##L(MGMATH_SWIZZLE4, MGMATH_SWIZZLE_GET, N, a, b, c)
+#define MGMATH_SWIZZLE_GET_FROM2(N, L, a, b)    \
+    MGMATH_SWIZZLE2(MGMATH_SWIZZLE_GET, N, a, b) \
+    MGMATH_SWIZZLE_EACH_C_##L(MGMATH_SWIZZLE_GET_FROM3, N, L, a, b)
+#define MGMATH_SWIZZLE_GET_FROM1(N, L, a) MGMATH_SWIZZLE_EACH_B_##L(MGMATH_SWIZZLE_GET_FROM2, N, L, a)
+
+/// Declare every 2, 3 and 4 component swizzle of the first L letters of xyzw, for a vector of size N
+#define MGMATH_SWIZZLES(N, L) MGMATH_SWIZZLE_EACH_A_##L(MGMATH_SWIZZLE_GET_FROM1, N, L)
+#else
+#define MGMATH_SWIZZLES(N, L)
+#endif
+
+    template<luint S, typename T>
+    class vec_storage {
+      public:
+        T _data[S];
+
+        template<ASSURE_SIZE(1)>
+        T& _x() { return _data[0]; }
+        template<ASSURE_SIZE(2)>
+        T& _y() { return _data[1]; }
+        template<ASSURE_SIZE(3)>
+        T& _z() { return _data[2]; }
+        template<ASSURE_SIZE(4)>
+        T& _w() { return _data[3]; }
+
+        template<ASSURE_SIZE(1)>
+        const T& _x() const { return _data[0]; }
+        template<ASSURE_SIZE(2)>
+        const T& _y() const { return _data[1]; }
+        template<ASSURE_SIZE(3)>
+        const T& _z() const { return _data[2]; }
+        template<ASSURE_SIZE(4)>
+        const T& _w() const { return _data[3]; }
+
+        T& operator[](const luint i) {
+#if !defined(NDEBUG)
+            if (i > S)
+                throw std::runtime_error{"Index out of range"};
+#endif
+            return _data[i];
+        }
+        const T& operator[](const luint i) const {
+#if !defined(NDEBUG)
+            if (i > S)
+                throw std::runtime_error{"Index out of range"};
+#endif
+            return _data[i];
+        }
+
+        vec_storage(const T& k = T{}) {
+            for (luint i = 0; i < S; i++)
+                _data[i] = k;
+        }
+
+        template<typename... Ts>
+        vec_storage(Ts&&... args)
+            : _data(std::forward<Ts>(args)...) {}
 
         vec_storage(const vec_storage&) = default;
         vec_storage(vec_storage&&) = default;
         vec_storage& operator=(const vec_storage&) = default;
         vec_storage& operator=(vec_storage&&) = default;
 
-        T* data() { return (T*)this; }
-        const T* data() const { return (const T*)this; }
+        MGMATH_SWIZZLES(S, 4)
+
+        T* data() { return _data; }
+        const T* data() const { return _data; }
     };
+
     template<typename T>
-    class vec_storage<3, T> {
+    class vec_storage<4, T> {
       public:
-        T x{}, y{}, z{};
+        T x{}, y{}, z{}, w{};
 
         T& _x() { return x; }
         T& _y() { return y; }
         T& _z() { return z; }
+        T& _w() { return w; }
 
         const T& _x() const { return x; }
         const T& _y() const { return y; }
         const T& _z() const { return z; }
+        const T& _w() const { return w; }
 
         T& operator[](const luint i) {
             switch (i) {
                 case 0: return x;
                 case 1: return y;
                 case 2: return z;
+                case 3: return w;
                 default:
 #if !defined(NDEBUG)
                     throw std::runtime_error{"Index out of range"};
@@ -234,6 +1554,7 @@ namespace mgm {
                 case 0: return x;
                 case 1: return y;
                 case 2: return z;
+                case 3: return w;
                 default:
 #if !defined(NDEBUG)
                     throw std::runtime_error{"Index out of range"};
@@ -246,36 +1567,43 @@ namespace mgm {
         vec_storage(const T& k = T{})
             : x(k),
               y(k),
-              z(k) {}
+              z(k),
+              w(k) {}
 
-        vec_storage(const T& x_v, const T& y_v, const T& z_v = 0)
+        vec_storage(const T& x_v, const T& y_v, const T& z_v = 0, const T& w_v = 0)
             : x(x_v),
               y(y_v),
-              z(z_v) {}
+              z(z_v),
+              w(w_v) {}
 
         vec_storage(const vec_storage&) = default;
         vec_storage(vec_storage&&) = default;
         vec_storage& operator=(const vec_storage&) = default;
         vec_storage& operator=(vec_storage&&) = default;
 
+        MGMATH_SWIZZLES(4, 4)
+
         T* data() { return (T*)this; }
         const T* data() const { return (const T*)this; }
     };
     template<typename T>
-    class vec_storage<2, T> {
+    class vec_storage<3, T> {
       public:
-        T x{}, y{};
+        T x{}, y{}, z{};
 
         T& _x() { return x; }
         T& _y() { return y; }
+        T& _z() { return z; }
 
         const T& _x() const { return x; }
         const T& _y() const { return y; }
+        const T& _z() const { return z; }
 
         T& operator[](const luint i) {
             switch (i) {
                 case 0: return x;
                 case 1: return y;
+                case 2: return z;
                 default:
 #if !defined(NDEBUG)
                     throw std::runtime_error{"Index out of range"};
@@ -288,6 +1616,7 @@ namespace mgm {
             switch (i) {
                 case 0: return x;
                 case 1: return y;
+                case 2: return z;
                 default:
 #if !defined(NDEBUG)
                     throw std::runtime_error{"Index out of range"};
@@ -299,23 +1628,106 @@ namespace mgm {
 
         vec_storage(const T& k = T{})
             : x(k),
-              y(k) {}
+              y(k),
+              z(k) {}
 
-        vec_storage(const T& x_v, const T& y_v)
+        vec_storage(const T& x_v, const T& y_v, const T& z_v = 0)
             : x(x_v),
-              y(y_v) {}
+              y(y_v),
+              z(z_v) {}
 
         vec_storage(const vec_storage&) = default;
         vec_storage(vec_storage&&) = default;
         vec_storage& operator=(const vec_storage&) = default;
         vec_storage& operator=(vec_storage&&) = default;
 
+        MGMATH_SWIZZLES(3, 3)
+
         T* data() { return (T*)this; }
         const T* data() const { return (const T*)this; }
     };
-
-    template<luint S, typename T>
-    class vec : public vec_storage<S, T> {
+    template<typename T>
+    class vec_storage<2, T> {
+      public:
+        T x{}, y{};
+
+        T& _x() { return x; }
+        T& _y() { return y; }
+
+        const T& _x() const { return x; }
+        const T& _y() const { return y; }
+
+        T& operator[](const luint i) {
+            switch (i) {
+                case 0: return x;
+                case 1: return y;
+                default:
+#if !defined(NDEBUG)
+                    throw std::runtime_error{"Index out of range"};
+#else
+                    return x;
+#endif
+            }
+        }
+        const T& operator[](const luint i) const {
+            switch (i) {
+                case 0: return x;
+                case 1: return y;
+                default:
+#if !defined(NDEBUG)
+                    throw std::runtime_error{"Index out of range"};
+#else
+                    return x;
+#endif
+            }
+        }
+
+        vec_storage(const T& k = T{})
+            : x(k),
+              y(k) {}
+
+        vec_storage(const T& x_v, const T& y_v)
+            : x(x_v),
+              y(y_v) {}
+
+        vec_storage(const vec_storage&) = default;
+        vec_storage(vec_storage&&) = default;
+        vec_storage& operator=(const vec_storage&) = default;
+        vec_storage& operator=(vec_storage&&) = default;
+
+        MGMATH_SWIZZLES(2, 2)
+
+        T* data() { return (T*)this; }
+        const T* data() const { return (const T*)this; }
+    };
+
+#undef MGMATH_SWIZZLES
+#undef MGMATH_SWIZZLE_GET_FROM1
+#undef MGMATH_SWIZZLE_GET_FROM2
+#undef MGMATH_SWIZZLE_GET_FROM3
+#undef MGMATH_SWIZZLE_EACH_D_4
+#undef MGMATH_SWIZZLE_EACH_C_4
+#undef MGMATH_SWIZZLE_EACH_B_4
+#undef MGMATH_SWIZZLE_EACH_A_4
+#undef MGMATH_SWIZZLE_EACH_D_3
+#undef MGMATH_SWIZZLE_EACH_C_3
+#undef MGMATH_SWIZZLE_EACH_B_3
+#undef MGMATH_SWIZZLE_EACH_A_3
+#undef MGMATH_SWIZZLE_EACH_D_2
+#undef MGMATH_SWIZZLE_EACH_C_2
+#undef MGMATH_SWIZZLE_EACH_B_2
+#undef MGMATH_SWIZZLE_EACH_A_2
+#undef MGMATH_SWIZZLE4
+#undef MGMATH_SWIZZLE3
+#undef MGMATH_SWIZZLE2
+#undef MGMATH_SWIZZLE_GET
+#undef MGMATH_SWIZZLE_INDEX_w
+#undef MGMATH_SWIZZLE_INDEX_z
+#undef MGMATH_SWIZZLE_INDEX_y
+#undef MGMATH_SWIZZLE_INDEX_x
+
+    template<luint S, typename T>
+    class vec : public vec_storage<S, T> {
       public:
         template<ASSURE_SIZE(1)>
         T& _x() { return vec_storage<S, T>::_x(); }
@@ -423,7 +1835,7 @@ namespace mgm {
         }
 
         static inline void real_dot(const T& a, const T& b, T& r, luint& i) {
-            r += a * b;
+            r = mgm::mad(a, b, r);
             ++i;
         }
         template<typename... Ts>
@@ -454,707 +1866,177 @@ namespace mgm {
             (min_one((const Ts&)a[i], (const Ts&)b[i], (Ts&)r[i], i), ...);
         }
 
+        template<vec_op Op>
+        static inline void fold_one(const T& a, const T& b, T& r, luint& i) {
+            r = apply_vec_op<Op>(a, b);
+            ++i;
+        }
+        template<vec_op Op, typename... Ts>
+        static inline void fold(const T* a, const T* b, T* r, TypeList<Ts...>) {
+            luint i = 0;
+            (fold_one<Op>((const Ts&)a[i], (const Ts&)b[i], (Ts&)r[i], i), ...);
+        }
+
+        template<bool Exact>
+        static inline void mad_one(const T& a, const T& b, const T& c, T& r, luint& i) {
+            r = Exact ? mgm::fma(a, b, c) : mgm::mad(a, b, c);
+            ++i;
+        }
+        template<bool Exact, typename... Ts>
+        static inline void mad(const T* a, const T* b, const T* c, T* r, TypeList<Ts...>) {
+            luint i = 0;
+            (mad_one<Exact>((const Ts&)a[i], (const Ts&)b[i], (const Ts&)c[i], (Ts&)r[i], i), ...);
+        }
+
+        template<vec_op Op>
+        static inline void apply(const T* a, const T* b, T* r) {
+            MGMATH_CHECK_FLOATS_SCOPE(vec_op_names[static_cast<uint8>(Op)], r, S, a, S, b, S);
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (simd_int4_supports<Op, T, S>()) {
+                simd_int4_apply<Op, S>(a, b, r);
+                return;
+            }
+            else if constexpr (std::is_same_v<T, double> && S >= 2 && S <= 4 && Op <= vec_op::max && Op != vec_op::mod) {
+                simd_pd_apply<Op, S>(a, b, r);
+                return;
+            }
+#endif
+            if constexpr (S > MGMATH_UNROLL_LIMIT)
+                vec_loop<Op, S>(a, b, r);
+            else if constexpr (Op == vec_op::add)
+                add(a, b, r, IntList<S>{});
+            else if constexpr (Op == vec_op::sub)
+                sub(a, b, r, IntList<S>{});
+            else if constexpr (Op == vec_op::mul)
+                mul(a, b, r, IntList<S>{});
+            else if constexpr (Op == vec_op::div)
+                div(a, b, r, IntList<S>{});
+            else if constexpr (Op == vec_op::mod)
+                mod(a, b, r, IntList<S>{});
+            else if constexpr (Op == vec_op::min)
+                min(a, b, r, IntList<S>{});
+            else if constexpr (Op == vec_op::max)
+                max(a, b, r, IntList<S>{});
+            else
+                fold<Op>(a, b, r, IntList<S>{});
+        }
+        static inline T apply_dot(const T* a, const T* b) {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, double> && S >= 2 && S <= 4)
+                return simd_pd_dot<S>(a, b);
+            else if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4)
+                return _mm_cvtss_f32(simd_dot_ps<S>(simd_load_ps<S>(a), simd_load_ps<S>(b)));
+#endif
+            if constexpr (S > MGMATH_UNROLL_LIMIT)
+                return dot_loop<S>(a, b);
+            else
+                return real_dot(a, b, IntList<S>{});
+        }
+        template<bool Exact>
+        static inline void apply_mad(const T* a, const T* b, const T* c, T* r) {
+            MGMATH_CHECK_FLOATS_SCOPE(Exact ? "vec_fma" : "vec_mad", r, S, a, S, b, S, c, S);
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(MGMATH_FMA)
+            constexpr bool vectorize = true;
+#else
+            constexpr bool vectorize = !Exact;
+#endif
+            if constexpr (vectorize && std::is_same_v<T, float> && S >= 2 && S <= 4) {
+                simd_store_ps<S>(r, simd_mad(simd_load_ps<S>(a), simd_load_ps<S>(b), simd_load_ps<S>(c)));
+                return;
+            }
+            else if constexpr (vectorize && std::is_same_v<T, double> && S >= 2 && S <= 4) {
+#if defined(__AVX__)
+                if constexpr (S == 4) {
+                    _mm256_storeu_pd(r, simd_mad(_mm256_loadu_pd(a), _mm256_loadu_pd(b), _mm256_loadu_pd(c)));
+                    return;
+                }
+#endif
+                _mm_storeu_pd(r, simd_mad(_mm_loadu_pd(a), _mm_loadu_pd(b), _mm_loadu_pd(c)));
+                if constexpr (S == 3)
+                    _mm_store_sd(r + 2, simd_mad(_mm_load_sd(a + 2), _mm_load_sd(b + 2), _mm_load_sd(c + 2)));
+                else if constexpr (S == 4)
+                    _mm_storeu_pd(r + 2, simd_mad(_mm_loadu_pd(a + 2), _mm_loadu_pd(b + 2), _mm_loadu_pd(c + 2)));
+                return;
+            }
+#endif
+            if constexpr (S > MGMATH_UNROLL_LIMIT)
+                mad_loop<Exact, S>(a, b, c, r);
+            else
+                mad<Exact>(a, b, c, r, IntList<S>{});
+        }
+        static inline bool apply_eq(const T* a, const T* b) {
+            if constexpr (S > MGMATH_UNROLL_LIMIT) {
+                for (luint i = 0; i < S; i++)
+                    if (!(a[i] == b[i]))
+                        return false;
+                return true;
+            }
+            else
+                return eq(a, b, IntList<S>{});
+        }
+
       public:
 #if defined(MGMATH_SWIZZLE)
-        template<ASSURE_SIZE(2)>
-        vec<2, T> xx() const { return vec<2, T>{_x(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<2, T> xy() const { return vec<2, T>{_x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<2, T> xz() const { return vec<2, T>{_x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<2, T> xw() const { return vec<2, T>{_x(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<2, T> yx() const { return vec<2, T>{_y(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<2, T> yy() const { return vec<2, T>{_y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<2, T> yz() const { return vec<2, T>{_y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<2, T> yw() const { return vec<2, T>{_y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<2, T> zx() const { return vec<2, T>{_z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<2, T> zy() const { return vec<2, T>{_z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<2, T> zz() const { return vec<2, T>{_z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<2, T> zw() const { return vec<2, T>{_z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<2, T> wx() const { return vec<2, T>{_w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<2, T> wy() const { return vec<2, T>{_w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<2, T> wz() const { return vec<2, T>{_w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<2, T> ww() const { return vec<2, T>{_w(), _w()}; }
+        /**
+         * @brief Build a new vector out of the components of this vector at the given indices (`v.swizzle<2, 0>()` is `v.zx()`)
+         */
+        template<luint... I>
+        vec<sizeof...(I), T> swizzle() const {
+            static_assert(((I < S) && ...), "Swizzle index out of range");
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S == 4 && sizeof...(I) == 4) {
+                constexpr luint idx[] = {I...};
+                const __m128 v = _mm_loadu_ps(data());
+                vec<4, float> res;
+                _mm_storeu_ps(res.data(), _mm_shuffle_ps(v, v, _MM_SHUFFLE(idx[3], idx[2], idx[1], idx[0])));
+                return res;
+            }
+#if defined(__AVX2__)
+            else if constexpr (std::is_same_v<T, double> && S == 4 && sizeof...(I) == 4) {
+                constexpr luint idx[] = {I...};
+                vec<4, double> res;
+                _mm256_storeu_pd(res.data(), _mm256_permute4x64_pd(_mm256_loadu_pd(data()), _MM_SHUFFLE(idx[3], idx[2], idx[1], idx[0])));
+                return res;
+            }
+#endif
+            else
+#endif
+                return vec<sizeof...(I), T>{data()[I]...};
+        }
 
-        template<ASSURE_SIZE(2)>
-        vec<3, T> xxx() const { return vec<3, T>{_x(), _x(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<3, T> xxy() const { return vec<3, T>{_x(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> xxz() const { return vec<3, T>{_x(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> xxw() const { return vec<3, T>{_x(), _x(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<3, T> xyx() const { return vec<3, T>{_x(), _y(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<3, T> xyy() const { return vec<3, T>{_x(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> xyz() const { return vec<3, T>{_x(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> xyw() const { return vec<3, T>{_x(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> xzx() const { return vec<3, T>{_x(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> xzy() const { return vec<3, T>{_x(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> xzz() const { return vec<3, T>{_x(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> xzw() const { return vec<3, T>{_x(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> xwx() const { return vec<3, T>{_x(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> xwy() const { return vec<3, T>{_x(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> xwz() const { return vec<3, T>{_x(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> xww() const { return vec<3, T>{_x(), _w(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<3, T> yxx() const { return vec<3, T>{_y(), _x(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<3, T> yxy() const { return vec<3, T>{_y(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> yxz() const { return vec<3, T>{_y(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> yxw() const { return vec<3, T>{_y(), _x(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<3, T> yyx() const { return vec<3, T>{_y(), _y(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<3, T> yyy() const { return vec<3, T>{_y(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> yyz() const { return vec<3, T>{_y(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> yyw() const { return vec<3, T>{_y(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> yzx() const { return vec<3, T>{_y(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> yzy() const { return vec<3, T>{_y(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> yzz() const { return vec<3, T>{_y(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> yzw() const { return vec<3, T>{_y(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> ywx() const { return vec<3, T>{_y(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> ywy() const { return vec<3, T>{_y(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> ywz() const { return vec<3, T>{_y(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> yww() const { return vec<3, T>{_y(), _w(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zxx() const { return vec<3, T>{_z(), _x(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zxy() const { return vec<3, T>{_z(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zxz() const { return vec<3, T>{_z(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> zxw() const { return vec<3, T>{_z(), _x(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zyx() const { return vec<3, T>{_z(), _y(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zyy() const { return vec<3, T>{_z(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zyz() const { return vec<3, T>{_z(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> zyw() const { return vec<3, T>{_z(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zzx() const { return vec<3, T>{_z(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zzy() const { return vec<3, T>{_z(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<3, T> zzz() const { return vec<3, T>{_z(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> zzw() const { return vec<3, T>{_z(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> zwx() const { return vec<3, T>{_z(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> zwy() const { return vec<3, T>{_z(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> zwz() const { return vec<3, T>{_z(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> zww() const { return vec<3, T>{_z(), _w(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wxx() const { return vec<3, T>{_w(), _x(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wxy() const { return vec<3, T>{_w(), _x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wxz() const { return vec<3, T>{_w(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wxw() const { return vec<3, T>{_w(), _x(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wyx() const { return vec<3, T>{_w(), _y(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wyy() const { return vec<3, T>{_w(), _y(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wyz() const { return vec<3, T>{_w(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wyw() const { return vec<3, T>{_w(), _y(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wzx() const { return vec<3, T>{_w(), _z(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wzy() const { return vec<3, T>{_w(), _z(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wzz() const { return vec<3, T>{_w(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wzw() const { return vec<3, T>{_w(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wwx() const { return vec<3, T>{_w(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wwy() const { return vec<3, T>{_w(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> wwz() const { return vec<3, T>{_w(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<3, T> www() const { return vec<3, T>{_w(), _w(), _w()}; }
+        /**
+         * @brief Write through a swizzle, assigning to the result stores into the components of this vector at the given indices (`v.ref<2, 0>() = {1, 2}`)
+         *
+         * Only the temporary can be assigned to, a stored result (`auto r = v.ref<0, 1>()`) can be read but not written through
+         */
+        template<luint... I>
+        swizzle_ref<S, T, I...> ref() & {
+            static_assert(((I < S) && ...), "Swizzle index out of range");
+            return swizzle_ref<S, T, I...>{*this};
+        }
 
-        template<ASSURE_SIZE(2)>
-        vec<4, T> xxxx() const { return vec<4, T>{_x(), _x(), _x(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> xxxy() const { return vec<4, T>{_x(), _x(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xxxz() const { return vec<4, T>{_x(), _x(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xxxw() const { return vec<4, T>{_x(), _x(), _x(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> xxyx() const { return vec<4, T>{_x(), _x(), _y(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> xxyy() const { return vec<4, T>{_x(), _x(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xxyz() const { return vec<4, T>{_x(), _x(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xxyw() const { return vec<4, T>{_x(), _x(), _y(), _w()}; }
         template<ASSURE_SIZE(3)>
-        vec<4, T> xxzx() const { return vec<4, T>{_x(), _x(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xxzy() const { return vec<4, T>{_x(), _x(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xxzz() const { return vec<4, T>{_x(), _x(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xxzw() const { return vec<4, T>{_x(), _x(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xxwx() const { return vec<4, T>{_x(), _x(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xxwy() const { return vec<4, T>{_x(), _x(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xxwz() const { return vec<4, T>{_x(), _x(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xxww() const { return vec<4, T>{_x(), _x(), _w(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> xyxx() const { return vec<4, T>{_x(), _y(), _x(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> xyxy() const { return vec<4, T>{_x(), _y(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xyxz() const { return vec<4, T>{_x(), _y(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xyxw() const { return vec<4, T>{_x(), _y(), _x(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> xyyx() const { return vec<4, T>{_x(), _y(), _y(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> xyyy() const { return vec<4, T>{_x(), _y(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xyyz() const { return vec<4, T>{_x(), _y(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xyyw() const { return vec<4, T>{_x(), _y(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xyzx() const { return vec<4, T>{_x(), _y(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xyzy() const { return vec<4, T>{_x(), _y(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xyzz() const { return vec<4, T>{_x(), _y(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xyzw() const { return vec<4, T>{_x(), _y(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xywx() const { return vec<4, T>{_x(), _y(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xywy() const { return vec<4, T>{_x(), _y(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xywz() const { return vec<4, T>{_x(), _y(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xyww() const { return vec<4, T>{_x(), _y(), _w(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xzxx() const { return vec<4, T>{_x(), _z(), _x(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xzxy() const { return vec<4, T>{_x(), _z(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xzxz() const { return vec<4, T>{_x(), _z(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xzxw() const { return vec<4, T>{_x(), _z(), _x(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xzyx() const { return vec<4, T>{_x(), _z(), _y(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xzyy() const { return vec<4, T>{_x(), _z(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xzyz() const { return vec<4, T>{_x(), _z(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xzyw() const { return vec<4, T>{_x(), _z(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xzzx() const { return vec<4, T>{_x(), _z(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> xzzy() const { return vec<4, T>{_x(), _z(), _z(), _y()}; }
+        vec(const vec<2, T>& v, const T& z)
+            : vec_storage<S, T>{v._x(), v._y(), z} {}
         template<ASSURE_SIZE(3)>
-        vec<4, T> xzzz() const { return vec<4, T>{_x(), _z(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xzzw() const { return vec<4, T>{_x(), _z(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xzwx() const { return vec<4, T>{_x(), _z(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xzwy() const { return vec<4, T>{_x(), _z(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xzwz() const { return vec<4, T>{_x(), _z(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xzww() const { return vec<4, T>{_x(), _z(), _w(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwxx() const { return vec<4, T>{_x(), _w(), _x(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwxy() const { return vec<4, T>{_x(), _w(), _x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwxz() const { return vec<4, T>{_x(), _w(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwxw() const { return vec<4, T>{_x(), _w(), _x(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwyx() const { return vec<4, T>{_x(), _w(), _y(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwyy() const { return vec<4, T>{_x(), _w(), _y(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwyz() const { return vec<4, T>{_x(), _w(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwyw() const { return vec<4, T>{_x(), _w(), _y(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwzx() const { return vec<4, T>{_x(), _w(), _z(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwzy() const { return vec<4, T>{_x(), _w(), _z(), _y()}; }
+        vec(const T& x, const vec<2, T>& v)
+            : vec_storage<S, T>{x, v._x(), v._y()} {}
         template<ASSURE_SIZE(4)>
-        vec<4, T> xwzz() const { return vec<4, T>{_x(), _w(), _z(), _z()}; }
+        vec(const vec<2, T>& v1, const vec<2, T>& v2)
+            : vec_storage<S, T>{v1._x(), v1._y(), v2._x(), v2._y()} {}
         template<ASSURE_SIZE(4)>
-        vec<4, T> xwzw() const { return vec<4, T>{_x(), _w(), _z(), _w()}; }
+        vec(const vec<2, T>& v, const T& z, const T& w)
+            : vec_storage<S, T>{v._x(), v._y(), z, w} {}
         template<ASSURE_SIZE(4)>
-        vec<4, T> xwwx() const { return vec<4, T>{_x(), _w(), _w(), _x()}; }
+        vec(const T& x, const vec<2, T>& v, const T& w)
+            : vec_storage<S, T>{x, v._x(), v._y(), w} {}
         template<ASSURE_SIZE(4)>
-        vec<4, T> xwwy() const { return vec<4, T>{_x(), _w(), _w(), _y()}; }
+        vec(const T& x, const T& y, const vec<2, T>& v)
+            : vec_storage<S, T>{x, y, v._x(), v._y()} {}
         template<ASSURE_SIZE(4)>
-        vec<4, T> xwwz() const { return vec<4, T>{_x(), _w(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> xwww() const { return vec<4, T>{_x(), _w(), _w(), _w()}; }
-
-        template<ASSURE_SIZE(2)>
-        vec<4, T> yxxx() const { return vec<4, T>{_y(), _x(), _x(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> yxxy() const { return vec<4, T>{_y(), _x(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yxxz() const { return vec<4, T>{_y(), _x(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yxxw() const { return vec<4, T>{_y(), _x(), _x(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> yxyx() const { return vec<4, T>{_y(), _x(), _y(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> yxyy() const { return vec<4, T>{_y(), _x(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yxyz() const { return vec<4, T>{_y(), _x(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yxyw() const { return vec<4, T>{_y(), _x(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yxzx() const { return vec<4, T>{_y(), _x(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yxzy() const { return vec<4, T>{_y(), _x(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yxzz() const { return vec<4, T>{_y(), _x(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yxzw() const { return vec<4, T>{_y(), _x(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yxwx() const { return vec<4, T>{_y(), _x(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yxwy() const { return vec<4, T>{_y(), _x(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yxwz() const { return vec<4, T>{_y(), _x(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yxww() const { return vec<4, T>{_y(), _x(), _w(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> yyxx() const { return vec<4, T>{_y(), _y(), _x(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> yyxy() const { return vec<4, T>{_y(), _y(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yyxz() const { return vec<4, T>{_y(), _y(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yyxw() const { return vec<4, T>{_y(), _y(), _x(), _w()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> yyyx() const { return vec<4, T>{_y(), _y(), _y(), _x()}; }
-        template<ASSURE_SIZE(2)>
-        vec<4, T> yyyy() const { return vec<4, T>{_y(), _y(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yyyz() const { return vec<4, T>{_y(), _y(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yyyw() const { return vec<4, T>{_y(), _y(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yyzx() const { return vec<4, T>{_y(), _y(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yyzy() const { return vec<4, T>{_y(), _y(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yyzz() const { return vec<4, T>{_y(), _y(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yyzw() const { return vec<4, T>{_y(), _y(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yywx() const { return vec<4, T>{_y(), _y(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yywy() const { return vec<4, T>{_y(), _y(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yywz() const { return vec<4, T>{_y(), _y(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yyww() const { return vec<4, T>{_y(), _y(), _w(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzxx() const { return vec<4, T>{_y(), _z(), _x(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzxy() const { return vec<4, T>{_y(), _z(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzxz() const { return vec<4, T>{_y(), _z(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yzxw() const { return vec<4, T>{_y(), _z(), _x(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzyx() const { return vec<4, T>{_y(), _z(), _y(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzyy() const { return vec<4, T>{_y(), _z(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzyz() const { return vec<4, T>{_y(), _z(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yzyw() const { return vec<4, T>{_y(), _z(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzzx() const { return vec<4, T>{_y(), _z(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzzy() const { return vec<4, T>{_y(), _z(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> yzzz() const { return vec<4, T>{_y(), _z(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yzzw() const { return vec<4, T>{_y(), _z(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yzwx() const { return vec<4, T>{_y(), _z(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yzwy() const { return vec<4, T>{_y(), _z(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yzwz() const { return vec<4, T>{_y(), _z(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> yzww() const { return vec<4, T>{_y(), _z(), _w(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywxx() const { return vec<4, T>{_y(), _w(), _x(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywxy() const { return vec<4, T>{_y(), _w(), _x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywxz() const { return vec<4, T>{_y(), _w(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywxw() const { return vec<4, T>{_y(), _w(), _x(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywyx() const { return vec<4, T>{_y(), _w(), _y(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywyy() const { return vec<4, T>{_y(), _w(), _y(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywyz() const { return vec<4, T>{_y(), _w(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywyw() const { return vec<4, T>{_y(), _w(), _y(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywzx() const { return vec<4, T>{_y(), _w(), _z(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywzy() const { return vec<4, T>{_y(), _w(), _z(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywzz() const { return vec<4, T>{_y(), _w(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywzw() const { return vec<4, T>{_y(), _w(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywwx() const { return vec<4, T>{_y(), _w(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywwy() const { return vec<4, T>{_y(), _w(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywwz() const { return vec<4, T>{_y(), _w(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> ywww() const { return vec<4, T>{_y(), _w(), _w(), _w()}; }
-
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxxx() const { return vec<4, T>{_z(), _x(), _x(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxxy() const { return vec<4, T>{_z(), _x(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxxz() const { return vec<4, T>{_z(), _x(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zxxw() const { return vec<4, T>{_z(), _x(), _x(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxyx() const { return vec<4, T>{_z(), _x(), _y(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxyy() const { return vec<4, T>{_z(), _x(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxyz() const { return vec<4, T>{_z(), _x(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zxyw() const { return vec<4, T>{_z(), _x(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxzx() const { return vec<4, T>{_z(), _x(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxzy() const { return vec<4, T>{_z(), _x(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zxzz() const { return vec<4, T>{_z(), _x(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zxzw() const { return vec<4, T>{_z(), _x(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zxwx() const { return vec<4, T>{_z(), _x(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zxwy() const { return vec<4, T>{_z(), _x(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zxwz() const { return vec<4, T>{_z(), _x(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zxww() const { return vec<4, T>{_z(), _x(), _w(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyxx() const { return vec<4, T>{_z(), _y(), _x(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyxy() const { return vec<4, T>{_z(), _y(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyxz() const { return vec<4, T>{_z(), _y(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zyxw() const { return vec<4, T>{_z(), _y(), _x(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyyx() const { return vec<4, T>{_z(), _y(), _y(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyyy() const { return vec<4, T>{_z(), _y(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyyz() const { return vec<4, T>{_z(), _y(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zyyw() const { return vec<4, T>{_z(), _y(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyzx() const { return vec<4, T>{_z(), _y(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyzy() const { return vec<4, T>{_z(), _y(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zyzz() const { return vec<4, T>{_z(), _y(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zyzw() const { return vec<4, T>{_z(), _y(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zywx() const { return vec<4, T>{_z(), _y(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zywy() const { return vec<4, T>{_z(), _y(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zywz() const { return vec<4, T>{_z(), _y(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zyww() const { return vec<4, T>{_z(), _y(), _w(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzxx() const { return vec<4, T>{_z(), _z(), _x(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzxy() const { return vec<4, T>{_z(), _z(), _x(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzxz() const { return vec<4, T>{_z(), _z(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zzxw() const { return vec<4, T>{_z(), _z(), _x(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzyx() const { return vec<4, T>{_z(), _z(), _y(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzyy() const { return vec<4, T>{_z(), _z(), _y(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzyz() const { return vec<4, T>{_z(), _z(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zzyw() const { return vec<4, T>{_z(), _z(), _y(), _w()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzzx() const { return vec<4, T>{_z(), _z(), _z(), _x()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzzy() const { return vec<4, T>{_z(), _z(), _z(), _y()}; }
-        template<ASSURE_SIZE(3)>
-        vec<4, T> zzzz() const { return vec<4, T>{_z(), _z(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zzzw() const { return vec<4, T>{_z(), _z(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zzwx() const { return vec<4, T>{_z(), _z(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zzwy() const { return vec<4, T>{_z(), _z(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zzwz() const { return vec<4, T>{_z(), _z(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zzww() const { return vec<4, T>{_z(), _z(), _w(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwxx() const { return vec<4, T>{_z(), _w(), _x(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwxy() const { return vec<4, T>{_z(), _w(), _x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwxz() const { return vec<4, T>{_z(), _w(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwxw() const { return vec<4, T>{_z(), _w(), _x(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwyx() const { return vec<4, T>{_z(), _w(), _y(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwyy() const { return vec<4, T>{_z(), _w(), _y(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwyz() const { return vec<4, T>{_z(), _w(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwyw() const { return vec<4, T>{_z(), _w(), _y(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwzx() const { return vec<4, T>{_z(), _w(), _z(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwzy() const { return vec<4, T>{_z(), _w(), _z(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwzz() const { return vec<4, T>{_z(), _w(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwzw() const { return vec<4, T>{_z(), _w(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwwx() const { return vec<4, T>{_z(), _w(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwwy() const { return vec<4, T>{_z(), _w(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwwz() const { return vec<4, T>{_z(), _w(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> zwww() const { return vec<4, T>{_z(), _w(), _w(), _w()}; }
-
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxxx() const { return vec<4, T>{_w(), _x(), _x(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxxy() const { return vec<4, T>{_w(), _x(), _x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxxz() const { return vec<4, T>{_w(), _x(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxxw() const { return vec<4, T>{_w(), _x(), _x(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxyx() const { return vec<4, T>{_w(), _x(), _y(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxyy() const { return vec<4, T>{_w(), _x(), _y(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxyz() const { return vec<4, T>{_w(), _x(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxyw() const { return vec<4, T>{_w(), _x(), _y(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxzx() const { return vec<4, T>{_w(), _x(), _z(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxzy() const { return vec<4, T>{_w(), _x(), _z(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxzz() const { return vec<4, T>{_w(), _x(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxzw() const { return vec<4, T>{_w(), _x(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxwx() const { return vec<4, T>{_w(), _x(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxwy() const { return vec<4, T>{_w(), _x(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxwz() const { return vec<4, T>{_w(), _x(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wxww() const { return vec<4, T>{_w(), _x(), _w(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyxx() const { return vec<4, T>{_w(), _y(), _x(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyxy() const { return vec<4, T>{_w(), _y(), _x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyxz() const { return vec<4, T>{_w(), _y(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyxw() const { return vec<4, T>{_w(), _y(), _x(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyyx() const { return vec<4, T>{_w(), _y(), _y(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyyy() const { return vec<4, T>{_w(), _y(), _y(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyyz() const { return vec<4, T>{_w(), _y(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyyw() const { return vec<4, T>{_w(), _y(), _y(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyzx() const { return vec<4, T>{_w(), _y(), _z(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyzy() const { return vec<4, T>{_w(), _y(), _z(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyzz() const { return vec<4, T>{_w(), _y(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyzw() const { return vec<4, T>{_w(), _y(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wywx() const { return vec<4, T>{_w(), _y(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wywy() const { return vec<4, T>{_w(), _y(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wywz() const { return vec<4, T>{_w(), _y(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wyww() const { return vec<4, T>{_w(), _y(), _w(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzxx() const { return vec<4, T>{_w(), _z(), _x(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzxy() const { return vec<4, T>{_w(), _z(), _x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzxz() const { return vec<4, T>{_w(), _z(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzxw() const { return vec<4, T>{_w(), _z(), _x(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzyx() const { return vec<4, T>{_w(), _z(), _y(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzyy() const { return vec<4, T>{_w(), _z(), _y(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzyz() const { return vec<4, T>{_w(), _z(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzyw() const { return vec<4, T>{_w(), _z(), _y(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzzx() const { return vec<4, T>{_w(), _z(), _z(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzzy() const { return vec<4, T>{_w(), _z(), _z(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzzz() const { return vec<4, T>{_w(), _z(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzzw() const { return vec<4, T>{_w(), _z(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzwx() const { return vec<4, T>{_w(), _z(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzwy() const { return vec<4, T>{_w(), _z(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzwz() const { return vec<4, T>{_w(), _z(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wzww() const { return vec<4, T>{_w(), _z(), _w(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwxx() const { return vec<4, T>{_w(), _w(), _x(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwxy() const { return vec<4, T>{_w(), _w(), _x(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwxz() const { return vec<4, T>{_w(), _w(), _x(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwxw() const { return vec<4, T>{_w(), _w(), _x(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwyx() const { return vec<4, T>{_w(), _w(), _y(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwyy() const { return vec<4, T>{_w(), _w(), _y(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwyz() const { return vec<4, T>{_w(), _w(), _y(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwyw() const { return vec<4, T>{_w(), _w(), _y(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwzx() const { return vec<4, T>{_w(), _w(), _z(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwzy() const { return vec<4, T>{_w(), _w(), _z(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwzz() const { return vec<4, T>{_w(), _w(), _z(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwzw() const { return vec<4, T>{_w(), _w(), _z(), _w()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwwx() const { return vec<4, T>{_w(), _w(), _w(), _x()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwwy() const { return vec<4, T>{_w(), _w(), _w(), _y()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwwz() const { return vec<4, T>{_w(), _w(), _w(), _z()}; }
-        template<ASSURE_SIZE(4)>
-        vec<4, T> wwww() const { return vec<4, T>{_w(), _w(), _w(), _w()}; }
-
-        template<ASSURE_SIZE(3)>
-        vec(const vec<2, T>& v, const T& z)
-            : vec_storage<S, T>{v._x(), v._y(), z} {}
-        template<ASSURE_SIZE(3)>
-        vec(const T& x, const vec<2, T>& v)
-            : vec_storage<S, T>{x, v._x(), v._y()} {}
-        template<ASSURE_SIZE(4)>
-        vec(const vec<2, T>& v1, const vec<2, T>& v2)
-            : vec_storage<S, T>{v1._x(), v1._y(), v2._x(), v2._y()} {}
-        template<ASSURE_SIZE(4)>
-        vec(const vec<2, T>& v, const T& z, const T& w)
-            : vec_storage<S, T>{v._x(), v._y(), z, w} {}
-        template<ASSURE_SIZE(4)>
-        vec(const T& x, const vec<2, T>& v, const T& w)
-            : vec_storage<S, T>{x, v._x(), v._y(), w} {}
-        template<ASSURE_SIZE(4)>
-        vec(const T& x, const T& y, const vec<2, T>& v)
-            : vec_storage<S, T>{x, y, v._x(), v._y()} {}
-        template<ASSURE_SIZE(4)>
-        vec(const vec<3, T>& v, const T& w)
-            : vec_storage<S, T>{v._x(), v._y(), v._z(), w} {}
+        vec(const vec<3, T>& v, const T& w)
+            : vec_storage<S, T>{v._x(), v._y(), v._z(), w} {}
         template<ASSURE_SIZE(4)>
         vec(const T& x, const vec<3, T>& v)
             : vec_storage<S, T>{x, v._x(), v._y(), v._z()} {}
@@ -1212,17 +2094,26 @@ namespace mgm {
             memcpy(data(), k, S * sizeof(T));
         }
 
+        /**
+         * @brief Convert every component with static_cast (for rounding and saturation, see convert)
+         */
+        template<typename U, typename std::enable_if<!std::is_same_v<U, T>, bool>::type = true>
+        explicit vec(const vec<S, U>& v) {
+            for (luint i = 0; i < S; i++)
+                data()[i] = static_cast<T>(v[i]);
+        }
+
         T& operator[](const luint i) { return vec_storage<S, T>::operator[](i); }
         const T& operator[](const luint i) const { return vec_storage<S, T>::operator[](i); }
 
         vec<S, T> operator+(const vec<S, T>& v) const {
             vec<S, T> res;
-            add(data(), v.data(), res.data(), IntList<S>{});
+            apply<vec_op::add>(data(), v.data(), res.data());
             return res;
         }
         vec<S, T> operator-(const vec<S, T>& v) const {
             vec<S, T> res{};
-            sub(data(), v.data(), res.data(), IntList<S>{});
+            apply<vec_op::sub>(data(), v.data(), res.data());
             return res;
         }
         vec<S, T> operator-() const {
@@ -1230,44 +2121,94 @@ namespace mgm {
         }
         vec<S, T> operator*(const vec<S, T>& v) const {
             vec<S, T> res{};
-            mul(data(), v.data(), res.data(), IntList<S>{});
+            apply<vec_op::mul>(data(), v.data(), res.data());
             return res;
         }
         vec<S, T> operator/(const vec<S, T>& v) const {
             vec<S, T> res{};
-            div(data(), v.data(), res.data(), IntList<S>{});
+            apply<vec_op::div>(data(), v.data(), res.data());
             return res;
         }
         vec<S, T> operator%(const T& k) const {
             vec<S, T> res;
-            mod(data(), k, res.data(), IntList<S>{});
+            apply<vec_op::mod>(data(), vec<S, T>{k}.data(), res.data());
             return res;
         }
         bool operator==(const vec<S, T>& v) const {
-            return eq(data(), v.data(), IntList<S>{});
+            return apply_eq(data(), v.data());
         }
         bool operator!=(const vec<S, T>& v) const {
-            return !eq(data(), v.data(), IntList<S>{});
+            return !apply_eq(data(), v.data());
         }
 
         vec<S, T>& operator+=(const vec<S, T>& v) {
-            add(data(), v.data(), data(), IntList<S>{});
+            apply<vec_op::add>(data(), v.data(), data());
             return *this;
         }
         vec<S, T>& operator-=(const vec<S, T>& v) {
-            sub(data(), v.data(), data(), IntList<S>{});
+            apply<vec_op::sub>(data(), v.data(), data());
             return *this;
         }
         vec<S, T>& operator*=(const vec<S, T>& v) {
-            mul(data(), v.data(), data(), IntList<S>{});
+            apply<vec_op::mul>(data(), v.data(), data());
             return *this;
         }
         vec<S, T>& operator/=(const vec<S, T>& v) {
-            div(data(), v.data(), data(), IntList<S>{});
+            apply<vec_op::div>(data(), v.data(), data());
             return *this;
         }
         vec<S, T>& operator%=(const T& k) {
-            mod(data(), k, data(), IntList<S>{});
+            apply<vec_op::mod>(data(), vec<S, T>{k}.data(), data());
+            return *this;
+        }
+
+        vec<S, T> operator&(const vec<S, T>& v) const {
+            vec<S, T> res;
+            apply<vec_op::bit_and>(data(), v.data(), res.data());
+            return res;
+        }
+        vec<S, T> operator|(const vec<S, T>& v) const {
+            vec<S, T> res;
+            apply<vec_op::bit_or>(data(), v.data(), res.data());
+            return res;
+        }
+        vec<S, T> operator^(const vec<S, T>& v) const {
+            vec<S, T> res;
+            apply<vec_op::bit_xor>(data(), v.data(), res.data());
+            return res;
+        }
+        vec<S, T> operator~() const {
+            return *this ^ vec<S, T>{static_cast<T>(~T(0))};
+        }
+        vec<S, T> operator<<(const uint n) const {
+            vec<S, T> res;
+            apply<vec_op::shift_left>(data(), vec<S, T>{static_cast<T>(n)}.data(), res.data());
+            return res;
+        }
+        vec<S, T> operator>>(const uint n) const {
+            vec<S, T> res;
+            apply<vec_op::shift_right>(data(), vec<S, T>{static_cast<T>(n)}.data(), res.data());
+            return res;
+        }
+
+        vec<S, T>& operator&=(const vec<S, T>& v) {
+            apply<vec_op::bit_and>(data(), v.data(), data());
+            return *this;
+        }
+        vec<S, T>& operator|=(const vec<S, T>& v) {
+            apply<vec_op::bit_or>(data(), v.data(), data());
+            return *this;
+        }
+        vec<S, T>& operator^=(const vec<S, T>& v) {
+            apply<vec_op::bit_xor>(data(), v.data(), data());
+            return *this;
+        }
+        vec<S, T>& operator<<=(const uint n) {
+            apply<vec_op::shift_left>(data(), vec<S, T>{static_cast<T>(n)}.data(), data());
+            return *this;
+        }
+        vec<S, T>& operator>>=(const uint n) {
+            apply<vec_op::shift_right>(data(), vec<S, T>{static_cast<T>(n)}.data(), data());
             return *this;
         }
 
@@ -1312,14 +2253,21 @@ namespace mgm {
          * @param v The second vector in the dot product operation
          */
         T dot(const vec<S, T>& v) const {
-            return real_dot(data(), v.data(), IntList<S>{});
+            return apply_dot(data(), v.data());
         }
 
         /**
          * @brief Calculate the length of the vector
          */
         T length() const {
-            return std::sqrt(this->dot(*this));
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4) {
+                const __m128 v = simd_load_ps<S>(data());
+                return _mm_cvtss_f32(_mm_sqrt_ss(simd_dot_ps<S>(v, v)));
+            }
+#endif
+            using std::sqrt;
+            return sqrt(this->dot(*this));
         }
 
         /**
@@ -1335,6 +2283,12 @@ namespace mgm {
          * @param v The vector to calculate the distance to
          */
         T distance_to(const vec<S, T>& v) const {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4) {
+                const __m128 d = _mm_sub_ps(simd_load_ps<S>(v.data()), simd_load_ps<S>(data()));
+                return _mm_cvtss_f32(_mm_sqrt_ss(simd_dot_ps<S>(d, d)));
+            }
+#endif
             return (v - *this).length();
         }
 
@@ -1344,7 +2298,18 @@ namespace mgm {
          * @return The normalized vector
          */
         vec<S, T> normalized() const {
-            return *this / this->length();
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4) {
+                MGMATH_PROFILE_COUNT(vec_normalize, T, true);
+                const __m128 v = simd_load_ps<S>(data());
+                vec<S, T> res;
+                MGMATH_CHECK_FLOATS_SCOPE("vec_normalize", res.data(), S, data(), S);
+                simd_store_ps<S>(res.data(), simd_div_sqrt_ps(v, simd_dot_ps<S>(v, v)));
+                return res;
+            }
+#endif
+            MGMATH_PROFILE_COUNT(vec_normalize, T, profile_simd_vec<S, T>());
+            return *this / this->length();
         }
 
         /**
@@ -1353,9 +2318,82 @@ namespace mgm {
          * @return A reference to this vector, after normalizing it
          */
         vec<S, T>& normalize() {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4) {
+                MGMATH_PROFILE_COUNT(vec_normalize, T, true);
+                MGMATH_CHECK_FLOATS_SCOPE("vec_normalize", data(), S, data(), S);
+                const __m128 v = simd_load_ps<S>(data());
+                simd_store_ps<S>(data(), simd_div_sqrt_ps(v, simd_dot_ps<S>(v, v)));
+                return *this;
+            }
+#endif
+            MGMATH_PROFILE_COUNT(vec_normalize, T, profile_simd_vec<S, T>());
             return *this /= this->length();
         }
 
+        /**
+         * @brief Add up all the components of the vector
+         */
+        T sum() const {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4)
+                return horizontal_sum(simd_load_ps<S>(data()));
+#endif
+            T res = data()[0];
+            for (luint i = 1; i < S; i++)
+                res += data()[i];
+            return res;
+        }
+
+        /**
+         * @brief Find the smallest component of the vector
+         */
+        T min_component() const {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4)
+                return _mm_cvtss_f32(simd_reduce_ps<vec_op::min, S>(simd_load_ps<S>(data())));
+#endif
+            T res = data()[0];
+            for (luint i = 1; i < S; i++)
+                res = data()[i] < res ? data()[i] : res;
+            return res;
+        }
+
+        /**
+         * @brief Find the largest component of the vector
+         */
+        T max_component() const {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4)
+                return _mm_cvtss_f32(simd_reduce_ps<vec_op::max, S>(simd_load_ps<S>(data())));
+#endif
+            T res = data()[0];
+            for (luint i = 1; i < S; i++)
+                res = data()[i] > res ? data()[i] : res;
+            return res;
+        }
+
+        /**
+         * @brief Find the index of the largest component of the vector (the first one, if there are multiple)
+         */
+        luint argmax() const {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && S >= 2 && S <= 4) {
+                const __m128 v = simd_load_ps<S>(data());
+                const int mask = _mm_movemask_ps(_mm_cmpeq_ps(v, simd_reduce_ps<vec_op::max, S>(v))) & ((1 << S) - 1);
+                for (luint i = 0; i < S; i++)
+                    if (mask & (1 << i))
+                        return i;
+                return 0;
+            }
+#endif
+            luint res = 0;
+            for (luint i = 1; i < S; i++)
+                if (data()[i] > data()[res])
+                    res = i;
+            return res;
+        }
+
         /**
          * @brief Return the direction from this vector to another
          *
@@ -1373,7 +2411,7 @@ namespace mgm {
          */
         static vec<S, T> max(const vec<S, T>& v1, const vec<S, T>& v2) {
             vec<S, T> res;
-            max(v1.data(), v2.data(), res.data(), IntList<S>{});
+            apply<vec_op::max>(v1.data(), v2.data(), res.data());
             return res;
         }
 
@@ -1385,7 +2423,120 @@ namespace mgm {
          */
         static vec<S, T> min(const vec<S, T>& v1, const vec<S, T>& v2) {
             vec<S, T> res;
-            min(v1.data(), v2.data(), res.data(), IntList<S>{});
+            apply<vec_op::min>(v1.data(), v2.data(), res.data());
+            return res;
+        }
+
+        /**
+         * @brief Multiply two vectors and add a third `a * b + c`, rounding every component only once (slow if the target has no hardware FMA)
+         *
+         * @param a The first vector to multiply
+         * @param b The second vector to multiply
+         * @param c The vector to add to the product
+         */
+        static vec<S, T> fma(const vec<S, T>& a, const vec<S, T>& b, const vec<S, T>& c) {
+            vec<S, T> res;
+            apply_mad<true>(a.data(), b.data(), c.data(), res.data());
+            return res;
+        }
+        /**
+         * @brief Multiply a vector by a scalar and add another vector `a * k + c`, rounding every component only once (slow if the target has no hardware FMA)
+         *
+         * @param a The vector to multiply
+         * @param k The scalar to multiply by
+         * @param c The vector to add to the product
+         */
+        static vec<S, T> fma(const vec<S, T>& a, const T& k, const vec<S, T>& c) {
+            return fma(a, vec<S, T>(k), c);
+        }
+
+        /**
+         * @brief Multiply two vectors and add a third `a * b + c`, fused into single instructions only if the target has hardware FMA
+         *
+         * Always fast, but the last bit of the result may differ between targets. Use fma when the single rounding is required
+         *
+         * @param a The first vector to multiply
+         * @param b The second vector to multiply
+         * @param c The vector to add to the product
+         */
+        static vec<S, T> mad(const vec<S, T>& a, const vec<S, T>& b, const vec<S, T>& c) {
+            vec<S, T> res;
+            apply_mad<false>(a.data(), b.data(), c.data(), res.data());
+            return res;
+        }
+        /**
+         * @brief Multiply a vector by a scalar and add another vector `a * k + c`, fused into single instructions only if the target has hardware FMA
+         *
+         * @param a The vector to multiply
+         * @param k The scalar to multiply by
+         * @param c The vector to add to the product
+         */
+        static vec<S, T> mad(const vec<S, T>& a, const T& k, const vec<S, T>& c) {
+            return mad(a, vec<S, T>(k), c);
+        }
+
+        /**
+         * @brief Compare every component of this vector to the same component of another (integer vectors only)
+         *
+         * @param v The vector to compare to
+         * @return A vector with all bits set in the components where this vector is less than the other, and zero in the rest
+         */
+        vec<S, T> less_mask(const vec<S, T>& v) const {
+            static_assert(std::is_integral_v<T>, "Component masks are only available for integer vectors");
+            vec<S, T> res;
+            apply<vec_op::less>(data(), v.data(), res.data());
+            return res;
+        }
+
+        /**
+         * @brief Compare every component of this vector to the same component of another (integer vectors only)
+         *
+         * @param v The vector to compare to
+         * @return A vector with all bits set in the components where this vector is greater than the other, and zero in the rest
+         */
+        vec<S, T> greater_mask(const vec<S, T>& v) const {
+            static_assert(std::is_integral_v<T>, "Component masks are only available for integer vectors");
+            vec<S, T> res;
+            apply<vec_op::greater>(data(), v.data(), res.data());
+            return res;
+        }
+
+        /**
+         * @brief Compare every component of this vector to the same component of another (integer vectors only)
+         *
+         * @param v The vector to compare to
+         * @return A vector with all bits set in the components that are equal in both vectors, and zero in the rest
+         */
+        vec<S, T> equal_mask(const vec<S, T>& v) const {
+            static_assert(std::is_integral_v<T>, "Component masks are only available for integer vectors");
+            vec<S, T> res;
+            apply<vec_op::equal>(data(), v.data(), res.data());
+            return res;
+        }
+
+        /**
+         * @brief Add two integer vectors, clamping every component to the range of the type instead of wrapping around
+         *
+         * @param v1 The first vector
+         * @param v2 The second vector
+         */
+        static vec<S, T> add_saturated(const vec<S, T>& v1, const vec<S, T>& v2) {
+            static_assert(std::is_integral_v<T>, "Saturating arithmetic is only available for integer vectors");
+            vec<S, T> res;
+            apply<vec_op::add_saturated>(v1.data(), v2.data(), res.data());
+            return res;
+        }
+
+        /**
+         * @brief Subtract two integer vectors, clamping every component to the range of the type instead of wrapping around
+         *
+         * @param v1 The first vector
+         * @param v2 The second vector
+         */
+        static vec<S, T> sub_saturated(const vec<S, T>& v1, const vec<S, T>& v2) {
+            static_assert(std::is_integral_v<T>, "Saturating arithmetic is only available for integer vectors");
+            vec<S, T> res;
+            apply<vec_op::sub_saturated>(v1.data(), v2.data(), res.data());
             return res;
         }
 
@@ -1420,9 +2571,58 @@ namespace mgm {
          * @return The result of the interpolation
          */
         vec<S, T> lerp(const vec<S, T>& destination, T weight) const {
-            return *this + weight * (destination - *this);
+            return mad(destination - *this, weight, *this);
+        }
+    };
+
+#if defined(MGMATH_SWIZZLE)
+    /**
+     * @brief The result of `ref<I...>()`, usable as a normal vector, but assigning to it writes the components back into the source vector (`v.ref<2, 0>() = {1, 2}`)
+     *
+     * It can't be copied or moved, and only a temporary can be assigned to, so it only writes back within the statement that created it
+     *
+     * @tparam S The size of the source vector
+     * @tparam T The type of the components
+     * @tparam I The indices of the swizzled components in the source vector
+     */
+    template<luint S, typename T, luint... I>
+    class swizzle_ref : public vec<sizeof...(I), T> {
+        vec<S, T>* source;
+
+        template<luint... J>
+        static constexpr bool distinct() {
+            constexpr luint idx[] = {J...};
+            for (luint i = 0; i < sizeof...(J); ++i)
+                for (luint j = i + 1; j < sizeof...(J); ++j)
+                    if (idx[i] == idx[j])
+                        return false;
+            return true;
+        }
+
+        void assign(const vec<sizeof...(I), T>& v) {
+            static_assert(distinct<I...>(), "Cannot assign to a swizzle with repeated components");
+            for (luint i = 0; i < sizeof...(I); ++i)
+                this->data()[i] = v.data()[i];
+            luint i = 0;
+            ((source->data()[I] = this->data()[i++]), ...);
         }
+
+      public:
+        explicit swizzle_ref(vec<S, T>& src)
+            : vec<sizeof...(I), T>{src.data()[I]...}, source{&src} {}
+
+        swizzle_ref(const swizzle_ref&) = delete;
+        swizzle_ref(swizzle_ref&&) = delete;
+
+        void operator=(const vec<sizeof...(I), T>& v) && { assign(v); }
+        void operator=(const swizzle_ref& v) && { assign(v); }
+
+        void operator+=(const vec<sizeof...(I), T>& v) && { assign(*this + v); }
+        void operator-=(const vec<sizeof...(I), T>& v) && { assign(*this - v); }
+        void operator*=(const vec<sizeof...(I), T>& v) && { assign(*this * v); }
+        void operator/=(const vec<sizeof...(I), T>& v) && { assign(*this / v); }
     };
+#endif
 
 #if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
     template<>
@@ -1442,6 +2642,7 @@ namespace mgm {
         const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(v.data()));
         const __m128 res = _mm_add_ps(a, b);
         vec<2, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_add", r.data(), 2, data(), 2, v.data(), 2);
         _mm_storel_pi(reinterpret_cast<__m64*>(r.data()), res);
         return r;
     }
@@ -1451,6 +2652,7 @@ namespace mgm {
         const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(v.data()));
         const __m128 res = _mm_sub_ps(a, b);
         vec<2, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_sub", r.data(), 2, data(), 2, v.data(), 2);
         _mm_storel_pi(reinterpret_cast<__m64*>(r.data()), res);
         return r;
     }
@@ -1460,6 +2662,7 @@ namespace mgm {
         const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(v.data()));
         const __m128 res = _mm_mul_ps(a, b);
         vec<2, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_mul", r.data(), 2, data(), 2, v.data(), 2);
         _mm_storel_pi(reinterpret_cast<__m64*>(r.data()), res);
         return r;
     }
@@ -1469,11 +2672,13 @@ namespace mgm {
         const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(v.data()));
         const __m128 res = _mm_div_ps(a, b);
         vec<2, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_div", r.data(), 2, data(), 2, v.data(), 2);
         _mm_storel_pi(reinterpret_cast<__m64*>(r.data()), res);
         return r;
     }
     template<>
     inline vec<2, float>& vec<2, float>::operator+=(const vec<2, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_add", data(), 2, data(), 2, v.data(), 2);
         const __m128 a = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(data()));
         const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(v.data()));
         const __m128 res = _mm_add_ps(a, b);
@@ -1482,6 +2687,7 @@ namespace mgm {
     }
     template<>
     inline vec<2, float>& vec<2, float>::operator-=(const vec<2, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_sub", data(), 2, data(), 2, v.data(), 2);
         const __m128 a = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(data()));
         const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(v.data()));
         const __m128 res = _mm_sub_ps(a, b);
@@ -1490,6 +2696,7 @@ namespace mgm {
     }
     template<>
     inline vec<2, float>& vec<2, float>::operator*=(const vec<2, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_mul", data(), 2, data(), 2, v.data(), 2);
         const __m128 a = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(data()));
         const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(v.data()));
         const __m128 res = _mm_mul_ps(a, b);
@@ -1498,6 +2705,7 @@ namespace mgm {
     }
     template<>
     inline vec<2, float>& vec<2, float>::operator/=(const vec<2, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_div", data(), 2, data(), 2, v.data(), 2);
         const __m128 a = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(data()));
         const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(v.data()));
         const __m128 res = _mm_div_ps(a, b);
@@ -1531,6 +2739,7 @@ namespace mgm {
         const __m128 b = _mm_set_ps(0, v.data()[2], v.data()[1], v.data()[0]);
         const __m128 res = _mm_add_ps(a, b);
         vec<3, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_add", r.data(), 3, data(), 3, v.data(), 3);
         memcpy(r.data(), &res, sizeof(float) * 3);
         return r;
     }
@@ -1540,6 +2749,7 @@ namespace mgm {
         const __m128 b = _mm_set_ps(0, v.data()[2], v.data()[1], v.data()[0]);
         const __m128 res = _mm_sub_ps(a, b);
         vec<3, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_sub", r.data(), 3, data(), 3, v.data(), 3);
         memcpy(r.data(), &res, sizeof(float) * 3);
         return r;
     }
@@ -1549,6 +2759,7 @@ namespace mgm {
         const __m128 b = _mm_set_ps(0, v.data()[2], v.data()[1], v.data()[0]);
         const __m128 res = _mm_mul_ps(a, b);
         vec<3, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_mul", r.data(), 3, data(), 3, v.data(), 3);
         memcpy(r.data(), &res, sizeof(float) * 3);
         return r;
     }
@@ -1558,11 +2769,13 @@ namespace mgm {
         const __m128 b = _mm_set_ps(0, v.data()[2], v.data()[1], v.data()[0]);
         const __m128 res = _mm_div_ps(a, b);
         vec<3, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_div", r.data(), 3, data(), 3, v.data(), 3);
         memcpy(r.data(), &res, sizeof(float) * 3);
         return r;
     }
     template<>
     inline vec<3, float>& vec<3, float>::operator+=(const vec<3, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_add", data(), 3, data(), 3, v.data(), 3);
         const __m128 a = _mm_set_ps(0, data()[2], data()[1], data()[0]);
         const __m128 b = _mm_set_ps(0, v.data()[2], v.data()[1], v.data()[0]);
         const __m128 res = _mm_add_ps(a, b);
@@ -1571,6 +2784,7 @@ namespace mgm {
     }
     template<>
     inline vec<3, float>& vec<3, float>::operator-=(const vec<3, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_sub", data(), 3, data(), 3, v.data(), 3);
         const __m128 a = _mm_set_ps(0, data()[2], data()[1], data()[0]);
         const __m128 b = _mm_set_ps(0, v.data()[2], v.data()[1], v.data()[0]);
         const __m128 res = _mm_sub_ps(a, b);
@@ -1579,6 +2793,7 @@ namespace mgm {
     }
     template<>
     inline vec<3, float>& vec<3, float>::operator*=(const vec<3, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_mul", data(), 3, data(), 3, v.data(), 3);
         const __m128 a = _mm_set_ps(0, data()[2], data()[1], data()[0]);
         const __m128 b = _mm_set_ps(0, v.data()[2], v.data()[1], v.data()[0]);
         const __m128 res = _mm_mul_ps(a, b);
@@ -1587,6 +2802,7 @@ namespace mgm {
     }
     template<>
     inline vec<3, float>& vec<3, float>::operator/=(const vec<3, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_div", data(), 3, data(), 3, v.data(), 3);
         const __m128 a = _mm_set_ps(0, data()[2], data()[1], data()[0]);
         const __m128 b = _mm_set_ps(0, v.data()[2], v.data()[1], v.data()[0]);
         const __m128 res = _mm_div_ps(a, b);
@@ -1620,6 +2836,7 @@ namespace mgm {
         const __m128 b = _mm_loadu_ps(v.data());
         const __m128 res = _mm_add_ps(a, b);
         vec<4, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_add", r.data(), 4, data(), 4, v.data(), 4);
         _mm_storeu_ps(r.data(), res);
         return r;
     }
@@ -1629,6 +2846,7 @@ namespace mgm {
         const __m128 b = _mm_loadu_ps(v.data());
         const __m128 res = _mm_sub_ps(a, b);
         vec<4, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_sub", r.data(), 4, data(), 4, v.data(), 4);
         _mm_storeu_ps(r.data(), res);
         return r;
     }
@@ -1638,6 +2856,7 @@ namespace mgm {
         const __m128 b = _mm_loadu_ps(v.data());
         const __m128 res = _mm_mul_ps(a, b);
         vec<4, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_mul", r.data(), 4, data(), 4, v.data(), 4);
         _mm_storeu_ps(r.data(), res);
         return r;
     }
@@ -1647,11 +2866,13 @@ namespace mgm {
         const __m128 b = _mm_loadu_ps(v.data());
         const __m128 res = _mm_div_ps(a, b);
         vec<4, float> r;
+        MGMATH_CHECK_FLOATS_SCOPE("vec_div", r.data(), 4, data(), 4, v.data(), 4);
         _mm_storeu_ps(r.data(), res);
         return r;
     }
     template<>
     inline vec<4, float>& vec<4, float>::operator+=(const vec<4, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_add", data(), 4, data(), 4, v.data(), 4);
         const __m128 a = _mm_loadu_ps(data());
         const __m128 b = _mm_loadu_ps(v.data());
         const __m128 res = _mm_add_ps(a, b);
@@ -1660,6 +2881,7 @@ namespace mgm {
     }
     template<>
     inline vec<4, float>& vec<4, float>::operator-=(const vec<4, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_sub", data(), 4, data(), 4, v.data(), 4);
         const __m128 a = _mm_loadu_ps(data());
         const __m128 b = _mm_loadu_ps(v.data());
         const __m128 res = _mm_sub_ps(a, b);
@@ -1668,6 +2890,7 @@ namespace mgm {
     }
     template<>
     inline vec<4, float>& vec<4, float>::operator*=(const vec<4, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_mul", data(), 4, data(), 4, v.data(), 4);
         const __m128 a = _mm_loadu_ps(data());
         const __m128 b = _mm_loadu_ps(v.data());
         const __m128 res = _mm_mul_ps(a, b);
@@ -1676,6 +2899,7 @@ namespace mgm {
     }
     template<>
     inline vec<4, float>& vec<4, float>::operator/=(const vec<4, float>& v) {
+        MGMATH_CHECK_FLOATS_SCOPE("vec_div", data(), 4, data(), 4, v.data(), 4);
         const __m128 a = _mm_loadu_ps(data());
         const __m128 b = _mm_loadu_ps(v.data());
         const __m128 res = _mm_div_ps(a, b);
@@ -1739,11 +2963,158 @@ namespace mgm {
     using vec3i64 = vec<3, int64>;
     using vec4i64 = vec<4, int64>;
 
+    /**
+     * @brief Add two arrays of integer vectors, clamping every component to the range of the type instead of wrapping around (SIMD accelerated for 8 and 16-bit components)
+     *
+     * @param dst The array to write the results to (can be the same as one of the sources)
+     * @param a The first array of vectors
+     * @param b The second array of vectors
+     * @param count The number of vectors in each array
+     */
+    template<luint S, typename T>
+    inline void add_saturated(vec<S, T>* dst, const vec<S, T>* a, const vec<S, T>* b, const luint count) {
+        static_assert(std::is_integral_v<T>, "Saturating arithmetic is only available for integer vectors");
+        MGMATH_PROFILE_BATCH(batch_saturated, T, count, profile_simd_build && sizeof(T) <= 2);
+        saturated_loop<vec_op::add_saturated>(reinterpret_cast<const T*>(a), reinterpret_cast<const T*>(b), reinterpret_cast<T*>(dst), S * count);
+    }
+
+    /**
+     * @brief Subtract two arrays of integer vectors, clamping every component to the range of the type instead of wrapping around (SIMD accelerated for 8 and 16-bit components)
+     *
+     * @param dst The array to write the results to (can be the same as one of the sources)
+     * @param a The array of vectors to subtract from
+     * @param b The array of vectors to subtract
+     * @param count The number of vectors in each array
+     */
+    template<luint S, typename T>
+    inline void sub_saturated(vec<S, T>* dst, const vec<S, T>* a, const vec<S, T>* b, const luint count) {
+        static_assert(std::is_integral_v<T>, "Saturating arithmetic is only available for integer vectors");
+        MGMATH_PROFILE_BATCH(batch_saturated, T, count, profile_simd_build && sizeof(T) <= 2);
+        saturated_loop<vec_op::sub_saturated>(reinterpret_cast<const T*>(a), reinterpret_cast<const T*>(b), reinterpret_cast<T*>(dst), S * count);
+    }
+
 
     //==========
     // MATRICES
     //==========
 
+    // Matrix products with at least this many lines, columns and inner components use the blocked kernel
+#if !defined(MGMATH_BLOCKED_MUL_LIMIT)
+#define MGMATH_BLOCKED_MUL_LIMIT 8
+#endif
+
+    /**
+     * @brief Accumulate the product of 4 lines of a and W columns of b, between two inner indices, into the same tile of r
+     *
+     * @tparam K The number of columns of a
+     * @tparam N The number of columns of b and r
+     * @param a The first of the 4 lines of a
+     * @param b The first column of the tile in b
+     * @param r The first column of the tile in the first of the 4 lines of r
+     */
+    template<luint K, luint N, luint W, typename T>
+    inline void mat_mul_tile(const T* a, const T* b, T* r, const luint k0, const luint k1) {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        if constexpr (std::is_same_v<T, float> && W == 8) {
+            __m256 r0 = _mm256_loadu_ps(r), r1 = _mm256_loadu_ps(r + N), r2 = _mm256_loadu_ps(r + 2 * N), r3 = _mm256_loadu_ps(r + 3 * N);
+            for (luint k = k0; k < k1; k++) {
+                const __m256 line = _mm256_loadu_ps(b + k * N);
+                r0 = simd_mad(_mm256_set1_ps(a[k]), line, r0);
+                r1 = simd_mad(_mm256_set1_ps(a[K + k]), line, r1);
+                r2 = simd_mad(_mm256_set1_ps(a[2 * K + k]), line, r2);
+                r3 = simd_mad(_mm256_set1_ps(a[3 * K + k]), line, r3);
+            }
+            _mm256_storeu_ps(r, r0);
+            _mm256_storeu_ps(r + N, r1);
+            _mm256_storeu_ps(r + 2 * N, r2);
+            _mm256_storeu_ps(r + 3 * N, r3);
+            return;
+        }
+        else if constexpr (std::is_same_v<T, double> && W == 4) {
+            __m256d r0 = _mm256_loadu_pd(r), r1 = _mm256_loadu_pd(r + N), r2 = _mm256_loadu_pd(r + 2 * N), r3 = _mm256_loadu_pd(r + 3 * N);
+            for (luint k = k0; k < k1; k++) {
+                const __m256d line = _mm256_loadu_pd(b + k * N);
+                r0 = simd_mad(_mm256_set1_pd(a[k]), line, r0);
+                r1 = simd_mad(_mm256_set1_pd(a[K + k]), line, r1);
+                r2 = simd_mad(_mm256_set1_pd(a[2 * K + k]), line, r2);
+                r3 = simd_mad(_mm256_set1_pd(a[3 * K + k]), line, r3);
+            }
+            _mm256_storeu_pd(r, r0);
+            _mm256_storeu_pd(r + N, r1);
+            _mm256_storeu_pd(r + 2 * N, r2);
+            _mm256_storeu_pd(r + 3 * N, r3);
+            return;
+        }
+#endif
+        if constexpr (std::is_same_v<T, float> && W == 4) {
+            __m128 r0 = _mm_loadu_ps(r), r1 = _mm_loadu_ps(r + N), r2 = _mm_loadu_ps(r + 2 * N), r3 = _mm_loadu_ps(r + 3 * N);
+            for (luint k = k0; k < k1; k++) {
+                const __m128 line = _mm_loadu_ps(b + k * N);
+                r0 = simd_mad(_mm_set1_ps(a[k]), line, r0);
+                r1 = simd_mad(_mm_set1_ps(a[K + k]), line, r1);
+                r2 = simd_mad(_mm_set1_ps(a[2 * K + k]), line, r2);
+                r3 = simd_mad(_mm_set1_ps(a[3 * K + k]), line, r3);
+            }
+            _mm_storeu_ps(r, r0);
+            _mm_storeu_ps(r + N, r1);
+            _mm_storeu_ps(r + 2 * N, r2);
+            _mm_storeu_ps(r + 3 * N, r3);
+            return;
+        }
+#endif
+        T acc[4][W];
+        for (luint i = 0; i < 4; i++)
+            for (luint j = 0; j < W; j++)
+                acc[i][j] = r[i * N + j];
+        for (luint k = k0; k < k1; k++)
+            for (luint i = 0; i < 4; i++)
+                for (luint j = 0; j < W; j++)
+                    acc[i][j] = mad(a[i * K + k], b[k * N + j], acc[i][j]);
+        for (luint i = 0; i < 4; i++)
+            for (luint j = 0; j < W; j++)
+                r[i * N + j] = acc[i][j];
+    }
+
+    /**
+     * @brief Multiply two row major matrices (L x K by K x N)
+     *
+     * The result is computed in tiles of 4 lines, kept in registers while going through a block of the inner dimension,
+     * and the blocks of columns and inner components are small enough for the part of b they use to stay in cache
+     */
+    template<luint L, luint K, luint N, typename T>
+    inline void blocked_mat_mul(const T* a, const T* b, T* r) {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(__AVX__)
+        constexpr luint tile = std::is_same_v<T, float> ? 8 : 4;
+#else
+        constexpr luint tile = 4;
+#endif
+        constexpr luint k_block = 128, n_block = 64;
+        for (luint i = 0; i < L * N; i++)
+            r[i] = T(0);
+
+        for (luint k0 = 0; k0 < K; k0 += k_block) {
+            const luint k1 = k0 + k_block < K ? k0 + k_block : K;
+            for (luint j0 = 0; j0 < N; j0 += n_block) {
+                const luint j1 = j0 + n_block < N ? j0 + n_block : N;
+                const luint tiled = j0 + (j1 - j0) / tile * tile;
+                luint i = 0;
+                for (; i + 4 <= L; i += 4) {
+                    for (luint j = j0; j < tiled; j += tile)
+                        mat_mul_tile<K, N, tile>(a + i * K, b + j, r + i * N + j, k0, k1);
+                    for (luint ii = i; ii < i + 4; ii++)
+                        for (luint k = k0; k < k1; k++)
+                            for (luint j = tiled; j < j1; j++)
+                                r[ii * N + j] = mad(a[ii * K + k], b[k * N + j], r[ii * N + j]);
+                }
+                for (; i < L; i++)
+                    for (luint k = k0; k < k1; k++)
+                        for (luint j = j0; j < j1; j++)
+                            r[i * N + j] = mad(a[i * K + k], b[k * N + j], r[i * N + j]);
+            }
+        }
+    }
+
     template<luint l, luint c, typename T>
     class mat {
         template<class... Ts>
@@ -1779,7 +3150,7 @@ namespace mgm {
         }
 
         explicit mat(const T* k) {
-            memcpy(data, k, l * c * sizeof(T));
+            memcpy(data[0].data(), k, l * c * sizeof(T));
         }
 
         vec<c, T>& operator[](const luint i) {
@@ -1809,10 +3180,34 @@ namespace mgm {
         template<luint l2, luint c2, typename std::enable_if<c == l2, int>::type = 0>
         mat<l, c2, T> operator*(const mat<l2, c2, T>& m) const {
             mat<l, c2, T> res{};
+            MGMATH_CHECK_FLOATS_SCOPE("mat_mul", res[0].data(), l * c2, data[0].data(), l * c, m[0].data(), l2 * c2);
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, double> && l == 4 && c == 4 && c2 == 4) {
+                MGMATH_PROFILE_COUNT(mat_mul, T, true);
+                simd_mat4d_mul(data[0].data(), m[0].data(), res[0].data());
+                return res;
+            }
+#endif
+            MGMATH_PROFILE_COUNT(mat_mul, T, profile_simd_vec<c2, T>());
+            if constexpr (l >= MGMATH_BLOCKED_MUL_LIMIT && c >= MGMATH_BLOCKED_MUL_LIMIT && c2 >= MGMATH_BLOCKED_MUL_LIMIT) {
+                blocked_mat_mul<l, c, c2>(data[0].data(), m[0].data(), res[0].data());
+                return res;
+            }
+            for (luint i = 0; i < l; i++)
+                for (luint k = 0; k < c; k++)
+                    res[i] = vec<c2, T>::mad(m[k], data[i][k], res[i]);
+            return res;
+        }
+
+        /**
+         * @brief Transform a vector by this matrix (`M * v`, with v as a column vector)
+         */
+        vec<l, T> operator*(const vec<c, T>& v) const {
+            MGMATH_PROFILE_COUNT(mat_transform, T, profile_simd_vec<c, T>());
+            vec<l, T> res;
+            MGMATH_CHECK_FLOATS_SCOPE("mat_transform", res.data(), l, data[0].data(), l * c, v.data(), c);
             for (luint i = 0; i < l; i++)
-                for (luint j = 0; j < c2; j++)
-                    for (luint k = 0; k < c; k++)
-                        res[i][j] += data[i][k] * m[k][j];
+                res[i] = data[i].dot(v);
             return res;
         }
 
@@ -1838,6 +3233,14 @@ namespace mgm {
          */
         mat<c, l, T> transposed() const {
             mat<c, l, T> res{};
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            if constexpr (std::is_same_v<T, float> && l == 4 && c == 4) {
+                MGMATH_PROFILE_COUNT(mat_transpose, T, true);
+                simd_transpose_mat4f(data[0].data(), res[0].data());
+                return res;
+            }
+#endif
+            MGMATH_PROFILE_COUNT(mat_transpose, T, false);
             for (luint i = 0; i < c; i++)
                 for (luint j = 0; j < l; j++)
                     res[i][j] = data[j][i];
@@ -1869,9 +3272,9 @@ namespace mgm {
             bool ff = false;
             for (luint i = 0; i < c; i++) {
                 if (ff)
-                    res -= data[i][0] * submat(vec2u64(i, 0)).det();
+                    res -= data[0][i] * submat(vec2u64(i, 0)).det();
                 else
-                    res += data[i][0] * submat(vec2u64(i, 0)).det();
+                    res += data[0][i] * submat(vec2u64(i, 0)).det();
                 ff = !ff;
             }
             return res;
@@ -1885,6 +3288,60 @@ namespace mgm {
             return data[0][0] * data[1][1] - data[0][1] * data[1][0];
         }
 
+        /**
+         * @brief Calculate the inverse of the matrix, using Gauss-Jordan elimination with partial pivoting
+         */
+        template<luint Lines = l, luint Columns = c, class Type = T, typename std::enable_if<Lines == Columns && (std::is_same<Type, float>::value || std::is_same<Type, double>::value), int>::type = 0>
+        mat<l, c, T> inverse() const {
+            MGMATH_PROFILE_COUNT(mat_inverse, T, profile_simd_vec<c, T>());
+            mat<l, c, T> a = *this, res(T(1));
+            MGMATH_CHECK_FLOATS_SCOPE("mat_inverse", res[0].data(), l * c, data[0].data(), l * c);
+            for (luint col = 0; col < c; col++) {
+                luint pivot = col;
+                for (luint i = col + 1; i < l; i++)
+                    if (std::abs(a[i][col]) > std::abs(a[pivot][col]))
+                        pivot = i;
+                if (a[pivot][col] == T(0))
+                    throw std::runtime_error("Cannot invert singular matrix");
+                if (pivot != col) {
+                    std::swap(a[col], a[pivot]);
+                    std::swap(res[col], res[pivot]);
+                }
+
+                const T inv_pivot = T(1) / a[col][col];
+                a[col] *= inv_pivot;
+                res[col] *= inv_pivot;
+                for (luint i = 0; i < l; i++) {
+                    if (i == col)
+                        continue;
+                    const T factor = -a[i][col];
+                    a[i] = vec<c, T>::mad(a[col], factor, a[i]);
+                    res[i] = vec<c, T>::mad(res[col], factor, res[i]);
+                }
+            }
+            return res;
+        }
+
+        /**
+         * @brief Make the columns of a square float or double matrix orthonormal again (modified Gram-Schmidt), to fix the drift of a rotation matrix after many products
+         *
+         * The first column keeps its direction, and the determinant keeps its sign. Throws if the columns are linearly dependent
+         */
+        template<luint Lines = l, luint Columns = c, class Type = T, typename std::enable_if<Lines == Columns && (std::is_same<Type, float>::value || std::is_same<Type, double>::value), int>::type = 0>
+        mat<l, c, T> orthonormalized() const {
+            // The columns are the lines of the transposed matrix
+            mat<l, c, T> res = transposed();
+            for (luint i = 0; i < l; i++) {
+                for (luint k = 0; k < i; k++)
+                    res[i] = vec<c, T>::mad(res[k], -res[k].dot(res[i]), res[i]);
+                const T len = res[i].length();
+                if (len == T(0))
+                    throw std::runtime_error("Cannot orthonormalize matrix with linearly dependent columns");
+                res[i] *= T(1) / len;
+            }
+            return res.transposed();
+        }
+
         /**
          * @brief Generate a 2D rotation matrix with angle and scale (scale is 1.0)
          *
@@ -2120,6 +3577,169 @@ namespace mgm {
         }
     };
 
+    /**
+     * @brief A matrix stored column by column (the layout OpenGL and Vulkan expect), so `[i]` returns the i-th column
+     *
+     * Products, transforms and the inverse give the same results as for the same matrix stored in a `mat`,
+     * and the memory can be uploaded as is
+     *
+     * @tparam l The number of lines
+     * @tparam c The number of columns
+     */
+    template<luint l, luint c, typename T>
+    class mat_cm {
+      public:
+        vec<l, T> data[c];
+
+        mat_cm(const mat_cm<l, c, T>&) = default;
+        mat_cm(mat_cm<l, c, T>&&) = default;
+        mat_cm& operator=(const mat_cm<l, c, T>&) = default;
+        mat_cm& operator=(mat_cm<l, c, T>&&) = default;
+
+        explicit mat_cm(const T x = T()) {
+            for (luint i = 0; i < l && i < c; i++)
+                data[i][i] = x;
+        }
+
+        /**
+         * @brief Copy a matrix from memory, in column-major order
+         */
+        explicit mat_cm(const T* k) {
+            memcpy(data[0].data(), k, l * c * sizeof(T));
+        }
+
+        /**
+         * @brief Store a row-major matrix column by column
+         */
+        explicit mat_cm(const mat<l, c, T>& m)
+            : mat_cm(m.transposed()[0].data()) {}
+
+        /**
+         * @brief Convert back to the row-major `mat`
+         */
+        mat<l, c, T> to_row_major() const {
+            return mat<c, l, T>(data[0].data()).transposed();
+        }
+
+        vec<l, T>& operator[](const luint i) {
+            if (i < c)
+                return data[i];
+            return data[c - 1];
+        }
+        const vec<l, T>& operator[](const luint i) const {
+            if (i < c)
+                return data[i];
+            return data[c - 1];
+        }
+
+        mat_cm<l, c, T> operator+(const mat_cm<l, c, T>& m) const {
+            mat_cm<l, c, T> res{};
+            for (luint i = 0; i < c; i++)
+                res[i] = data[i] + m[i];
+            return res;
+        }
+        mat_cm<l, c, T> operator-(const mat_cm<l, c, T>& m) const {
+            mat_cm<l, c, T> res{};
+            for (luint i = 0; i < c; i++)
+                res[i] = data[i] - m[i];
+            return res;
+        }
+
+        template<luint l2, luint c2, typename std::enable_if<c == l2, int>::type = 0>
+        mat_cm<l, c2, T> operator*(const mat_cm<l2, c2, T>& m) const {
+            mat_cm<l, c2, T> res{};
+            MGMATH_CHECK_FLOATS_SCOPE("mat_mul", res[0].data(), l * c2, data[0].data(), l * c, m[0].data(), l2 * c2);
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+            // The storage of a column-major matrix is its row-major transpose, and (A * B)^T = B^T * A^T
+            if constexpr (std::is_same_v<T, double> && l == 4 && c == 4 && c2 == 4) {
+                MGMATH_PROFILE_COUNT(mat_mul, T, true);
+                simd_mat4d_mul(m[0].data(), data[0].data(), res[0].data());
+                return res;
+            }
+#endif
+            MGMATH_PROFILE_COUNT(mat_mul, T, profile_simd_vec<l, T>());
+            for (luint j = 0; j < c2; j++)
+                for (luint k = 0; k < c; k++)
+                    res[j] = vec<l, T>::mad(data[k], m[j][k], res[j]);
+            return res;
+        }
+
+        /**
+         * @brief Transform a vector by this matrix (`M * v`, with v as a column vector)
+         */
+        vec<l, T> operator*(const vec<c, T>& v) const {
+            MGMATH_PROFILE_COUNT(mat_transform, T, profile_simd_vec<l, T>());
+            vec<l, T> res{};
+            MGMATH_CHECK_FLOATS_SCOPE("mat_transform", res.data(), l, data[0].data(), l * c, v.data(), c);
+            for (luint k = 0; k < c; k++)
+                res = vec<l, T>::mad(data[k], v[k], res);
+            return res;
+        }
+
+        mat_cm<l, c, T>& operator+=(const mat_cm<l, c, T>& m) {
+            for (luint i = 0; i < c; i++)
+                data[i] += m[i];
+            return *this;
+        }
+        mat_cm<l, c, T>& operator-=(const mat_cm<l, c, T>& m) {
+            for (luint i = 0; i < c; i++)
+                data[i] -= m[i];
+            return *this;
+        }
+
+        vec<l, T>* begin() { return data; }
+        vec<l, T>* end() { return data + c; }
+
+        const vec<l, T>* begin() const { return data; }
+        const vec<l, T>* end() const { return data + c; }
+
+        /**
+         * @brief Return a transposed version of the matrix
+         */
+        mat_cm<c, l, T> transposed() const {
+            return mat_cm<c, l, T>(mat<c, l, T>(data[0].data()));
+        }
+
+        /**
+         * @brief Calculate the inverse of the matrix, using Gauss-Jordan elimination with partial pivoting
+         */
+        template<luint Lines = l, luint Columns = c, class Type = T, typename std::enable_if<Lines == Columns && (std::is_same<Type, float>::value || std::is_same<Type, double>::value), int>::type = 0>
+        mat_cm<l, c, T> inverse() const {
+            // The inverse of the transpose is the transpose of the inverse, so the storage can be inverted as a row-major matrix
+            return mat_cm<l, c, T>(mat<c, l, T>(data[0].data()).inverse()[0].data());
+        }
+    };
+
+    /**
+     * @brief Transpose an array of matrices
+     *
+     * @param dst The array to write the transposed matrices to
+     * @param src The matrices to transpose
+     * @param count The number of matrices
+     */
+    template<luint l, luint c, typename T>
+    inline void transpose_into(mat<c, l, T>* dst, const mat<l, c, T>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_transpose, T, count, profile_simd_build && std::is_same_v<T, float> && l == 4 && c == 4);
+        MGMATH_CHECK_FLOATS_SCOPE("transpose_into", reinterpret_cast<const T*>(dst), count * l * c, reinterpret_cast<const T*>(src), count * l * c);
+        for (luint i = 0; i < count; i++)
+            dst[i] = src[i].transposed();
+    }
+
+    /**
+     * @brief Store an array of row-major matrices column by column, for example to upload instance data to the GPU
+     *
+     * @param dst The array to write the column-major matrices to
+     * @param src The row-major matrices
+     * @param count The number of matrices
+     */
+    template<luint l, luint c, typename T>
+    inline void transpose_into(mat_cm<l, c, T>* dst, const mat<l, c, T>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_transpose, T, count, profile_simd_build && std::is_same_v<T, float> && l == 4 && c == 4);
+        MGMATH_CHECK_FLOATS_SCOPE("transpose_into", reinterpret_cast<const T*>(dst), count * l * c, reinterpret_cast<const T*>(src), count * l * c);
+        for (luint i = 0; i < count; i++)
+            dst[i] = mat_cm<l, c, T>(src[i]);
+    }
+
     using mat2f = mat<2, 2, float>;
     using mat3f = mat<3, 3, float>;
     using mat4f = mat<4, 4, float>;
@@ -2155,35 +3775,270 @@ namespace mgm {
     using mat3i64 = mat<3, 3, int64>;
     using mat4i64 = mat<4, 4, int64>;
 
+    using mat2f_cm = mat_cm<2, 2, float>;
+    using mat3f_cm = mat_cm<3, 3, float>;
+    using mat4f_cm = mat_cm<4, 4, float>;
+    using mat2d_cm = mat_cm<2, 2, double>;
+    using mat3d_cm = mat_cm<3, 3, double>;
+    using mat4d_cm = mat_cm<4, 4, double>;
 
-    //=============
-    // QUATERNIONS
-    //=============
-
-    template<typename T>
-    class quat : public vec<4, T> {
-      public:
-        using vec<4, T>::x;
-        using vec<4, T>::y;
-        using vec<4, T>::z;
-        using vec<4, T>::w;
 
-        using vec<4, T>::vec;
+    //=========
+    // SOLVERS
+    //=========
 
-        quat()
-            : vec<4, T>(T(0), T(0), T(0), T(1)) {}
+    /**
+     * @brief LU decomposition with partial pivoting (`P * A = L * U`) of a square matrix, for solving linear systems with the same matrix
+     */
+    template<luint n, typename T>
+    class lu_decomposition {
+        static_assert(std::is_floating_point_v<T>, "Decompositions are only available for float and double matrices");
 
-        explicit quat(const vec<4, T>& v)
-            : vec<4, T>(v) {}
-        operator vec<4, T>() const { return this->xyzw(); }
+      public:
+        // L below the diagonal (its diagonal is all ones), and U on and above it
+        mat<n, n, T> lu;
+        // The line of the original matrix that ended up on every line of lu
+        luint pivots[n];
+        bool odd_swaps = false;
 
-        quat<T> operator*(const quat<T>& q) const {
-            return {
-                w * q.x + x * q.w + y * q.z - z * q.y,
-                w * q.y + y * q.w + z * q.x - x * q.z,
-                w * q.z + z * q.w + x * q.y - y * q.x,
-                w * q.w - x * q.x - y * q.y - z * q.z
-            };
+        /**
+         * @brief Decompose a matrix, throwing if it is singular
+         */
+        explicit lu_decomposition(const mat<n, n, T>& a)
+            : lu(a) {
+            for (luint i = 0; i < n; i++)
+                pivots[i] = i;
+
+            for (luint col = 0; col < n; col++) {
+                luint pivot = col;
+                for (luint i = col + 1; i < n; i++)
+                    if (std::abs(lu[i][col]) > std::abs(lu[pivot][col]))
+                        pivot = i;
+                if (lu[pivot][col] == T(0))
+                    throw std::runtime_error("Cannot decompose singular matrix");
+                if (pivot != col) {
+                    std::swap(lu[col], lu[pivot]);
+                    std::swap(pivots[col], pivots[pivot]);
+                    odd_swaps = !odd_swaps;
+                }
+
+                const T inv_pivot = T(1) / lu[col][col];
+                for (luint i = col + 1; i < n; i++) {
+                    const T factor = lu[i][col] * inv_pivot;
+                    lu[i][col] = factor;
+                    for (luint j = col + 1; j < n; j++)
+                        lu[i][j] = mad(-factor, lu[col][j], lu[i][j]);
+                }
+            }
+        }
+
+        /**
+         * @brief Solve `A * x = b`
+         */
+        vec<n, T> solve(const vec<n, T>& b) const {
+            vec<n, T> x;
+            for (luint i = 0; i < n; i++) {
+                T sum = b[pivots[i]];
+                for (luint j = 0; j < i; j++)
+                    sum = mad(-lu[i][j], x[j], sum);
+                x[i] = sum;
+            }
+            for (luint i = n; i-- > 0;) {
+                T sum = x[i];
+                for (luint j = i + 1; j < n; j++)
+                    sum = mad(-lu[i][j], x[j], sum);
+                x[i] = sum / lu[i][i];
+            }
+            return x;
+        }
+
+        /**
+         * @brief Calculate the determinant of the decomposed matrix
+         */
+        T det() const {
+            T res = odd_swaps ? T(-1) : T(1);
+            for (luint i = 0; i < n; i++)
+                res *= lu[i][i];
+            return res;
+        }
+    };
+
+    /**
+     * @brief Cholesky decomposition (`A = L * L^T`) of a symmetric positive definite matrix, about twice as fast as LU
+     */
+    template<luint n, typename T>
+    class cholesky_decomposition {
+        static_assert(std::is_floating_point_v<T>, "Decompositions are only available for float and double matrices");
+
+      public:
+        // Lower triangular, with zeros above the diagonal
+        mat<n, n, T> l;
+
+        /**
+         * @brief Decompose a matrix (only the lower triangle is read), throwing if it isn't positive definite
+         */
+        explicit cholesky_decomposition(const mat<n, n, T>& a)
+            : l(T(0)) {
+            for (luint j = 0; j < n; j++) {
+                T diag = a[j][j];
+                for (luint k = 0; k < j; k++)
+                    diag = mad(-l[j][k], l[j][k], diag);
+                if (!(diag > T(0)))
+                    throw std::runtime_error("Cannot decompose matrix that isn't positive definite");
+                l[j][j] = std::sqrt(diag);
+
+                const T inv_diag = T(1) / l[j][j];
+                for (luint i = j + 1; i < n; i++) {
+                    T sum = a[i][j];
+                    for (luint k = 0; k < j; k++)
+                        sum = mad(-l[i][k], l[j][k], sum);
+                    l[i][j] = sum * inv_diag;
+                }
+            }
+        }
+
+        /**
+         * @brief Solve `A * x = b`
+         */
+        vec<n, T> solve(const vec<n, T>& b) const {
+            vec<n, T> x;
+            for (luint i = 0; i < n; i++) {
+                T sum = b[i];
+                for (luint k = 0; k < i; k++)
+                    sum = mad(-l[i][k], x[k], sum);
+                x[i] = sum / l[i][i];
+            }
+            for (luint i = n; i-- > 0;) {
+                T sum = x[i];
+                for (luint k = i + 1; k < n; k++)
+                    sum = mad(-l[k][i], x[k], sum);
+                x[i] = sum / l[i][i];
+            }
+            return x;
+        }
+    };
+
+    /**
+     * @brief QR decomposition (Householder reflections) of a matrix with at least as many lines as columns, for least squares problems
+     */
+    template<luint lines, luint columns, typename T>
+    class qr_decomposition {
+        static_assert(std::is_floating_point_v<T>, "Decompositions are only available for float and double matrices");
+        static_assert(lines >= columns, "QR decomposition needs at least as many lines as columns");
+
+      public:
+        // The Householder vectors on and below the diagonal, and R above it
+        mat<lines, columns, T> qr;
+        // The diagonal of R
+        vec<columns, T> r_diag;
+
+        /**
+         * @brief Decompose a matrix, throwing if its columns aren't linearly independent
+         */
+        explicit qr_decomposition(const mat<lines, columns, T>& a)
+            : qr(a) {
+            for (luint k = 0; k < columns; k++) {
+                T norm_sq = T(0);
+                for (luint i = k; i < lines; i++)
+                    norm_sq = mad(qr[i][k], qr[i][k], norm_sq);
+                if (norm_sq == T(0))
+                    throw std::runtime_error("Cannot decompose rank deficient matrix");
+                T norm = std::sqrt(norm_sq);
+                if (qr[k][k] < T(0))
+                    norm = -norm;
+
+                const T inv_norm = T(1) / norm;
+                for (luint i = k; i < lines; i++)
+                    qr[i][k] *= inv_norm;
+                qr[k][k] += T(1);
+
+                for (luint j = k + 1; j < columns; j++) {
+                    T sum = T(0);
+                    for (luint i = k; i < lines; i++)
+                        sum = mad(qr[i][k], qr[i][j], sum);
+                    const T factor = -sum / qr[k][k];
+                    for (luint i = k; i < lines; i++)
+                        qr[i][j] = mad(factor, qr[i][k], qr[i][j]);
+                }
+                r_diag[k] = -norm;
+            }
+        }
+
+        /**
+         * @brief Find the x that minimizes `|A * x - b|` (the exact solution for square matrices)
+         */
+        vec<columns, T> solve(const vec<lines, T>& b) const {
+            vec<lines, T> y = b;
+            for (luint k = 0; k < columns; k++) {
+                T sum = T(0);
+                for (luint i = k; i < lines; i++)
+                    sum = mad(qr[i][k], y[i], sum);
+                const T factor = -sum / qr[k][k];
+                for (luint i = k; i < lines; i++)
+                    y[i] = mad(factor, qr[i][k], y[i]);
+            }
+
+            vec<columns, T> x;
+            for (luint k = columns; k-- > 0;) {
+                T sum = y[k];
+                for (luint j = k + 1; j < columns; j++)
+                    sum = mad(-qr[k][j], x[j], sum);
+                x[k] = sum / r_diag[k];
+            }
+            return x;
+        }
+    };
+
+    /**
+     * @brief Solve `A * x = b`, using LU for square matrices, and least squares (QR) when there are more equations than unknowns
+     *
+     * Throws if the matrix is singular (or rank deficient). To solve for multiple vectors with the same matrix,
+     * keep the decomposition instead
+     *
+     * @param a The matrix
+     * @param b The right hand side
+     */
+    template<luint l, luint c, typename T>
+    inline vec<c, T> solve(const mat<l, c, T>& a, const vec<l, T>& b) {
+        if constexpr (l == c)
+            return lu_decomposition<l, T>(a).solve(b);
+        else
+            return qr_decomposition<l, c, T>(a).solve(b);
+    }
+
+
+    //=============
+    // QUATERNIONS
+    //=============
+
+    template<typename T>
+    class quat : public vec<4, T> {
+      public:
+        using vec<4, T>::x;
+        using vec<4, T>::y;
+        using vec<4, T>::z;
+        using vec<4, T>::w;
+
+        using vec<4, T>::vec;
+
+        quat()
+            : vec<4, T>(T(0), T(0), T(0), T(1)) {}
+
+        explicit quat(const vec<4, T>& v)
+            : vec<4, T>(v) {}
+        quat(const vec<3, T>& v, const T& w)
+            : vec<4, T>(v[0], v[1], v[2], w) {}
+        operator vec<4, T>() const { return this->xyzw(); }
+
+        quat<T> operator*(const quat<T>& q) const {
+            MGMATH_PROFILE_COUNT(quat_mul, T, profile_simd_vec<4, T>());
+            // Sum of q scaled by w, and of permutations of q with some components negated, scaled by x, y and z
+            vec<4, T> res = w * static_cast<const vec<4, T>&>(q);
+            MGMATH_CHECK_FLOATS_SCOPE("quat_mul", res.data(), 4, this->data(), 4, q.data(), 4);
+            res = vec<4, T>::mad(vec<4, T>{q.w, -q.z, q.y, -q.x}, x, res);
+            res = vec<4, T>::mad(vec<4, T>{q.z, q.w, -q.x, -q.y}, y, res);
+            res = vec<4, T>::mad(vec<4, T>{-q.y, q.x, q.w, -q.z}, z, res);
+            return quat<T>(res);
         }
         quat<T>& operator*=(const quat<T>& q) {
             return *this = *this * q;
@@ -2220,7 +4075,8 @@ namespace mgm {
          * @return The rotated version of the vector
          */
         vec<3, T> rotate(const vec<3, T>& v) const {
-            const auto res = *this * quat<T>{v, 0.0f} * conjugate();
+            MGMATH_PROFILE_COUNT(quat_rotate, T, profile_simd_vec<4, T>());
+            const auto res = *this * quat<T>{v, T(0)} * conjugate();
             return vec<3, T>{res.x, res.y, res.z};
         }
 
@@ -2231,7 +4087,8 @@ namespace mgm {
          * @return The rotate version of the vector
          */
         vec<3, T> rotate_safe(const vec<3, T>& v) const {
-            const auto res = *this * quat<T>{v, 0.0f} * inv();
+            MGMATH_PROFILE_COUNT(quat_rotate, T, profile_simd_vec<4, T>());
+            const auto res = *this * quat<T>{v, T(0)} * inv();
             return vec<3, T>{res.x, res.y, res.z};
         }
 
@@ -2246,9 +4103,10 @@ namespace mgm {
             if (angle == 0)
                 return quat<T>{0, 0, 0, 1};
 
+            using std::sin, std::cos;
             const auto ha = angle / 2;
-            const auto s = std::sin(ha);
-            const auto c = std::cos(ha);
+            const auto s = sin(ha);
+            const auto c = cos(ha);
             return quat<T>{axis * s, c};
         }
 
@@ -2296,6 +4154,51 @@ namespace mgm {
             };
         }
 
+        /**
+         * @brief Generate a quaternion from a rotation matrix (Shepperd's method), the inverse of `as_rotation_mat3`
+         *
+         * Starts from the largest of the 4 components, so it stays accurate for any angle
+         *
+         * @param m The rotation matrix, with orthonormal columns and a determinant of 1
+         */
+        static quat<T> from_mat3(const mat<3, 3, T>& m) {
+            // 4 times the square of every component
+            const T tw = T(1) + m[0][0] + m[1][1] + m[2][2];
+            const T tx = T(1) + m[0][0] - m[1][1] - m[2][2];
+            const T ty = T(1) - m[0][0] + m[1][1] - m[2][2];
+            const T tz = T(1) - m[0][0] - m[1][1] + m[2][2];
+
+            // The other components times 4 times the largest one, then divided by it
+            quat<T> res;
+            T largest;
+            if (tw >= tx && tw >= ty && tw >= tz) {
+                res = quat<T>{m[2][1] - m[1][2], m[0][2] - m[2][0], m[1][0] - m[0][1], tw};
+                largest = tw;
+            } else if (tx >= ty && tx >= tz) {
+                res = quat<T>{tx, m[0][1] + m[1][0], m[0][2] + m[2][0], m[2][1] - m[1][2]};
+                largest = tx;
+            } else if (ty >= tz) {
+                res = quat<T>{m[0][1] + m[1][0], ty, m[1][2] + m[2][1], m[0][2] - m[2][0]};
+                largest = ty;
+            } else {
+                res = quat<T>{m[0][2] + m[2][0], m[1][2] + m[2][1], tz, m[1][0] - m[0][1]};
+                largest = tz;
+            }
+            using std::sqrt;
+            return quat<T>(T(0.5) / sqrt(largest) * static_cast<const vec<4, T>&>(res));
+        }
+
+        /**
+         * @brief Generate a quaternion from the rotation part (top left 3x3) of a 4x4 matrix without scale, the inverse of `as_rotation_mat4`
+         */
+        static quat<T> from_mat4(const mat<4, 4, T>& m) {
+            return from_mat3(mat<3, 3, T>{
+                m[0][0], m[0][1], m[0][2],
+                m[1][0], m[1][1], m[1][2],
+                m[2][0], m[2][1], m[2][2]
+            });
+        }
+
         /**
          * @brief Perform a spherical linear interpolation (slerp) from this quaternion to a destination quaternion
          *
@@ -2303,25 +4206,5365 @@ namespace mgm {
          * @param weight The amount to interpolate by
          * @return The result of the interpolation
          */
-        quat<T> slerp(quat<T> destination, T weight) const {
-            auto d = this->dot(destination);
+        quat<T> slerp(const quat<T>& destination, T weight) const {
+            MGMATH_PROFILE_COUNT(quat_slerp, T, profile_simd_vec<4, T>());
+            // As vectors, since the products of quaternions are Hamilton products
+            const vec<4, T>& from = *this;
+            vec<4, T> to = destination;
+            auto d = from.dot(to);
 
             if (d < T(0)) {
                 d = -d;
-                destination = -destination;
+                to = -to;
             }
 
             // Because of loss of precision
             static constexpr auto THRESHOLD = T(0.9995);
             if (d > THRESHOLD)
-                return static_cast<quat<T>>(this->lerp(destination).normalized());
+                return quat<T>(from.lerp(to, weight).normalized());
 
             const auto theta = std::acos(d) * weight;
 
-            return *this * std::cos(theta) + (destination - *this * d).normalized() * std::sin(theta);
+            return quat<T>(vec<4, T>::mad(from, std::cos(theta), (to - from * d).normalized() * std::sin(theta)));
+        }
+
+        /**
+         * @brief Calculate the logarithm of a unit quaternion, the rotation axis scaled by half the angle (with w as 0)
+         */
+        quat<T> log() const {
+            const T len = std::sqrt(x * x + y * y + z * z);
+            if (len < std::numeric_limits<T>::epsilon())
+                return quat<T>{x, y, z, T(0)};
+            const T scale = std::atan2(len, w) / len;
+            return quat<T>{x * scale, y * scale, z * scale, T(0)};
+        }
+
+        /**
+         * @brief Calculate the exponential of a quaternion with w as 0, the inverse of `log`
+         */
+        quat<T> exp() const {
+            const T angle = std::sqrt(x * x + y * y + z * z);
+            if (angle < std::numeric_limits<T>::epsilon())
+                return quat<T>{x, y, z, T(1)};
+            const T scale = std::sin(angle) / angle;
+            return quat<T>{x * scale, y * scale, z * scale, std::cos(angle)};
         }
     };
 
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+    template<>
+    inline quat<double> quat<double>::operator*(const quat<double>& q) const {
+        // Sum of q scaled by w, and of permutations of q with some components negated, scaled by x, y and z
+        const __m128d lo = _mm_loadu_pd(q.data()), hi = _mm_loadu_pd(q.data() + 2);
+        const __m128d lo_swap = _mm_shuffle_pd(lo, lo, 1), hi_swap = _mm_shuffle_pd(hi, hi, 1);
+        const __m128d neg_hi = _mm_set_pd(-0.0, 0.0), neg_lo = _mm_set_pd(0.0, -0.0), neg_both = _mm_set1_pd(-0.0);
+
+        const __m128d sw = _mm_set1_pd(w), sx = _mm_set1_pd(x), sy = _mm_set1_pd(y), sz = _mm_set1_pd(z);
+        __m128d res_lo = _mm_mul_pd(sw, lo), res_hi = _mm_mul_pd(sw, hi);
+        // x * (qw, -qz, qy, -qx)
+        res_lo = simd_mad(sx, _mm_xor_pd(hi_swap, neg_hi), res_lo);
+        res_hi = simd_mad(sx, _mm_xor_pd(lo_swap, neg_hi), res_hi);
+        // y * (qz, qw, -qx, -qy)
+        res_lo = simd_mad(sy, hi, res_lo);
+        res_hi = simd_mad(sy, _mm_xor_pd(lo, neg_both), res_hi);
+        // z * (-qy, qx, qw, -qz)
+        res_lo = simd_mad(sz, _mm_xor_pd(lo_swap, neg_lo), res_lo);
+        res_hi = simd_mad(sz, _mm_xor_pd(hi_swap, neg_hi), res_hi);
+
+        quat<double> r;
+        _mm_storeu_pd(r.data(), res_lo);
+        _mm_storeu_pd(r.data() + 2, res_hi);
+        return r;
+    }
+#endif
+
     using quatf = quat<float>;
     using quatd = quat<double>;
+
+
+    //=============
+    // FIXED POINT
+    //=============
+
+    /**
+     * @brief The storage of a fixed point number of 32 or 64 bits, and the double width type its products and quotients are calculated in
+     */
+    template<bool Wide>
+    struct fixed_storage {
+        using type = int32;
+        using unsigned_type = uint32;
+        using wide = int64;
+        using unsigned_wide = uint64;
+    };
+#if defined(__SIZEOF_INT128__)
+    template<>
+    struct fixed_storage<true> {
+        using type = int64;
+        using unsigned_type = uint64;
+        __extension__ typedef __int128 wide;
+        __extension__ typedef unsigned __int128 unsigned_wide;
+    };
+#endif
+
+    /**
+     * @brief A signed fixed point number of 32 or 64 bits, with IntBits bits (counting the sign) before the point, and FracBits after it
+     *
+     * Usable as the component type of vec, mat and quat. Every operation is done on integers, so the results are bit
+     * identical on every compiler, target and optimization level. Addition and subtraction wrap around like integers,
+     * multiplication and division are calculated at double width and rounded to nearest, then wrap around the same way.
+     * Integers convert implicitly, floating point values only explicitly (rounded to nearest), so they can't leak into
+     * a calculation by accident. 64-bit numbers need a compiler with 128-bit integers (GCC, Clang)
+     */
+    template<luint IntBits, luint FracBits>
+    class fixed {
+        static_assert(IntBits >= 1 && (IntBits + FracBits == 32 || IntBits + FracBits == 64), "Fixed point numbers have 32 or 64 bits, including the sign");
+
+      public:
+        using storage = typename fixed_storage<(IntBits + FracBits > 32)>::type;
+        using unsigned_storage = typename fixed_storage<(IntBits + FracBits > 32)>::unsigned_type;
+        using wide = typename fixed_storage<(IntBits + FracBits > 32)>::wide;
+        using unsigned_wide = typename fixed_storage<(IntBits + FracBits > 32)>::unsigned_wide;
+        static constexpr luint frac_bits = FracBits;
+        static_assert(sizeof(storage) * 8 == IntBits + FracBits, "64-bit fixed point numbers need a compiler with 128-bit integers");
+
+        // The value times 2^FracBits
+        storage raw;
+
+        constexpr fixed()
+            : raw(0) {}
+
+        template<typename U, std::enable_if_t<std::is_integral_v<U>, bool> = true>
+        constexpr fixed(const U v)
+            : raw(static_cast<storage>(static_cast<unsigned_storage>(v) << FracBits)) {}
+
+        template<typename U, std::enable_if_t<std::is_floating_point_v<U>, bool> = true>
+        constexpr explicit fixed(const U v)
+            : raw(static_cast<storage>(static_cast<double>(v) * scale() + (v < 0 ? -0.5 : 0.5))) {}
+
+        /**
+         * @brief Build a number from its value times 2^FracBits
+         */
+        static constexpr fixed from_raw(const storage r) {
+            fixed res;
+            res.raw = r;
+            return res;
+        }
+
+        constexpr explicit operator double() const { return static_cast<double>(raw) / scale(); }
+        constexpr explicit operator float() const { return static_cast<float>(static_cast<double>(raw) / scale()); }
+
+        friend constexpr fixed operator+(const fixed a, const fixed b) {
+            return from_raw(static_cast<storage>(static_cast<unsigned_storage>(a.raw) + static_cast<unsigned_storage>(b.raw)));
+        }
+        friend constexpr fixed operator-(const fixed a, const fixed b) {
+            return from_raw(static_cast<storage>(static_cast<unsigned_storage>(a.raw) - static_cast<unsigned_storage>(b.raw)));
+        }
+        friend constexpr fixed operator*(const fixed a, const fixed b) {
+            return from_wide(round_down(static_cast<wide>(a.raw) * b.raw));
+        }
+        friend constexpr fixed operator/(const fixed a, const fixed b) {
+            if (b.raw == 0)
+                throw std::runtime_error("Fixed point division by zero");
+            // Half the divisor further from zero, so the truncated quotient is rounded to nearest
+            const wide n = static_cast<wide>(a.raw) * (wide(1) << FracBits);
+            const wide half = (b.raw < 0 ? -static_cast<wide>(b.raw) : static_cast<wide>(b.raw)) / 2;
+            return from_wide((n < 0 ? n - half : n + half) / b.raw);
+        }
+        constexpr fixed operator-() const {
+            return from_raw(static_cast<storage>(unsigned_storage(0) - static_cast<unsigned_storage>(raw)));
+        }
+        constexpr fixed operator+() const { return *this; }
+
+        fixed& operator+=(const fixed v) { return *this = *this + v; }
+        fixed& operator-=(const fixed v) { return *this = *this - v; }
+        fixed& operator*=(const fixed v) { return *this = *this * v; }
+        fixed& operator/=(const fixed v) { return *this = *this / v; }
+
+        friend constexpr bool operator==(const fixed a, const fixed b) { return a.raw == b.raw; }
+        friend constexpr bool operator!=(const fixed a, const fixed b) { return a.raw != b.raw; }
+        friend constexpr bool operator<(const fixed a, const fixed b) { return a.raw < b.raw; }
+        friend constexpr bool operator>(const fixed a, const fixed b) { return a.raw > b.raw; }
+        friend constexpr bool operator<=(const fixed a, const fixed b) { return a.raw <= b.raw; }
+        friend constexpr bool operator>=(const fixed a, const fixed b) { return a.raw >= b.raw; }
+
+        friend std::ostream& operator<<(std::ostream& os, const fixed v) {
+            return os << static_cast<double>(v);
+        }
+
+      private:
+        static constexpr double scale() {
+            return static_cast<double>(uint64(1) << FracBits);
+        }
+
+        // Shift a double width product back to FracBits fractional bits, rounding to nearest (relies on arithmetic right
+        // shifts of negative values, which every supported compiler does, and C++20 requires)
+        static constexpr wide round_down(const wide v) {
+            if constexpr (FracBits == 0)
+                return v;
+            else
+                return (v + (wide(1) << (FracBits - 1))) >> FracBits;
+        }
+
+        static constexpr fixed from_wide(const wide v) {
+            return from_raw(static_cast<storage>(static_cast<unsigned_storage>(v)));
+        }
+    };
+
+    template<luint IntBits, luint FracBits>
+    constexpr fixed<IntBits, FracBits> abs(const fixed<IntBits, FracBits> v) {
+        return v.raw < 0 ? -v : v;
+    }
+
+    /**
+     * @brief Square root of a fixed point number, rounded to nearest (0 for negative numbers)
+     */
+    template<luint IntBits, luint FracBits>
+    inline fixed<IntBits, FracBits> sqrt(const fixed<IntBits, FracBits> v) {
+        using T = fixed<IntBits, FracBits>;
+        using U = typename T::unsigned_wide;
+        if (v.raw <= 0)
+            return T{};
+
+        // The integer root of raw * 2^FracBits, one bit at a time from the highest
+        U n = static_cast<U>(v.raw) << FracBits;
+        U root = 0, bit = U(1) << (sizeof(U) * 8 - 2);
+        while (bit > n)
+            bit >>= 2;
+        while (bit != 0) {
+            if (n >= root + bit) {
+                n -= root + bit;
+                root = (root >> 1) + bit;
+            } else
+                root >>= 1;
+            bit >>= 2;
+        }
+        // What is left is raw * 2^FracBits - root^2, which is above root when the exact root is above root + 0.5
+        if (n > root)
+            root++;
+        return T::from_raw(static_cast<typename T::storage>(root));
+    }
+
+    /**
+     * @brief The high 64 bits of the product of two unsigned 64-bit integers, with 32-bit halves so it doesn't need 128-bit integers
+     */
+    constexpr uint64 fixed_mulhi_u64(const uint64 a, const uint64 b) {
+        const uint64 ll = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+        const uint64 lh = (a & 0xFFFFFFFF) * (b >> 32);
+        const uint64 hl = (a >> 32) * (b & 0xFFFFFFFF);
+        const uint64 mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+        return (a >> 32) * (b >> 32) + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    }
+
+    /**
+     * @brief Sine and cosine of an angle in radians (the raw value of a fixed point number with FracBits fractional bits), as Q31 integers (2^31 is 1)
+     *
+     * The angle is multiplied by 1 / 2pi with 128 bits, so even the largest angles keep 64 correct bits of the fraction
+     * of a turn. The polynomials are evaluated with 31 fractional bits around the nearest multiple of pi / 2, which keeps
+     * the error below 2 units of the last place
+     */
+    template<luint FracBits, typename S>
+    inline void fixed_sincos_q31(const S angle, int64& sine, int64& cosine) {
+        static_assert(FracBits < 64, "The angle must have less than 64 fractional bits");
+        // 1 / 2pi times 2^192
+        constexpr uint64 inv_two_pi[3] = {0x28BE60DB9391054A, 0x7F09D5F47D4D3770, 0x36D8A5664F10E410};
+        // 1 / 2pi times 2^(128 - FracBits), so the low 64 bits of the product with the angle, times 2^64, are the fraction of a turn
+        constexpr uint64 k_hi = inv_two_pi[0] >> FracBits;
+        constexpr uint64 k_lo = FracBits == 0 ? inv_two_pi[1] : (inv_two_pi[0] << ((64 - FracBits) & 63)) | (inv_two_pi[1] >> FracBits);
+        constexpr uint64 pi_q62 = 0xC90FDAA22168C235;
+
+        // The product modulo 2^128 of the sign extended angle and k, of which only bits 64 to 127 are needed
+        const uint64 a = static_cast<uint64>(static_cast<int64>(angle));
+        const uint64 a_hi = static_cast<int64>(angle) < 0 ? ~uint64(0) : 0;
+        const uint64 turn = fixed_mulhi_u64(a, k_lo) + a * k_hi + a_hi * k_lo;
+
+        // The offset from the nearest quarter turn, in radians as Q31
+        const uint64 quadrant = (turn + (uint64(1) << 61)) >> 62;
+        const int64 offset = static_cast<int64>(turn - (quadrant << 62));
+        const int64 x_abs = static_cast<int64>((fixed_mulhi_u64(static_cast<uint64>(offset < 0 ? -offset : offset), pi_q62) + (uint64(1) << 29)) >> 30);
+        const int64 x = offset < 0 ? -x_abs : x_abs;
+
+        const auto mul = [](const int64 p, const int64 q) { return (p * q + (int64(1) << 30)) >> 31; };
+        const int64 x2 = mul(x, x);
+        // Taylor series to x^11 and x^12, with coefficients 1 / n! as Q31
+        const int64 s = mul(x, (int64(1) << 31) - mul(x2, 357913941 - mul(x2, 17895697 - mul(x2, 426088 - mul(x2, 5918 - mul(x2, 54))))));
+        const int64 c = (int64(1) << 31) - mul(x2, (int64(1) << 30) - mul(x2, 89478485 - mul(x2, 2982616 - mul(x2, 53261 - mul(x2, 592 - mul(x2, 4))))));
+        switch (quadrant & 3) {
+            case 0: sine = s, cosine = c; break;
+            case 1: sine = c, cosine = -s; break;
+            case 2: sine = -s, cosine = -c; break;
+            default: sine = -c, cosine = s; break;
+        }
+    }
+
+    /**
+     * @brief Convert a Q31 integer to the raw value of a fixed point number, rounded to nearest
+     */
+    template<typename T>
+    constexpr T fixed_from_q31(const int64 v) {
+        constexpr luint frac = T::frac_bits;
+        if constexpr (frac < 31)
+            return T::from_raw(static_cast<typename T::storage>((v + (int64(1) << (30 - frac))) >> (31 - frac)));
+        else
+            return T::from_raw(static_cast<typename T::storage>(v * (int64(1) << (frac - 31))));
+    }
+
+    /**
+     * @brief Sine of an angle in radians, within 2^-30 of the exact value before rounding to FracBits fractional bits
+     */
+    template<luint IntBits, luint FracBits>
+    inline fixed<IntBits, FracBits> sin(const fixed<IntBits, FracBits> angle) {
+        static_assert(IntBits >= 2, "The sine needs 2 integer bits to represent 1");
+        int64 s, c;
+        fixed_sincos_q31<FracBits>(angle.raw, s, c);
+        return fixed_from_q31<fixed<IntBits, FracBits>>(s);
+    }
+
+    /**
+     * @brief Cosine of an angle in radians, within 2^-30 of the exact value before rounding to FracBits fractional bits
+     */
+    template<luint IntBits, luint FracBits>
+    inline fixed<IntBits, FracBits> cos(const fixed<IntBits, FracBits> angle) {
+        static_assert(IntBits >= 2, "The cosine needs 2 integer bits to represent 1");
+        int64 s, c;
+        fixed_sincos_q31<FracBits>(angle.raw, s, c);
+        return fixed_from_q31<fixed<IntBits, FracBits>>(c);
+    }
+
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+    /**
+     * @brief Multiply the 32-bit fixed point numbers in the lanes of two registers, rounded the same way as the scalar product
+     */
+    template<luint FracBits>
+    inline __m128i simd_fixed_mul_epi32(const __m128i a, const __m128i b) {
+        const __m128i bias = _mm_set1_epi64x((int64(1) << FracBits) >> 1);
+#if defined(MGMATH_SSE4_1)
+        const __m128i even = _mm_mul_epi32(a, b);
+        const __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+#else
+        // Unsigned products, minus 2^32 times the other factor for every negative one
+        const __m128i fix = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b), _mm_and_si128(_mm_srai_epi32(b, 31), a));
+        const __m128i even = _mm_sub_epi64(_mm_mul_epu32(a, b), _mm_slli_epi64(fix, 32));
+        const __m128i odd = _mm_sub_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), _mm_and_si128(fix, _mm_set_epi32(-1, 0, -1, 0)));
+#endif
+        // Bits FracBits to FracBits + 31 of the 64-bit products, moved to the low half of the even lanes, and the high half of the odd ones
+        const __m128i lo = _mm_srli_epi64(_mm_add_epi64(even, bias), FracBits);
+        const __m128i hi = _mm_slli_epi64(_mm_add_epi64(odd, bias), 32 - FracBits);
+        return _mm_or_si128(_mm_and_si128(lo, _mm_set_epi32(0, -1, 0, -1)), _mm_and_si128(hi, _mm_set_epi32(-1, 0, -1, 0)));
+    }
+#if defined(__AVX2__)
+    template<luint FracBits>
+    inline __m256i simd_fixed_mul_epi32(const __m256i a, const __m256i b) {
+        const __m256i bias = _mm256_set1_epi64x((int64(1) << FracBits) >> 1);
+        const __m256i even = _mm256_mul_epi32(a, b);
+        const __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+        const __m256i lo = _mm256_srli_epi64(_mm256_add_epi64(even, bias), FracBits);
+        const __m256i hi = _mm256_slli_epi64(_mm256_add_epi64(odd, bias), 32 - FracBits);
+        return _mm256_blend_epi32(lo, hi, 0xAA);
+    }
+#endif
+#endif
+
+    /**
+     * @brief Add two arrays of fixed point vectors, with 32-bit integer SIMD when MGMATH_SIMD is defined (bit identical to the scalar sums)
+     *
+     * @param dst The array to write the results to (can be the same as one of the sources)
+     * @param a The first array of vectors
+     * @param b The second array of vectors
+     * @param count The number of vectors in each array
+     */
+    template<luint S, luint IntBits, luint FracBits>
+    inline void add(vec<S, fixed<IntBits, FracBits>>* dst, const vec<S, fixed<IntBits, FracBits>>* a, const vec<S, fixed<IntBits, FracBits>>* b, const luint count) {
+        using T = fixed<IntBits, FracBits>;
+        MGMATH_PROFILE_BATCH(batch_fixed, T, count, profile_simd_build && sizeof(T) == 4);
+        const T* x = reinterpret_cast<const T*>(a);
+        const T* y = reinterpret_cast<const T*>(b);
+        T* r = reinterpret_cast<T*>(dst);
+        const luint n = S * count;
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+        if constexpr (sizeof(T) == 4) {
+#if defined(__AVX2__)
+            for (; i + 8 <= n; i += 8) {
+                const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+                const __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), _mm256_add_epi32(p, q));
+            }
+#endif
+            for (; i + 4 <= n; i += 4) {
+                const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+                const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), _mm_add_epi32(p, q));
+            }
+        }
+#endif
+        for (; i < n; i++)
+            r[i] = x[i] + y[i];
+    }
+
+    /**
+     * @brief Multiply two arrays of fixed point vectors component by component, with 32-bit integer SIMD when MGMATH_SIMD is defined (bit identical to the scalar products)
+     *
+     * @param dst The array to write the results to (can be the same as one of the sources)
+     * @param a The first array of vectors
+     * @param b The second array of vectors
+     * @param count The number of vectors in each array
+     */
+    template<luint S, luint IntBits, luint FracBits>
+    inline void mul(vec<S, fixed<IntBits, FracBits>>* dst, const vec<S, fixed<IntBits, FracBits>>* a, const vec<S, fixed<IntBits, FracBits>>* b, const luint count) {
+        using T = fixed<IntBits, FracBits>;
+        MGMATH_PROFILE_BATCH(batch_fixed, T, count, profile_simd_build && sizeof(T) == 4);
+        const T* x = reinterpret_cast<const T*>(a);
+        const T* y = reinterpret_cast<const T*>(b);
+        T* r = reinterpret_cast<T*>(dst);
+        const luint n = S * count;
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+        if constexpr (sizeof(T) == 4) {
+#if defined(__AVX2__)
+            for (; i + 8 <= n; i += 8) {
+                const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+                const __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), simd_fixed_mul_epi32<FracBits>(p, q));
+            }
+#endif
+            for (; i + 4 <= n; i += 4) {
+                const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+                const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), simd_fixed_mul_epi32<FracBits>(p, q));
+            }
+        }
+#endif
+        for (; i < n; i++)
+            r[i] = x[i] * y[i];
+    }
+
+    /**
+     * @brief Calculate the dot products of two arrays of fixed point vectors, 4 (SSE) or 8 (AVX2) at a time when MGMATH_SIMD is defined (bit identical to vec::dot)
+     *
+     * @param dst The array to write the dot products to
+     * @param a The first array of vectors
+     * @param b The second array of vectors
+     * @param count The number of vectors in each array
+     */
+    template<luint S, luint IntBits, luint FracBits>
+    inline void dot(fixed<IntBits, FracBits>* dst, const vec<S, fixed<IntBits, FracBits>>* a, const vec<S, fixed<IntBits, FracBits>>* b, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_fixed, std::remove_pointer_t<decltype(dst)>, count, profile_simd_build && IntBits + FracBits == 32);
+        luint k = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+        if constexpr (IntBits + FracBits == 32) {
+            // Every product is rounded on its own, and the sums wrap around, the same as the scalar dot product
+            const auto component = [](const vec<S, fixed<IntBits, FracBits>>* v, const luint i, const luint k) { return v[k][i].raw; };
+#if defined(__AVX2__)
+            for (; k + 8 <= count; k += 8) {
+                __m256i sum = _mm256_setzero_si256();
+                for (luint i = 0; i < S; i++) {
+                    const __m256i p = _mm256_set_epi32(component(a, i, k + 7), component(a, i, k + 6), component(a, i, k + 5), component(a, i, k + 4),
+                                                       component(a, i, k + 3), component(a, i, k + 2), component(a, i, k + 1), component(a, i, k));
+                    const __m256i q = _mm256_set_epi32(component(b, i, k + 7), component(b, i, k + 6), component(b, i, k + 5), component(b, i, k + 4),
+                                                       component(b, i, k + 3), component(b, i, k + 2), component(b, i, k + 1), component(b, i, k));
+                    sum = _mm256_add_epi32(sum, simd_fixed_mul_epi32<FracBits>(p, q));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + k), sum);
+            }
+#endif
+            for (; k + 4 <= count; k += 4) {
+                __m128i sum = _mm_setzero_si128();
+                for (luint i = 0; i < S; i++) {
+                    const __m128i p = _mm_set_epi32(component(a, i, k + 3), component(a, i, k + 2), component(a, i, k + 1), component(a, i, k));
+                    const __m128i q = _mm_set_epi32(component(b, i, k + 3), component(b, i, k + 2), component(b, i, k + 1), component(b, i, k));
+                    sum = _mm_add_epi32(sum, simd_fixed_mul_epi32<FracBits>(p, q));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k), sum);
+            }
+        }
+#endif
+        for (; k < count; k++)
+            dst[k] = a[k].dot(b[k]);
+    }
+
+    using fixed32 = fixed<16, 16>;
+#if defined(__SIZEOF_INT128__)
+    using fixed64 = fixed<32, 32>;
+#endif
+
+    using vec2x = vec<2, fixed32>;
+    using vec3x = vec<3, fixed32>;
+    using vec4x = vec<4, fixed32>;
+    using mat2x = mat<2, 2, fixed32>;
+    using mat3x = mat<3, 3, fixed32>;
+    using mat4x = mat<4, 4, fixed32>;
+    using quatx = quat<fixed32>;
+
+
+    //================
+    // DECOMPOSITIONS
+    //================
+
+    /**
+     * @brief A float in every lane of a register (or a single float), with the arithmetic used by the branch-free 3x3 decompositions
+     *
+     * The same code runs on 1, 4 (SSE) or 8 (AVX) matrices at once, with comparisons returning masks used to select between values
+     *
+     * @tparam N The number of lanes
+     */
+    template<luint N>
+    struct float_lanes;
+
+    /**
+     * @brief Refine an estimate of the cube root of lanes with 2 Halley steps
+     */
+    template<typename L>
+    inline L lanes_cbrt_refine(const L a, L r) {
+        for (luint i = 0; i < 2; i++) {
+            const L r3 = r * r * r;
+            r = r * L::mad(L::set(2.0f), a, r3) / L::mad(L::set(2.0f), r3, a);
+        }
+        return r;
+    }
+
+    template<>
+    struct float_lanes<1> {
+        static constexpr luint count = 1;
+        using mask = bool;
+        float v;
+
+        static float_lanes set(const float x) { return {x}; }
+        static float_lanes load(const float* src) { return {*src}; }
+        static float_lanes load_strided(const float* src, const luint) { return {*src}; }
+        static float_lanes gather(const float* base, const int32* index) { return {base[index[0]]}; }
+        void store(float* dst) const { *dst = v; }
+
+        friend float_lanes operator+(const float_lanes a, const float_lanes b) { return {a.v + b.v}; }
+        friend float_lanes operator-(const float_lanes a, const float_lanes b) { return {a.v - b.v}; }
+        friend float_lanes operator*(const float_lanes a, const float_lanes b) { return {a.v * b.v}; }
+        friend float_lanes operator/(const float_lanes a, const float_lanes b) { return {a.v / b.v}; }
+        friend float_lanes operator-(const float_lanes a) { return {-a.v}; }
+
+        static float_lanes mad(const float_lanes a, const float_lanes b, const float_lanes c) { return {mgm::mad(a.v, b.v, c.v)}; }
+        static float_lanes max(const float_lanes a, const float_lanes b) { return {a.v > b.v ? a.v : b.v}; }
+        static float_lanes min(const float_lanes a, const float_lanes b) { return {a.v < b.v ? a.v : b.v}; }
+        static float_lanes floor(const float_lanes a) { return {std::floor(a.v)}; }
+        static float_lanes abs(const float_lanes a) { return {std::abs(a.v)}; }
+        static float_lanes sqrt(const float_lanes a) { return {std::sqrt(a.v)}; }
+        static float_lanes rsqrt(const float_lanes a) { return {1.0f / std::sqrt(a.v)}; }
+        static float_lanes cbrt(const float_lanes a) {
+            // The same steps as the SIMD lanes rather than std::cbrt, so every lane count gives the same bits
+            int32 bits;
+            memcpy(&bits, &a.v, sizeof(bits));
+            bits = static_cast<int32>(std::nearbyint(mgm::mad(static_cast<float>(bits), 1.0f / 3.0f, 709958130.0f)));
+            float_lanes r;
+            memcpy(&r.v, &bits, sizeof(bits));
+            return lanes_cbrt_refine(a, r);
+        }
+        static mask less(const float_lanes a, const float_lanes b) { return a.v < b.v; }
+        static mask less_equal(const float_lanes a, const float_lanes b) { return a.v <= b.v; }
+        static mask mask_and(const mask a, const mask b) { return a && b; }
+        static uint32 mask_bits(const mask m) { return m ? 1u : 0u; }
+        static float_lanes select(const mask m, const float_lanes a, const float_lanes b) { return {m ? a.v : b.v}; }
+    };
+
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+    template<>
+    struct float_lanes<4> {
+        static constexpr luint count = 4;
+        using mask = __m128;
+        __m128 v;
+
+        static float_lanes set(const float x) { return {_mm_set1_ps(x)}; }
+        static float_lanes load(const float* src) { return {_mm_loadu_ps(src)}; }
+        // Built in registers, since a vector load right after scalar stores to the same place stalls
+        static float_lanes load_strided(const float* src, const luint stride) { return {_mm_set_ps(src[3 * stride], src[2 * stride], src[stride], src[0])}; }
+        static float_lanes gather(const float* base, const int32* index) { return {_mm_set_ps(base[index[3]], base[index[2]], base[index[1]], base[index[0]])}; }
+        void store(float* dst) const { _mm_storeu_ps(dst, v); }
+
+        friend float_lanes operator+(const float_lanes a, const float_lanes b) { return {_mm_add_ps(a.v, b.v)}; }
+        friend float_lanes operator-(const float_lanes a, const float_lanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+        friend float_lanes operator*(const float_lanes a, const float_lanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+        friend float_lanes operator/(const float_lanes a, const float_lanes b) { return {_mm_div_ps(a.v, b.v)}; }
+        friend float_lanes operator-(const float_lanes a) { return {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))}; }
+
+        static float_lanes mad(const float_lanes a, const float_lanes b, const float_lanes c) { return {simd_mad(a.v, b.v, c.v)}; }
+        static float_lanes max(const float_lanes a, const float_lanes b) { return {_mm_max_ps(a.v, b.v)}; }
+        static float_lanes min(const float_lanes a, const float_lanes b) { return {_mm_min_ps(a.v, b.v)}; }
+        static float_lanes floor(const float_lanes a) {
+#if defined(MGMATH_SSE4_1)
+            return {_mm_floor_ps(a.v)};
+#else
+            // Truncated, then one less where that rounded up (negative values), for values that fit in an int
+            const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+            return {_mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f)))};
+#endif
+        }
+        static float_lanes abs(const float_lanes a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+        static float_lanes sqrt(const float_lanes a) { return {_mm_sqrt_ps(a.v)}; }
+        static float_lanes rsqrt(const float_lanes a) {
+            // Approximation refined with one Newton-Raphson step
+            const __m128 r = _mm_rsqrt_ps(a.v);
+            return {_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(a.v, r), r)))};
+        }
+        static float_lanes cbrt(const float_lanes a) {
+            // Kahan's estimate from a third of the bits, refined with 2 Halley steps, for positive normal values
+            const __m128 bits = _mm_cvtepi32_ps(_mm_castps_si128(a.v));
+            return lanes_cbrt_refine(a, {_mm_castsi128_ps(_mm_cvtps_epi32(simd_mad(bits, _mm_set1_ps(1.0f / 3.0f), _mm_set1_ps(709958130.0f))))});
+        }
+        static mask less(const float_lanes a, const float_lanes b) { return _mm_cmplt_ps(a.v, b.v); }
+        static mask less_equal(const float_lanes a, const float_lanes b) { return _mm_cmple_ps(a.v, b.v); }
+        static mask mask_and(const mask a, const mask b) { return _mm_and_ps(a, b); }
+        static uint32 mask_bits(const mask m) { return static_cast<uint32>(_mm_movemask_ps(m)); }
+        static float_lanes select(const mask m, const float_lanes a, const float_lanes b) {
+#if defined(MGMATH_SSE4_1)
+            return {_mm_blendv_ps(b.v, a.v, m)};
+#else
+            return {_mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v))};
+#endif
+        }
+    };
+
+#if defined(__AVX__)
+    template<>
+    struct float_lanes<8> {
+        static constexpr luint count = 8;
+        using mask = __m256;
+        __m256 v;
+
+        static float_lanes set(const float x) { return {_mm256_set1_ps(x)}; }
+        static float_lanes load(const float* src) { return {_mm256_loadu_ps(src)}; }
+        static float_lanes load_strided(const float* src, const luint stride) {
+            return {_mm256_set_ps(src[7 * stride], src[6 * stride], src[5 * stride], src[4 * stride], src[3 * stride], src[2 * stride], src[stride], src[0])};
+        }
+        static float_lanes gather(const float* base, const int32* index) {
+            return {_mm256_set_ps(base[index[7]], base[index[6]], base[index[5]], base[index[4]], base[index[3]], base[index[2]], base[index[1]], base[index[0]])};
+        }
+        void store(float* dst) const { _mm256_storeu_ps(dst, v); }
+
+        friend float_lanes operator+(const float_lanes a, const float_lanes b) { return {_mm256_add_ps(a.v, b.v)}; }
+        friend float_lanes operator-(const float_lanes a, const float_lanes b) { return {_mm256_sub_ps(a.v, b.v)}; }
+        friend float_lanes operator*(const float_lanes a, const float_lanes b) { return {_mm256_mul_ps(a.v, b.v)}; }
+        friend float_lanes operator/(const float_lanes a, const float_lanes b) { return {_mm256_div_ps(a.v, b.v)}; }
+        friend float_lanes operator-(const float_lanes a) { return {_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))}; }
+
+        static float_lanes mad(const float_lanes a, const float_lanes b, const float_lanes c) { return {simd_mad(a.v, b.v, c.v)}; }
+        static float_lanes max(const float_lanes a, const float_lanes b) { return {_mm256_max_ps(a.v, b.v)}; }
+        static float_lanes min(const float_lanes a, const float_lanes b) { return {_mm256_min_ps(a.v, b.v)}; }
+        static float_lanes floor(const float_lanes a) { return {_mm256_floor_ps(a.v)}; }
+        static float_lanes abs(const float_lanes a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+        static float_lanes sqrt(const float_lanes a) { return {_mm256_sqrt_ps(a.v)}; }
+        static float_lanes rsqrt(const float_lanes a) {
+            const __m256 r = _mm256_rsqrt_ps(a.v);
+            return {_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), r), _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(_mm256_mul_ps(a.v, r), r)))};
+        }
+        static float_lanes cbrt(const float_lanes a) {
+            const __m256 bits = _mm256_cvtepi32_ps(_mm256_castps_si256(a.v));
+            return lanes_cbrt_refine(a, {_mm256_castsi256_ps(_mm256_cvtps_epi32(simd_mad(bits, _mm256_set1_ps(1.0f / 3.0f), _mm256_set1_ps(709958130.0f))))});
+        }
+        static mask less(const float_lanes a, const float_lanes b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+        static mask less_equal(const float_lanes a, const float_lanes b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+        static mask mask_and(const mask a, const mask b) { return _mm256_and_ps(a, b); }
+        static uint32 mask_bits(const mask m) { return static_cast<uint32>(_mm256_movemask_ps(m)); }
+        static float_lanes select(const mask m, const float_lanes a, const float_lanes b) {
+#if defined(__AVX2__)
+            return {_mm256_blendv_ps(b.v, a.v, m)};
+#else
+            // GCC splits blendv into scalar code without AVX2, and masks fill whole lanes, so bitwise selection is the same
+            return {_mm256_or_ps(_mm256_and_ps(m, a.v), _mm256_andnot_ps(m, b.v))};
+#endif
+        }
+    };
+#endif
+#endif
+
+    // Number of Jacobi sweeps of the 3x3 SVD (McAdams et al. use 4, one more keeps the reconstruction error close to float precision for badly conditioned matrices)
+#if !defined(MGMATH_SVD3_SWEEPS)
+#define MGMATH_SVD3_SWEEPS 5
+#endif
+
+    /**
+     * @brief Build the rotation matrix (row major) of a unit quaternion stored as x, y, z, w in lanes
+     */
+    template<typename L>
+    inline void lanes_quat_to_mat3(const L q[4], L m[9]) {
+        const L one = L::set(1.0f), two = L::set(2.0f);
+        const L xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+        const L xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+        const L xw = q[0] * q[3], yw = q[1] * q[3], zw = q[2] * q[3];
+        m[0] = one - two * (yy + zz);
+        m[1] = two * (xy - zw);
+        m[2] = two * (xz + yw);
+        m[3] = two * (xy + zw);
+        m[4] = one - two * (xx + zz);
+        m[5] = two * (yz - xw);
+        m[6] = two * (xz - yw);
+        m[7] = two * (yz + xw);
+        m[8] = one - two * (xx + yy);
+    }
+
+    /**
+     * @brief Diagonalize symmetric 3x3 matrices in lanes with a fixed number of approximate Jacobi rotations, without branches
+     *
+     * @param sym The lower triangle of the matrices (11, 21, 22, 31, 32, 33), holding the eigenvalues on its diagonal on return
+     * @param q The unit quaternions of the rotations whose columns are the eigenvectors
+     */
+    template<typename L>
+    inline void lanes_jacobi3(L sym[6], L q[4]) {
+        const float gamma = 5.828427124f, cos_pi8 = 0.923879532f, sin_pi8 = 0.3826834323f;
+        const L zero = L::set(0.0f), one = L::set(1.0f), two = L::set(2.0f);
+        L s11 = sym[0], s21 = sym[1], s22 = sym[2], s31 = sym[3], s32 = sym[4], s33 = sym[5];
+
+        q[0] = zero;
+        q[1] = zero;
+        q[2] = zero;
+        q[3] = one;
+
+        // Zero s21 with an approximate Givens rotation, accumulate it into q, then rotate the matrix so the next pair is on top
+        const auto conjugate = [&](const luint x, const luint y, const luint z) {
+            L ch = two * (s11 - s22), sh = s21;
+            const auto exact = L::less(L::set(gamma) * sh * sh, ch * ch);
+            const L w = L::rsqrt(L::mad(ch, ch, sh * sh));
+            ch = L::select(exact, w * ch, L::set(cos_pi8));
+            sh = L::select(exact, w * sh, L::set(sin_pi8));
+
+            const L inv_scale = one / L::mad(ch, ch, sh * sh);
+            const L c = (ch * ch - sh * sh) * inv_scale, s = two * sh * ch * inv_scale;
+
+            const L t11 = s11, t21 = s21, t22 = s22, t31 = s31, t32 = s32, t33 = s33;
+            const L u1 = L::mad(c, t21, -(s * t11)), u2 = L::mad(c, t22, -(s * t21));
+            s11 = L::mad(c, L::mad(c, t11, s * t21), s * L::mad(c, t21, s * t22));
+            s21 = L::mad(c, u1, s * u2);
+            s22 = L::mad(c, u2, -(s * u1));
+            s31 = L::mad(c, t31, s * t32);
+            s32 = L::mad(c, t32, -(s * t31));
+
+            const L tx = q[x] * sh, ty = q[y] * sh, tz = q[z] * sh;
+            sh = sh * q[3];
+            for (luint i = 0; i < 4; i++)
+                q[i] = q[i] * ch;
+            q[z] = q[z] + sh;
+            q[3] = q[3] - tz;
+            q[x] = q[x] + ty;
+            q[y] = q[y] - tx;
+
+            const L n11 = s22, n21 = s32, n22 = t33, n31 = s21, n32 = s31, n33 = s11;
+            s11 = n11;
+            s21 = n21;
+            s22 = n22;
+            s31 = n31;
+            s32 = n32;
+            s33 = n33;
+        };
+        // Every sweep rotates the matrix back to its original order
+        for (luint sweep = 0; sweep < MGMATH_SVD3_SWEEPS; sweep++) {
+            conjugate(0, 1, 2);
+            conjugate(1, 2, 0);
+            conjugate(2, 0, 1);
+        }
+        const L inv_norm = L::rsqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        for (luint i = 0; i < 4; i++)
+            q[i] = q[i] * inv_norm;
+
+        sym[0] = s11;
+        sym[1] = s21;
+        sym[2] = s22;
+        sym[3] = s31;
+        sym[4] = s32;
+        sym[5] = s33;
+    }
+
+    /**
+     * @brief Where `swap` is set, swap the axes j and k (j < k) of the rotations in lanes, negating the new axis k so they stay rotations
+     */
+    template<typename L>
+    inline void lanes_swap_axes(const typename L::mask swap, const luint j, const luint k, L q[4]) {
+        const L half_sqrt2 = L::set(0.70710678118f);
+        // q multiplied by a rotation of 90 degrees around the third axis
+        L r[4];
+        if (j == 0 && k == 1) {
+            r[0] = q[0] + q[1];
+            r[1] = q[1] - q[0];
+            r[2] = q[3] + q[2];
+            r[3] = q[3] - q[2];
+        } else if (j == 0) {
+            r[0] = q[0] + q[2];
+            r[1] = q[1] - q[3];
+            r[2] = q[2] - q[0];
+            r[3] = q[3] + q[1];
+        } else {
+            r[0] = q[3] + q[0];
+            r[1] = q[1] + q[2];
+            r[2] = q[2] - q[1];
+            r[3] = q[3] - q[0];
+        }
+        for (luint i = 0; i < 4; i++)
+            q[i] = L::select(swap, r[i] * half_sqrt2, q[i]);
+    }
+
+    /**
+     * @brief Branch-free SVD of 3x3 matrices in lanes (`A = U * diag(sigma) * V^T`), after McAdams et al. "Computing the Singular Value Decomposition of 3x3 matrices with minimal branching and elementary floating point operations"
+     *
+     * V comes from a fixed number of approximate Jacobi rotations of `A^T * A`, the columns of `A * V` are sorted by length, and U
+     * comes from a QR decomposition of `A * V` with Givens rotations. U and V are returned as unit quaternions, so they are always
+     * rotations, and the last singular value is negative when A is a reflection
+     *
+     * @param a The matrices (row major)
+     * @param qu The quaternions of U
+     * @param sigma The singular values, sorted from largest to smallest (only the last one can be negative)
+     * @param qv The quaternions of V
+     */
+    template<typename L>
+    inline void lanes_svd3(const L a[9], L qu[4], L sigma[3], L qv[4]) {
+        const float epsilon = 1e-6f;
+        const L zero = L::set(0.0f), one = L::set(1.0f), two = L::set(2.0f);
+
+        // Symmetric A^T * A, only the lower triangle
+        L sym[6];
+        sym[0] = a[0] * a[0] + a[3] * a[3] + a[6] * a[6];
+        sym[1] = a[1] * a[0] + a[4] * a[3] + a[7] * a[6];
+        sym[2] = a[1] * a[1] + a[4] * a[4] + a[7] * a[7];
+        sym[3] = a[2] * a[0] + a[5] * a[3] + a[8] * a[6];
+        sym[4] = a[2] * a[1] + a[5] * a[4] + a[8] * a[7];
+        sym[5] = a[2] * a[2] + a[5] * a[5] + a[8] * a[8];
+        lanes_jacobi3(sym, qv);
+
+        L v[9], b[9];
+        lanes_quat_to_mat3(qv, v);
+        for (luint i = 0; i < 3; i++)
+            for (luint j = 0; j < 3; j++)
+                b[i * 3 + j] = a[i * 3] * v[j] + a[i * 3 + 1] * v[3 + j] + a[i * 3 + 2] * v[6 + j];
+
+        // Sort the columns of B by length, swapping them with one of them negated, so V stays a rotation (a rotation of 90 degrees around the third axis)
+        L rho[3];
+        for (luint j = 0; j < 3; j++)
+            rho[j] = b[j] * b[j] + b[3 + j] * b[3 + j] + b[6 + j] * b[6 + j];
+        const auto sort = [&](const luint j, const luint k) {
+            const auto swap = L::less(rho[j], rho[k]);
+            for (luint i = 0; i < 3; i++) {
+                const L bj = b[i * 3 + j];
+                b[i * 3 + j] = L::select(swap, b[i * 3 + k], bj);
+                b[i * 3 + k] = L::select(swap, -bj, b[i * 3 + k]);
+            }
+            const L r = rho[j];
+            rho[j] = L::select(swap, rho[k], r);
+            rho[k] = L::select(swap, r, rho[k]);
+            lanes_swap_axes(swap, j, k, qv);
+        };
+        sort(0, 1);
+        sort(0, 2);
+        sort(1, 2);
+
+        // QR decomposition of B, each Givens rotation zeroing one component below the diagonal
+        const auto givens = [&](const L a1, const L a2, L& ch, L& sh) {
+            const L rho_qr = L::sqrt(L::mad(a1, a1, a2 * a2));
+            sh = L::select(L::less(L::set(epsilon), rho_qr), a2, zero);
+            ch = L::abs(a1) + L::max(rho_qr, L::set(epsilon));
+            const auto negative = L::less(a1, zero);
+            const L t = sh;
+            sh = L::select(negative, ch, sh);
+            ch = L::select(negative, t, ch);
+            const L w = L::rsqrt(L::mad(ch, ch, sh * sh));
+            ch = ch * w;
+            sh = sh * w;
+        };
+        const auto rotate_lines = [&](const luint p, const luint q, const L ch, const L sh) {
+            const L c = one - two * sh * sh, s = two * ch * sh;
+            for (luint j = 0; j < 3; j++) {
+                const L bp = b[p * 3 + j], bq = b[q * 3 + j];
+                b[p * 3 + j] = L::mad(c, bp, s * bq);
+                b[q * 3 + j] = L::mad(c, bq, -(s * bp));
+            }
+        };
+        L ch1, sh1, ch2, sh2, ch3, sh3;
+        givens(b[0], b[3], ch1, sh1);
+        rotate_lines(0, 1, ch1, sh1);
+        givens(b[0], b[6], ch2, sh2);
+        rotate_lines(0, 2, ch2, sh2);
+        givens(b[4], b[7], ch3, sh3);
+        rotate_lines(1, 2, ch3, sh3);
+
+        sigma[0] = b[0];
+        sigma[1] = b[4];
+        sigma[2] = b[8];
+
+        // U is the transpose of the product of the rotations: around z, y, then x
+        const L px = sh1 * sh2, py = -(ch1 * sh2), pz = sh1 * ch2, pw = ch1 * ch2;
+        qu[0] = L::mad(pw, sh3, px * ch3);
+        qu[1] = L::mad(py, ch3, pz * sh3);
+        qu[2] = L::mad(pz, ch3, -(py * sh3));
+        qu[3] = L::mad(pw, ch3, -(px * sh3));
+    }
+
+    /**
+     * @brief Singular value decomposition of a 3x3 matrix `a = u * diag(sigma) * v^T`
+     */
+    struct svd3 {
+        mat<3, 3, float> u;
+        // Sorted from largest to smallest, only the last one is negative, when the matrix is a reflection (so u and v are always rotations)
+        vec<3, float> sigma;
+        mat<3, 3, float> v;
+    };
+
+    /**
+     * @brief Polar decomposition of a 3x3 matrix `a = rotation * stretch`
+     */
+    struct polar3 {
+        quat<float> rotation;
+        // Symmetric, with a negative eigenvalue when the matrix is a reflection
+        mat<3, 3, float> stretch;
+    };
+
+    /**
+     * @brief Load L::count matrices into lanes, one component per lane register
+     */
+    template<typename L>
+    inline void lanes_load_mat3(const mat<3, 3, float>* src, L m[9]) {
+        for (luint i = 0; i < 9; i++)
+            m[i] = L::load_strided(src[0][0].data() + i, sizeof(mat<3, 3, float>) / sizeof(float));
+    }
+
+    template<typename L>
+    inline void svd3_lanes_group(svd3* dst, const mat<3, 3, float>* src) {
+        L a[9], qu[4], sigma[3], qv[4], u[9], v[9];
+        lanes_load_mat3(src, a);
+        lanes_svd3(a, qu, sigma, qv);
+        lanes_quat_to_mat3(qu, u);
+        lanes_quat_to_mat3(qv, v);
+
+        alignas(32) float su[9][L::count], ss[3][L::count], sv[9][L::count];
+        for (luint i = 0; i < 9; i++) {
+            u[i].store(su[i]);
+            v[i].store(sv[i]);
+        }
+        for (luint i = 0; i < 3; i++)
+            sigma[i].store(ss[i]);
+        for (luint k = 0; k < L::count; k++) {
+            float *du = dst[k].u[0].data(), *dv = dst[k].v[0].data(), *ds = dst[k].sigma.data();
+            for (luint i = 0; i < 9; i++) {
+                du[i] = su[i][k];
+                dv[i] = sv[i][k];
+            }
+            for (luint i = 0; i < 3; i++)
+                ds[i] = ss[i][k];
+        }
+    }
+
+    template<typename L>
+    inline void polar3_lanes_group(polar3* dst, const mat<3, 3, float>* src) {
+        L a[9], qu[4], sigma[3], qv[4], v[9];
+        lanes_load_mat3(src, a);
+        lanes_svd3(a, qu, sigma, qv);
+        lanes_quat_to_mat3(qv, v);
+
+        // rotation = U * V^T, stretch = V * diag(sigma) * V^T
+        L qr[4];
+        qr[0] = qu[3] * -qv[0] + qu[0] * qv[3] + qu[1] * -qv[2] - qu[2] * -qv[1];
+        qr[1] = qu[3] * -qv[1] + qu[1] * qv[3] + qu[2] * -qv[0] - qu[0] * -qv[2];
+        qr[2] = qu[3] * -qv[2] + qu[2] * qv[3] + qu[0] * -qv[1] - qu[1] * -qv[0];
+        qr[3] = qu[3] * qv[3] + qu[0] * qv[0] + qu[1] * qv[1] + qu[2] * qv[2];
+
+        alignas(32) float sq[4][L::count], ss[9][L::count];
+        for (luint i = 0; i < 4; i++)
+            qr[i].store(sq[i]);
+        for (luint i = 0; i < 3; i++)
+            for (luint j = i; j < 3; j++)
+                (v[i * 3] * sigma[0] * v[j * 3] + v[i * 3 + 1] * sigma[1] * v[j * 3 + 1] + v[i * 3 + 2] * sigma[2] * v[j * 3 + 2]).store(ss[i * 3 + j]);
+        for (luint k = 0; k < L::count; k++) {
+            float *dq = dst[k].rotation.data(), *ds = dst[k].stretch[0].data();
+            for (luint i = 0; i < 4; i++)
+                dq[i] = sq[i][k];
+            for (luint i = 0; i < 3; i++)
+                for (luint j = i; j < 3; j++)
+                    ds[i * 3 + j] = ds[j * 3 + i] = ss[i * 3 + j][k];
+        }
+    }
+
+    /**
+     * @brief Calculate the singular value decomposition of a 3x3 matrix, without branches
+     */
+    inline svd3 svd(const mat<3, 3, float>& a) {
+        svd3 res;
+        svd3_lanes_group<float_lanes<1>>(&res, &a);
+        return res;
+    }
+
+    /**
+     * @brief Calculate the singular value decompositions of an array of 3x3 matrices (4 or 8 at a time when MGMATH_SIMD is defined)
+     *
+     * @param dst The array to write the decompositions to
+     * @param src The matrices to decompose
+     * @param count The number of matrices
+     */
+    inline void svd(svd3* dst, const mat<3, 3, float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_svd, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("svd", reinterpret_cast<const float*>(dst), count * (sizeof(svd3) / sizeof(float)), reinterpret_cast<const float*>(src), count * 9);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            svd3_lanes_group<float_lanes<8>>(dst + i, src + i);
+#endif
+        for (; i + 4 <= count; i += 4)
+            svd3_lanes_group<float_lanes<4>>(dst + i, src + i);
+#endif
+        // Counted from the number left rather than up to count, which GCC wrongly warns about when count is a constant
+        for (luint k = 0, rest = count - i; k < rest; k++)
+            svd3_lanes_group<float_lanes<1>>(dst + i + k, src + i + k);
+    }
+
+    /**
+     * @brief Split a 3x3 matrix into a rotation and a symmetric stretch (`a = rotation * stretch`), using the branch-free SVD
+     */
+    inline polar3 polar_decompose(const mat<3, 3, float>& a) {
+        polar3 res;
+        polar3_lanes_group<float_lanes<1>>(&res, &a);
+        return res;
+    }
+
+    /**
+     * @brief Calculate the polar decompositions of an array of 3x3 matrices (4 or 8 at a time when MGMATH_SIMD is defined)
+     *
+     * @param dst The array to write the decompositions to
+     * @param src The matrices to decompose
+     * @param count The number of matrices
+     */
+    inline void polar_decompose(polar3* dst, const mat<3, 3, float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_polar, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("polar_decompose", reinterpret_cast<const float*>(dst), count * (sizeof(polar3) / sizeof(float)), reinterpret_cast<const float*>(src), count * 9);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            polar3_lanes_group<float_lanes<8>>(dst + i, src + i);
+#endif
+        for (; i + 4 <= count; i += 4)
+            polar3_lanes_group<float_lanes<4>>(dst + i, src + i);
+#endif
+        for (luint k = 0, rest = count - i; k < rest; k++)
+            polar3_lanes_group<float_lanes<1>>(dst + i + k, src + i + k);
+    }
+
+
+    /**
+     * @brief Eigen decomposition of a symmetric 3x3 matrix `a = vectors * diag(values) * vectors^T`
+     */
+    template<typename T>
+    struct eigen3 {
+        // Sorted from largest to smallest
+        vec<3, T> values;
+        // The eigenvectors are the columns, and form a rotation
+        mat<3, 3, T> vectors;
+    };
+
+    /**
+     * @brief Calculate the eigenvalues and eigenvectors of a symmetric 3x3 matrix, with Jacobi rotations until it is diagonal
+     *
+     * @param a The matrix, only its upper triangle is read
+     */
+    template<typename T>
+    inline eigen3<T> eigen_symmetric(const mat<3, 3, T>& a) {
+        static_assert(std::is_floating_point_v<T>, "Decompositions are only available for float and double matrices");
+
+        mat<3, 3, T> s = a, v(T(1));
+        for (luint i = 1; i < 3; i++)
+            for (luint j = 0; j < i; j++)
+                s[i][j] = s[j][i];
+
+        const T epsilon = std::numeric_limits<T>::epsilon();
+        for (luint sweep = 0; sweep < 32; sweep++) {
+            const T off = s[0][1] * s[0][1] + s[0][2] * s[0][2] + s[1][2] * s[1][2];
+            const T diag = s[0][0] * s[0][0] + s[1][1] * s[1][1] + s[2][2] * s[2][2];
+            if (off <= epsilon * epsilon * diag)
+                break;
+
+            for (luint p = 0; p < 2; p++) {
+                for (luint q = p + 1; q < 3; q++) {
+                    if (s[p][q] == T(0))
+                        continue;
+
+                    // Smallest angle zeroing s[p][q], as in Numerical Recipes
+                    const T theta = (s[q][q] - s[p][p]) / (T(2) * s[p][q]);
+                    const T t = (theta >= T(0) ? T(1) : T(-1)) / (std::abs(theta) + std::sqrt(mad(theta, theta, T(1))));
+                    const T c = T(1) / std::sqrt(mad(t, t, T(1))), sn = t * c;
+
+                    for (luint k = 0; k < 3; k++) {
+                        const T skp = s[k][p], skq = s[k][q];
+                        s[k][p] = c * skp - sn * skq;
+                        s[k][q] = sn * skp + c * skq;
+                    }
+                    for (luint k = 0; k < 3; k++) {
+                        const T spk = s[p][k], sqk = s[q][k];
+                        s[p][k] = c * spk - sn * sqk;
+                        s[q][k] = sn * spk + c * sqk;
+                    }
+                    s[p][q] = s[q][p] = T(0);
+                    for (luint k = 0; k < 3; k++) {
+                        const T vkp = v[k][p], vkq = v[k][q];
+                        v[k][p] = c * vkp - sn * vkq;
+                        v[k][q] = sn * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+
+        eigen3<T> res;
+        res.values = vec<3, T>{s[0][0], s[1][1], s[2][2]};
+        for (luint j = 0; j < 2; j++) {
+            luint largest = j;
+            for (luint k = j + 1; k < 3; k++)
+                if (res.values[k] > res.values[largest])
+                    largest = k;
+            if (largest != j) {
+                std::swap(res.values[j], res.values[largest]);
+                for (luint k = 0; k < 3; k++)
+                    std::swap(v[k][j], v[k][largest]);
+            }
+        }
+        if (v.det() < T(0))
+            for (luint k = 0; k < 3; k++)
+                v[k][2] = -v[k][2];
+        res.vectors = v;
+        return res;
+    }
+
+    template<typename L>
+    inline void eigen3_lanes_group(eigen3<float>* dst, const mat<3, 3, float>* src) {
+        L a[9], sym[6], q[4], v[9];
+        lanes_load_mat3(src, a);
+        sym[0] = a[0];
+        sym[1] = a[1];
+        sym[2] = a[4];
+        sym[3] = a[2];
+        sym[4] = a[5];
+        sym[5] = a[8];
+        lanes_jacobi3(sym, q);
+
+        L values[3] = {sym[0], sym[2], sym[5]};
+        const auto sort = [&](const luint j, const luint k) {
+            const auto swap = L::less(values[j], values[k]);
+            const L t = values[j];
+            values[j] = L::select(swap, values[k], t);
+            values[k] = L::select(swap, t, values[k]);
+            lanes_swap_axes(swap, j, k, q);
+        };
+        sort(0, 1);
+        sort(0, 2);
+        sort(1, 2);
+        lanes_quat_to_mat3(q, v);
+
+        alignas(32) float sv[9][L::count], sl[3][L::count];
+        for (luint i = 0; i < 9; i++)
+            v[i].store(sv[i]);
+        for (luint i = 0; i < 3; i++)
+            values[i].store(sl[i]);
+        for (luint k = 0; k < L::count; k++) {
+            float *dv = dst[k].vectors[0].data(), *dl = dst[k].values.data();
+            for (luint i = 0; i < 9; i++)
+                dv[i] = sv[i][k];
+            for (luint i = 0; i < 3; i++)
+                dl[i] = sl[i][k];
+        }
+    }
+
+    /**
+     * @brief Calculate the eigen decompositions of an array of symmetric 3x3 matrices, without branches (4 or 8 at a time when MGMATH_SIMD is defined)
+     *
+     * Runs the same fixed number of Jacobi sweeps as the SVD (MGMATH_SVD3_SWEEPS) instead of iterating until convergence
+     *
+     * @param dst The array to write the decompositions to
+     * @param src The matrices to decompose, only their upper triangle is read
+     * @param count The number of matrices
+     */
+    inline void eigen_symmetric(eigen3<float>* dst, const mat<3, 3, float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_eigen, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("eigen_symmetric", reinterpret_cast<const float*>(dst), count * (sizeof(eigen3<float>) / sizeof(float)), reinterpret_cast<const float*>(src), count * 9);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            eigen3_lanes_group<float_lanes<8>>(dst + i, src + i);
+#endif
+        for (; i + 4 <= count; i += 4)
+            eigen3_lanes_group<float_lanes<4>>(dst + i, src + i);
+#endif
+        for (luint k = 0, rest = count - i; k < rest; k++)
+            eigen3_lanes_group<float_lanes<1>>(dst + i + k, src + i + k);
+    }
+
+
+    /**
+     * @brief A transform split into a translation, a rotation and a scale, applied in the order scale, rotation, then translation
+     */
+    template<typename T>
+    struct trs {
+        vec<3, T> translation;
+        quat<T> rotation;
+        vec<3, T> scale{T(1)};
+    };
+
+    /**
+     * @brief Split a 4x4 transform matrix (without shear or projection) into translation, rotation and scale
+     *
+     * A reflection is kept as a negative x scale, so the rotation is always valid. The scale must not be zero
+     */
+    template<typename T>
+    inline trs<T> decompose(const mat<4, 4, T>& m) {
+        static_assert(std::is_floating_point_v<T>, "Decompositions are only available for float and double matrices");
+
+        trs<T> res;
+        res.translation = vec<3, T>{m[0][3], m[1][3], m[2][3]};
+        mat<3, 3, T> r;
+        for (luint j = 0; j < 3; j++)
+            res.scale[j] = std::sqrt(m[0][j] * m[0][j] + m[1][j] * m[1][j] + m[2][j] * m[2][j]);
+        const T det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        if (det < T(0))
+            res.scale[0] = -res.scale[0];
+        for (luint i = 0; i < 3; i++)
+            for (luint j = 0; j < 3; j++)
+                r[i][j] = m[i][j] / res.scale[j];
+        // Normalized so small errors in the matrix don't leak into the quaternion
+        res.rotation = static_cast<quat<T>>(quat<T>::from_mat3(r).normalized());
+        return res;
+    }
+
+    /**
+     * @brief Build the 4x4 transform matrix `translation * rotation * scale` directly, without multiplying matrices
+     */
+    template<typename T>
+    inline mat<4, 4, T> compose(const vec<3, T>& translation, const quat<T>& rotation, const vec<3, T>& scale) {
+        const mat<3, 3, T> r = rotation.as_rotation_mat3();
+        return mat<4, 4, T>{
+            r[0][0] * scale[0], r[0][1] * scale[1], r[0][2] * scale[2], translation[0],
+            r[1][0] * scale[0], r[1][1] * scale[1], r[1][2] * scale[2], translation[1],
+            r[2][0] * scale[0], r[2][1] * scale[1], r[2][2] * scale[2], translation[2],
+            T(0), T(0), T(0), T(1)
+        };
+    }
+
+    /**
+     * @brief Build the 4x4 transform matrix of a split transform
+     */
+    template<typename T>
+    inline mat<4, 4, T> compose(const trs<T>& t) {
+        return compose(t.translation, t.rotation, t.scale);
+    }
+
+    /**
+     * @brief Shepperd's method in lanes, every case computed and the one of the largest component selected
+     */
+    template<typename L>
+    inline void lanes_quat_from_mat3(const L m[9], L q[4]) {
+        const L one = L::set(1.0f);
+        L best = one + m[0] + m[4] + m[8];
+        q[0] = m[7] - m[5];
+        q[1] = m[2] - m[6];
+        q[2] = m[3] - m[1];
+        q[3] = best;
+        const auto use = [&](const L t, const L x, const L y, const L z, const L w) {
+            const auto larger = L::less(best, t);
+            best = L::select(larger, t, best);
+            q[0] = L::select(larger, x, q[0]);
+            q[1] = L::select(larger, y, q[1]);
+            q[2] = L::select(larger, z, q[2]);
+            q[3] = L::select(larger, w, q[3]);
+        };
+        const L tx = one + m[0] - m[4] - m[8], ty = one - m[0] + m[4] - m[8], tz = one - m[0] - m[4] + m[8];
+        use(tx, tx, m[1] + m[3], m[2] + m[6], m[7] - m[5]);
+        use(ty, m[1] + m[3], ty, m[5] + m[7], m[2] - m[6]);
+        use(tz, m[2] + m[6], m[5] + m[7], tz, m[3] - m[1]);
+
+        // Normalizing directly also divides by the largest component
+        const L inv_norm = L::rsqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        for (luint i = 0; i < 4; i++)
+            q[i] = q[i] * inv_norm;
+    }
+
+    template<typename L>
+    inline void decompose_lanes_group(trs<float>* dst, const mat<4, 4, float>* src) {
+        L r[9], scale[3], q[4];
+        for (luint i = 0; i < 3; i++)
+            for (luint j = 0; j < 3; j++)
+                r[i * 3 + j] = L::load_strided(src[0][0].data() + i * 4 + j, sizeof(mat<4, 4, float>) / sizeof(float));
+        for (luint j = 0; j < 3; j++)
+            scale[j] = L::sqrt(r[j] * r[j] + r[3 + j] * r[3 + j] + r[6 + j] * r[6 + j]);
+        const L det = r[0] * (r[4] * r[8] - r[5] * r[7]) - r[1] * (r[3] * r[8] - r[5] * r[6]) + r[2] * (r[3] * r[7] - r[4] * r[6]);
+        scale[0] = L::select(L::less(det, L::set(0.0f)), -scale[0], scale[0]);
+        for (luint j = 0; j < 3; j++) {
+            const L inv_scale = L::set(1.0f) / scale[j];
+            for (luint i = 0; i < 3; i++)
+                r[i * 3 + j] = r[i * 3 + j] * inv_scale;
+        }
+        lanes_quat_from_mat3(r, q);
+
+        alignas(32) float sq[4][L::count], ss[3][L::count];
+        for (luint i = 0; i < 4; i++)
+            q[i].store(sq[i]);
+        for (luint i = 0; i < 3; i++)
+            scale[i].store(ss[i]);
+        for (luint k = 0; k < L::count; k++) {
+            const float* m = src[k][0].data();
+            float *dt = dst[k].translation.data(), *dq = dst[k].rotation.data(), *ds = dst[k].scale.data();
+            for (luint i = 0; i < 3; i++) {
+                dt[i] = m[i * 4 + 3];
+                ds[i] = ss[i][k];
+            }
+            for (luint i = 0; i < 4; i++)
+                dq[i] = sq[i][k];
+        }
+    }
+
+    template<typename L>
+    inline void compose_lanes_group(mat<4, 4, float>* dst, const trs<float>* src) {
+        constexpr luint stride = sizeof(trs<float>) / sizeof(float);
+        L q[4], scale[3], r[9];
+        for (luint i = 0; i < 4; i++)
+            q[i] = L::load_strided(src[0].rotation.data() + i, stride);
+        for (luint i = 0; i < 3; i++)
+            scale[i] = L::load_strided(src[0].scale.data() + i, stride);
+        lanes_quat_to_mat3(q, r);
+        alignas(32) float sr[9][L::count];
+        for (luint i = 0; i < 3; i++)
+            for (luint j = 0; j < 3; j++)
+                (r[i * 3 + j] * scale[j]).store(sr[i * 3 + j]);
+
+        for (luint k = 0; k < L::count; k++) {
+            const float* t = src[k].translation.data();
+            float* m = dst[k][0].data();
+            for (luint i = 0; i < 3; i++) {
+                for (luint j = 0; j < 3; j++)
+                    m[i * 4 + j] = sr[i * 3 + j][k];
+                m[i * 4 + 3] = t[i];
+            }
+            m[12] = m[13] = m[14] = 0.0f;
+            m[15] = 1.0f;
+        }
+    }
+
+    /**
+     * @brief Split an array of 4x4 transform matrices into translations, rotations and scales (4 or 8 at a time when MGMATH_SIMD is defined)
+     *
+     * @param dst The array to write the split transforms to
+     * @param src The matrices to split
+     * @param count The number of matrices
+     */
+    inline void decompose(trs<float>* dst, const mat<4, 4, float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_decompose, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("decompose", reinterpret_cast<const float*>(dst), count * (sizeof(trs<float>) / sizeof(float)), reinterpret_cast<const float*>(src), count * 16);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            decompose_lanes_group<float_lanes<8>>(dst + i, src + i);
+#endif
+        for (; i + 4 <= count; i += 4)
+            decompose_lanes_group<float_lanes<4>>(dst + i, src + i);
+#endif
+        for (luint k = 0, rest = count - i; k < rest; k++)
+            decompose_lanes_group<float_lanes<1>>(dst + i + k, src + i + k);
+    }
+
+    /**
+     * @brief Build the 4x4 transform matrices of an array of split transforms (4 or 8 at a time when MGMATH_SIMD is defined)
+     *
+     * @param dst The array to write the matrices to
+     * @param src The split transforms, with unit quaternions
+     * @param count The number of transforms
+     */
+    inline void compose(mat<4, 4, float>* dst, const trs<float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_compose, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("compose", reinterpret_cast<const float*>(dst), count * 16, reinterpret_cast<const float*>(src), count * (sizeof(trs<float>) / sizeof(float)));
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            compose_lanes_group<float_lanes<8>>(dst + i, src + i);
+#endif
+        for (; i + 4 <= count; i += 4)
+            compose_lanes_group<float_lanes<4>>(dst + i, src + i);
+#endif
+        for (luint k = 0, rest = count - i; k < rest; k++)
+            compose_lanes_group<float_lanes<1>>(dst + i + k, src + i + k);
+    }
+
+
+    //============
+    // STATISTICS
+    //============
+
+    /**
+     * @brief Running mean and covariance of 3D points, in a single pass
+     *
+     * Accumulators filled from separate parts of a point set (on separate threads for example) can be merged into one
+     */
+    template<typename T>
+    struct covariance_accumulator {
+        static_assert(std::is_floating_point_v<T>, "Covariances are only available for float and double vectors");
+
+        luint count = 0;
+        vec<3, T> mean;
+        // Sums of the products of the deviations from the mean: xx, xy, xz, yy, yz, zz
+        T comoments[6] = {};
+
+        /**
+         * @brief Add a point (Welford's update)
+         */
+        void add(const vec<3, T>& p) {
+            count++;
+            const vec<3, T> before = p - mean;
+            mean += before / T(count);
+            const vec<3, T> after = p - mean;
+            comoments[0] = mad(before[0], after[0], comoments[0]);
+            comoments[1] = mad(before[0], after[1], comoments[1]);
+            comoments[2] = mad(before[0], after[2], comoments[2]);
+            comoments[3] = mad(before[1], after[1], comoments[3]);
+            comoments[4] = mad(before[1], after[2], comoments[4]);
+            comoments[5] = mad(before[2], after[2], comoments[5]);
+        }
+
+        /**
+         * @brief Add an array of points
+         *
+         * @param points The points to add
+         * @param n The number of points
+         */
+        void add(const vec<3, T>* points, const luint n) {
+            if (n == 0)
+                return;
+
+            // Plain sums of the points relative to the first one, which stay small enough to not cancel out, then merged as a whole
+            const vec<3, T> shift = points[0];
+            T sum[3] = {}, products[6] = {};
+            for (luint i = 0; i < n; i++) {
+                const T x = points[i][0] - shift[0], y = points[i][1] - shift[1], z = points[i][2] - shift[2];
+                sum[0] += x;
+                sum[1] += y;
+                sum[2] += z;
+                products[0] = mad(x, x, products[0]);
+                products[1] = mad(x, y, products[1]);
+                products[2] = mad(x, z, products[2]);
+                products[3] = mad(y, y, products[3]);
+                products[4] = mad(y, z, products[4]);
+                products[5] = mad(z, z, products[5]);
+            }
+
+            covariance_accumulator<T> part;
+            part.count = n;
+            const T inv_n = T(1) / T(n);
+            part.mean = shift + vec<3, T>{sum[0], sum[1], sum[2]} * inv_n;
+            part.comoments[0] = products[0] - sum[0] * sum[0] * inv_n;
+            part.comoments[1] = products[1] - sum[0] * sum[1] * inv_n;
+            part.comoments[2] = products[2] - sum[0] * sum[2] * inv_n;
+            part.comoments[3] = products[3] - sum[1] * sum[1] * inv_n;
+            part.comoments[4] = products[4] - sum[1] * sum[2] * inv_n;
+            part.comoments[5] = products[5] - sum[2] * sum[2] * inv_n;
+            merge(part);
+        }
+
+        /**
+         * @brief Add the points of another accumulator (Chan et al.)
+         */
+        void merge(const covariance_accumulator<T>& other) {
+            if (other.count == 0)
+                return;
+            if (count == 0) {
+                *this = other;
+                return;
+            }
+
+            const T total = T(count + other.count);
+            const vec<3, T> d = other.mean - mean;
+            const T f = T(count) * T(other.count) / total;
+            comoments[0] += other.comoments[0] + d[0] * d[0] * f;
+            comoments[1] += other.comoments[1] + d[0] * d[1] * f;
+            comoments[2] += other.comoments[2] + d[0] * d[2] * f;
+            comoments[3] += other.comoments[3] + d[1] * d[1] * f;
+            comoments[4] += other.comoments[4] + d[1] * d[2] * f;
+            comoments[5] += other.comoments[5] + d[2] * d[2] * f;
+            mean = vec<3, T>::mad(d, T(other.count) / total, mean);
+            count += other.count;
+        }
+
+        /**
+         * @brief Get the covariance matrix of the points added so far (divided by the number of points, zero when there are none)
+         */
+        mat<3, 3, T> covariance() const {
+            if (count == 0)
+                return mat<3, 3, T>(T(0));
+            const T inv_n = T(1) / T(count);
+            const T xx = comoments[0] * inv_n, xy = comoments[1] * inv_n, xz = comoments[2] * inv_n;
+            const T yy = comoments[3] * inv_n, yz = comoments[4] * inv_n, zz = comoments[5] * inv_n;
+            return mat<3, 3, T>(xx, xy, xz, xy, yy, yz, xz, yz, zz);
+        }
+    };
+
+    /**
+     * @brief Calculate the covariance matrix of an array of points
+     *
+     * @param points The points
+     * @param count The number of points
+     */
+    template<typename T>
+    inline mat<3, 3, T> covariance_of(const vec<3, T>* points, const luint count) {
+        covariance_accumulator<T> acc;
+        acc.add(points, count);
+        return acc.covariance();
+    }
+
+    /**
+     * @brief Estimate the normal of a surface from points around a position (the direction in which they vary the least)
+     *
+     * The sign of the normal is arbitrary, it must be oriented with a view point or the neighbouring normals
+     *
+     * @param neighbours The points near the position, usually its k nearest neighbours
+     * @param count The number of points
+     */
+    template<typename T>
+    inline vec<3, T> estimate_normal(const vec<3, T>* neighbours, const luint count) {
+        const mat<3, 3, T> vectors = eigen_symmetric(covariance_of(neighbours, count)).vectors;
+        return vec<3, T>{vectors[0][2], vectors[1][2], vectors[2][2]};
+    }
+
+    /**
+     * @brief Estimate the normals of a point cloud from the neighbours of every point, with the batched eigen decomposition
+     *
+     * @param dst The array to write the normals to
+     * @param points The points of the cloud
+     * @param neighbours The k indices (into points) of the neighbours of every point, one after the other
+     * @param k The number of neighbours of every point
+     * @param count The number of normals to estimate
+     */
+    inline void estimate_normals(vec<3, float>* dst, const vec<3, float>* points, const luint* neighbours, const luint k, const luint count) {
+        constexpr luint group = 8;
+        mat<3, 3, float> covariances[group];
+        eigen3<float> decompositions[group];
+        for (luint i = 0; i < count; i += group) {
+            const luint n = count - i < group ? count - i : group;
+            for (luint j = 0; j < n; j++) {
+                covariance_accumulator<float> acc;
+                for (luint m = 0; m < k; m++)
+                    acc.add(points[neighbours[(i + j) * k + m]]);
+                covariances[j] = acc.covariance();
+            }
+            eigen_symmetric(decompositions, covariances, n);
+            for (luint j = 0; j < n; j++)
+                dst[i + j] = vec<3, float>{decompositions[j].vectors[0][2], decompositions[j].vectors[1][2], decompositions[j].vectors[2][2]};
+        }
+    }
+
+
+    //===========
+    // COLLISION
+    //===========
+
+    /**
+     * @brief A sphere
+     */
+    template<typename T>
+    struct sphere {
+        static_assert(std::is_floating_point_v<T>, "Collision primitives are only available for float and double");
+
+        vec<3, T> center;
+        T radius;
+    };
+
+    /**
+     * @brief A capsule: the points within radius of the segment from a to b
+     */
+    template<typename T>
+    struct capsule {
+        static_assert(std::is_floating_point_v<T>, "Collision primitives are only available for float and double");
+
+        vec<3, T> a;
+        vec<3, T> b;
+        T radius;
+    };
+
+    /**
+     * @brief An oriented box: the points `center + rotation * local` with every |local[i]| <= half_extents[i], so the
+     * axes of the box are the columns of rotation
+     */
+    template<typename T>
+    struct obb {
+        static_assert(std::is_floating_point_v<T>, "Collision primitives are only available for float and double");
+
+        vec<3, T> center;
+        vec<3, T> half_extents;
+        mat<3, 3, T> rotation;
+
+        /**
+         * @brief Build a box oriented by a unit quaternion
+         */
+        static obb<T> from_quat(const vec<3, T>& center, const vec<3, T>& half_extents, const quat<T>& rotation) {
+            return obb<T>{center, half_extents, rotation.as_rotation_mat3()};
+        }
+    };
+
+    // Added to the absolute values of the rotation between two boxes, so nearly parallel edges (whose cross product is
+    // close to zero) don't make the separating axis test miss overlaps. Relative to the half extents
+    static constexpr double obb_sat_epsilon = 1e-6;
+
+    /**
+     * @brief Calculate the squared distance between a point and the segment from a to b
+     */
+    template<typename T>
+    inline T segment_distance_squared(const vec<3, T>& p, const vec<3, T>& a, const vec<3, T>& b) {
+        const vec<3, T> ab = b - a, ap = p - a;
+        const T len_sq = ab.length_squared();
+        const T t = len_sq > T(0) ? clamp(T(0), T(1), ap.dot(ab) / len_sq) : T(0);
+        return (ap - ab * t).length_squared();
+    }
+
+    /**
+     * @brief Calculate the squared distance between the segments from p1 to q1 and from p2 to q2
+     */
+    template<typename T>
+    inline T segments_distance_squared(const vec<3, T>& p1, const vec<3, T>& q1, const vec<3, T>& p2, const vec<3, T>& q2) {
+        const vec<3, T> d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+        const T a = d1.dot(d1), e = d2.dot(d2), b = d1.dot(d2), c = d1.dot(r), f = d2.dot(r);
+        const T denom = a * e - b * b;
+        // Closest points of the lines clamped to the segments, then each parameter recomputed from the other
+        // (Ericson's closest points of two segments, with its branches folded into clamps)
+        T s = denom > T(0) ? clamp(T(0), T(1), (b * f - c * e) / denom) : T(0);
+        const T t = e > T(0) ? clamp(T(0), T(1), (b * s + f) / e) : T(0);
+        s = a > T(0) ? clamp(T(0), T(1), (b * t - c) / a) : T(0);
+        return (r + d1 * s - d2 * t).length_squared();
+    }
+
+    /**
+     * @brief Calculate the squared distance between a segment and a box centered on the origin, in the frame of the box
+     *
+     * The squared distance is convex along the segment, and its derivative is continuous and linear between the points
+     * where the segment crosses the planes of the faces. The minimum is found between the last of those points where the
+     * derivative is negative and the first where it is positive, by solving the linear derivative there
+     *
+     * @param p The start of the segment
+     * @param d The segment, from its start to its end
+     * @param h The half extents of the box
+     */
+    template<typename T>
+    inline T segment_box_distance_squared(const vec<3, T>& p, const vec<3, T>& d, const vec<3, T>& h) {
+        // Half the derivative of the squared distance, at p + d * t
+        const auto slope = [&](const T t) {
+            T res = T(0);
+            for (luint i = 0; i < 3; i++) {
+                const T x = p[i] + d[i] * t;
+                res += (x - clamp(-h[i], h[i], x)) * d[i];
+            }
+            return res;
+        };
+
+        T low = T(0), high = T(1);
+        for (luint i = 0; i < 3; i++) {
+            if (d[i] == T(0))
+                continue;
+            const T faces[2] = {-h[i], h[i]};
+            for (const T face : faces) {
+                const T t = clamp(T(0), T(1), (face - p[i]) / d[i]);
+                const T s = slope(t);
+                if (s <= T(0))
+                    low = max(low, t);
+                if (s >= T(0))
+                    high = min(high, t);
+            }
+        }
+
+        const T slope_low = slope(low), slope_high = slope(high);
+        T t = low;
+        if (slope_low < T(0))
+            t = slope_high > T(0) ? low - slope_low * (high - low) / (slope_high - slope_low) : high;
+        T res = T(0);
+        for (luint i = 0; i < 3; i++) {
+            const T x = p[i] + d[i] * t;
+            const T outside = x - clamp(-h[i], h[i], x);
+            res += outside * outside;
+        }
+        return res;
+    }
+
+    /**
+     * @brief Test whether two primitives overlap (touching counts as overlapping)
+     */
+    template<typename T>
+    inline bool overlap(const sphere<T>& a, const sphere<T>& b) {
+        const T r = a.radius + b.radius;
+        return (a.center - b.center).length_squared() <= r * r;
+    }
+    template<typename T>
+    inline bool overlap(const sphere<T>& a, const capsule<T>& b) {
+        const T r = a.radius + b.radius;
+        return segment_distance_squared(a.center, b.a, b.b) <= r * r;
+    }
+    template<typename T>
+    inline bool overlap(const capsule<T>& a, const sphere<T>& b) {
+        return overlap(b, a);
+    }
+    template<typename T>
+    inline bool overlap(const capsule<T>& a, const capsule<T>& b) {
+        const T r = a.radius + b.radius;
+        return segments_distance_squared(a.a, a.b, b.a, b.b) <= r * r;
+    }
+    template<typename T>
+    inline bool overlap(const sphere<T>& a, const obb<T>& b) {
+        // Distance from the center of the sphere to the box, along the axes of the box
+        const vec<3, T> d = a.center - b.center;
+        T dist_sq = T(0);
+        for (luint i = 0; i < 3; i++) {
+            const T local = d[0] * b.rotation[0][i] + d[1] * b.rotation[1][i] + d[2] * b.rotation[2][i];
+            const T outside = max(std::abs(local) - b.half_extents[i], T(0));
+            dist_sq += outside * outside;
+        }
+        return dist_sq <= a.radius * a.radius;
+    }
+    template<typename T>
+    inline bool overlap(const obb<T>& a, const sphere<T>& b) {
+        return overlap(b, a);
+    }
+    template<typename T>
+    inline bool overlap(const capsule<T>& a, const obb<T>& b) {
+        // The segment of the capsule in the frame of the box
+        const vec<3, T> p = a.a - b.center, d = a.b - a.a;
+        vec<3, T> local_p, local_d;
+        for (luint i = 0; i < 3; i++) {
+            local_p[i] = p[0] * b.rotation[0][i] + p[1] * b.rotation[1][i] + p[2] * b.rotation[2][i];
+            local_d[i] = d[0] * b.rotation[0][i] + d[1] * b.rotation[1][i] + d[2] * b.rotation[2][i];
+        }
+        return segment_box_distance_squared(local_p, local_d, b.half_extents) <= a.radius * a.radius;
+    }
+    template<typename T>
+    inline bool overlap(const obb<T>& a, const capsule<T>& b) {
+        return overlap(b, a);
+    }
+    template<typename T>
+    inline bool overlap(const obb<T>& a, const obb<T>& b) {
+        // Separating axis test over the 3 axes of a, the 3 axes of b and their 9 cross products (Gottschalk et al.),
+        // with the rotation of b and the offset between the centers expressed in the frame of a
+        const vec<3, T> d = b.center - a.center;
+        const T* ha = a.half_extents.data();
+        const T* hb = b.half_extents.data();
+        T t[3], r[3][3], abs_r[3][3];
+        for (luint i = 0; i < 3; i++) {
+            t[i] = d[0] * a.rotation[0][i] + d[1] * a.rotation[1][i] + d[2] * a.rotation[2][i];
+            for (luint j = 0; j < 3; j++) {
+                r[i][j] = a.rotation[0][i] * b.rotation[0][j] + a.rotation[1][i] * b.rotation[1][j] + a.rotation[2][i] * b.rotation[2][j];
+                abs_r[i][j] = std::abs(r[i][j]) + T(obb_sat_epsilon);
+            }
+        }
+
+        for (luint i = 0; i < 3; i++)
+            if (std::abs(t[i]) > ha[i] + hb[0] * abs_r[i][0] + hb[1] * abs_r[i][1] + hb[2] * abs_r[i][2])
+                return false;
+        for (luint j = 0; j < 3; j++)
+            if (std::abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > ha[0] * abs_r[0][j] + ha[1] * abs_r[1][j] + ha[2] * abs_r[2][j] + hb[j])
+                return false;
+        for (luint i = 0; i < 3; i++) {
+            const luint i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+            for (luint j = 0; j < 3; j++) {
+                const luint j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+                if (std::abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ha[i1] * abs_r[i2][j] + ha[i2] * abs_r[i1][j] + hb[j1] * abs_r[i][j2] + hb[j2] * abs_r[i][j1])
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Float primitives stored as one array per component (structure of arrays), in the order of the members of P
+     * (x, y and z of a vector, and the matrices row by row)
+     */
+    template<typename P>
+    struct soa_view {
+        static constexpr luint components = sizeof(P) / sizeof(float);
+        const float* data[components];
+    };
+
+#if defined(MGMATH_CHECK_FLOATS)
+    /**
+     * @brief Look for NaN, infinite and denormal values in every component array of a view (of count values each)
+     */
+    template<typename P>
+    inline uint32 float_issues(const soa_view<P>* view, const luint count) {
+        uint32 res = 0;
+        for (luint k = 0; k < soa_view<P>::components; k++)
+            res |= float_issues(view->data[k], count);
+        return res;
+    }
+#endif
+
+    /**
+     * @brief Copy an array of primitives into one array per component
+     *
+     * @param storage Room for count primitives, which holds the arrays one after the other
+     * @param src The primitives
+     * @param count The number of primitives
+     */
+    template<typename P>
+    inline soa_view<P> to_soa(float* storage, const P* src, const luint count) {
+        soa_view<P> res;
+        for (luint k = 0; k < soa_view<P>::components; k++)
+            res.data[k] = storage + k * count;
+        for (luint i = 0; i < count; i++) {
+            const float* p = reinterpret_cast<const float*>(src + i);
+            for (luint k = 0; k < soa_view<P>::components; k++)
+                storage[k * count + i] = p[k];
+        }
+        return res;
+    }
+
+    template<typename L>
+    inline L lanes_dot3(const L* a, const L* b) {
+        return L::mad(a[0], b[0], L::mad(a[1], b[1], a[2] * b[2]));
+    }
+
+    template<typename L>
+    inline L lanes_clamp01(const L x) {
+        return L::min(L::max(x, L::set(0.0f)), L::set(1.0f));
+    }
+
+    /**
+     * @brief Squared distance between a point and a segment, in lanes (a zero length segment is its first point)
+     */
+    template<typename L>
+    inline L lanes_segment_distance_squared(const L* p, const L* a, const L* b) {
+        const L zero = L::set(0.0f);
+        const L ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        const L ap[3] = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+        const L len_sq = lanes_dot3(ab, ab);
+        const L t = L::select(L::less(zero, len_sq), lanes_clamp01(lanes_dot3(ap, ab) / len_sq), zero);
+        const L d[3] = {ap[0] - ab[0] * t, ap[1] - ab[1] * t, ap[2] - ab[2] * t};
+        return lanes_dot3(d, d);
+    }
+
+    /**
+     * @brief Squared distance between two segments, in lanes, with the same steps as segments_distance_squared
+     */
+    template<typename L>
+    inline L lanes_segments_distance_squared(const L* p1, const L* q1, const L* p2, const L* q2) {
+        const L zero = L::set(0.0f);
+        const L d1[3] = {q1[0] - p1[0], q1[1] - p1[1], q1[2] - p1[2]};
+        const L d2[3] = {q2[0] - p2[0], q2[1] - p2[1], q2[2] - p2[2]};
+        const L r[3] = {p1[0] - p2[0], p1[1] - p2[1], p1[2] - p2[2]};
+        const L a = lanes_dot3(d1, d1), e = lanes_dot3(d2, d2), b = lanes_dot3(d1, d2), c = lanes_dot3(d1, r), f = lanes_dot3(d2, r);
+        const L denom = a * e - b * b;
+        // Divisions by zero only happen in lanes that select zero instead
+        L s = L::select(L::less(zero, denom), lanes_clamp01((b * f - c * e) / denom), zero);
+        const L t = L::select(L::less(zero, e), lanes_clamp01(L::mad(b, s, f) / e), zero);
+        s = L::select(L::less(zero, a), lanes_clamp01((b * t - c) / a), zero);
+        const L d[3] = {r[0] + d1[0] * s - d2[0] * t, r[1] + d1[1] * s - d2[1] * t, r[2] + d1[2] * s - d2[2] * t};
+        return lanes_dot3(d, d);
+    }
+
+    /**
+     * @brief Squared distance between a segment and a box centered on the origin, in the frame of the box, in lanes, with
+     * the same steps as segment_box_distance_squared
+     */
+    template<typename L>
+    inline L lanes_segment_box_distance_squared(const L* p, const L* d, const L* h) {
+        const L zero = L::set(0.0f), one = L::set(1.0f);
+        const auto slope = [&](const L t) {
+            L res = zero;
+            for (luint i = 0; i < 3; i++) {
+                const L x = L::mad(d[i], t, p[i]);
+                res = L::mad(x - L::min(L::max(x, zero - h[i]), h[i]), d[i], res);
+            }
+            return res;
+        };
+
+        L low = zero, high = one;
+        for (luint i = 0; i < 3; i++) {
+            const typename L::mask moving = L::less(zero, L::abs(d[i]));
+            const L faces[2] = {zero - h[i], h[i]};
+            for (const L face : faces) {
+                // Divisions by zero only happen in lanes that don't move along the axis, which test t = 0 instead
+                const L t = L::select(moving, lanes_clamp01((face - p[i]) / d[i]), zero);
+                const L s = slope(t);
+                low = L::max(low, L::select(L::less_equal(s, zero), t, zero));
+                high = L::min(high, L::select(L::less_equal(zero, s), t, one));
+            }
+        }
+
+        const L slope_low = slope(low), slope_high = slope(high);
+        const L solved = L::select(L::less(zero, slope_high), low - slope_low * (high - low) / (slope_high - slope_low), high);
+        const L t = L::select(L::less(slope_low, zero), solved, low);
+        L res = zero;
+        for (luint i = 0; i < 3; i++) {
+            const L x = L::mad(d[i], t, p[i]);
+            const L outside = x - L::min(L::max(x, zero - h[i]), h[i]);
+            res = L::mad(outside, outside, res);
+        }
+        return res;
+    }
+
+    /**
+     * @brief Separating axis test of boxes in lanes, stopping as soon as every lane has found a separating axis
+     */
+    template<typename L>
+    inline typename L::mask lanes_overlap_obbs(const L* a, const L* b) {
+        const L* ha = a + 3;
+        const L* hb = b + 3;
+        const L* ra = a + 6;
+        const L* rb = b + 6;
+        const L eps = L::set(static_cast<float>(obb_sat_epsilon));
+        const L d[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        L t[3], r[3][3], abs_r[3][3];
+        for (luint i = 0; i < 3; i++) {
+            t[i] = L::mad(d[0], ra[i], L::mad(d[1], ra[3 + i], d[2] * ra[6 + i]));
+            for (luint j = 0; j < 3; j++) {
+                r[i][j] = L::mad(ra[i], rb[j], L::mad(ra[3 + i], rb[3 + j], ra[6 + i] * rb[6 + j]));
+                abs_r[i][j] = L::abs(r[i][j]) + eps;
+            }
+        }
+
+        typename L::mask overlapping = L::less_equal(L::abs(t[0]), ha[0] + L::mad(hb[0], abs_r[0][0], L::mad(hb[1], abs_r[0][1], hb[2] * abs_r[0][2])));
+        for (luint i = 1; i < 3; i++)
+            overlapping = L::mask_and(overlapping, L::less_equal(L::abs(t[i]), ha[i] + L::mad(hb[0], abs_r[i][0], L::mad(hb[1], abs_r[i][1], hb[2] * abs_r[i][2]))));
+        if (L::mask_bits(overlapping) == 0)
+            return overlapping;
+
+        for (luint j = 0; j < 3; j++) {
+            const L dist = L::abs(L::mad(t[0], r[0][j], L::mad(t[1], r[1][j], t[2] * r[2][j])));
+            overlapping = L::mask_and(overlapping, L::less_equal(dist, L::mad(ha[0], abs_r[0][j], L::mad(ha[1], abs_r[1][j], ha[2] * abs_r[2][j])) + hb[j]));
+        }
+        if (L::mask_bits(overlapping) == 0)
+            return overlapping;
+
+        for (luint i = 0; i < 3; i++) {
+            const luint i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+            for (luint j = 0; j < 3; j++) {
+                const luint j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+                const L dist = L::abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]);
+                const L radius = ha[i1] * abs_r[i2][j] + ha[i2] * abs_r[i1][j] + hb[j1] * abs_r[i][j2] + hb[j2] * abs_r[i][j1];
+                overlapping = L::mask_and(overlapping, L::less_equal(dist, radius));
+            }
+            if (L::mask_bits(overlapping) == 0)
+                return overlapping;
+        }
+        return overlapping;
+    }
+
+    /**
+     * @brief Test primitives of types A and B in lanes, given as arrays of their components
+     */
+    template<typename A, typename B, typename L>
+    inline typename L::mask lanes_overlap(const L* a, const L* b) {
+        if constexpr (std::is_same_v<A, sphere<float>> && std::is_same_v<B, sphere<float>>) {
+            const L r = a[3] + b[3];
+            const L d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+            return L::less_equal(lanes_dot3(d, d), r * r);
+        }
+        else if constexpr (std::is_same_v<A, sphere<float>> && std::is_same_v<B, capsule<float>>) {
+            const L r = a[3] + b[6];
+            return L::less_equal(lanes_segment_distance_squared(a, b, b + 3), r * r);
+        }
+        else if constexpr (std::is_same_v<A, capsule<float>> && std::is_same_v<B, capsule<float>>) {
+            const L r = a[6] + b[6];
+            return L::less_equal(lanes_segments_distance_squared(a, a + 3, b, b + 3), r * r);
+        }
+        else if constexpr (std::is_same_v<A, sphere<float>> && std::is_same_v<B, obb<float>>) {
+            const L d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+            const L* rb = b + 6;
+            L dist_sq = L::set(0.0f);
+            for (luint i = 0; i < 3; i++) {
+                const L outside = L::max(L::abs(L::mad(d[0], rb[i], L::mad(d[1], rb[3 + i], d[2] * rb[6 + i]))) - b[3 + i], L::set(0.0f));
+                dist_sq = L::mad(outside, outside, dist_sq);
+            }
+            return L::less_equal(dist_sq, a[3] * a[3]);
+        }
+        else if constexpr (std::is_same_v<A, capsule<float>> && std::is_same_v<B, obb<float>>) {
+            const L p[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+            const L d[3] = {a[3] - a[0], a[4] - a[1], a[5] - a[2]};
+            const L* rb = b + 6;
+            L local_p[3], local_d[3];
+            for (luint i = 0; i < 3; i++) {
+                local_p[i] = L::mad(p[0], rb[i], L::mad(p[1], rb[3 + i], p[2] * rb[6 + i]));
+                local_d[i] = L::mad(d[0], rb[i], L::mad(d[1], rb[3 + i], d[2] * rb[6 + i]));
+            }
+            return L::less_equal(lanes_segment_box_distance_squared(local_p, local_d, b + 3), a[6] * a[6]);
+        }
+        else if constexpr (std::is_same_v<A, obb<float>> && std::is_same_v<B, obb<float>>)
+            return lanes_overlap_obbs(a, b);
+        else if constexpr ((std::is_same_v<A, capsule<float>> || std::is_same_v<A, obb<float>>) && std::is_same_v<B, sphere<float>>)
+            return lanes_overlap<B, A>(b, a);
+        else if constexpr (std::is_same_v<A, obb<float>> && std::is_same_v<B, capsule<float>>)
+            return lanes_overlap<B, A>(b, a);
+        else
+            static_assert(std::is_same_v<A, void>, "Batched overlap tests take spheres, capsules and boxes of floats");
+    }
+
+    /**
+     * @brief Write first + k for every lane k of m that is set, without branches, and return the new number of indices
+     */
+    template<typename L>
+    inline luint overlap_indices(luint* dst, luint n, const luint first, const typename L::mask m) {
+        const uint32 bits = L::mask_bits(m);
+        // Most groups of a broad phase overlap nothing
+        if (bits == 0)
+            return n;
+        for (luint k = 0; k < L::count; k++) {
+            dst[n] = first + k;
+            n += (bits >> k) & 1u;
+        }
+        return n;
+    }
+
+    template<typename L, typename A, typename B>
+    inline luint overlaps_group(luint* dst, const luint n, const A& a, const B* b, const luint first) {
+        constexpr luint ca = soa_view<A>::components, cb = soa_view<B>::components;
+        const float* pa = reinterpret_cast<const float*>(&a);
+        const float* pb = reinterpret_cast<const float*>(b + first);
+        L la[ca], lb[cb];
+        for (luint k = 0; k < ca; k++)
+            la[k] = L::set(pa[k]);
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+        // Primitives of 4 floats (spheres) are loaded whole and transposed, which is much cheaper than strided loads
+        if constexpr (cb == 4 && L::count == 4) {
+            __m128 r0 = _mm_loadu_ps(pb), r1 = _mm_loadu_ps(pb + 4), r2 = _mm_loadu_ps(pb + 8), r3 = _mm_loadu_ps(pb + 12);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            lb[0].v = r0;
+            lb[1].v = r1;
+            lb[2].v = r2;
+            lb[3].v = r3;
+        }
+#if defined(__AVX__)
+        else if constexpr (cb == 4 && L::count == 8) {
+            // The same transpose in both halves, with the rows of primitives 0 to 3 in the low ones and 4 to 7 in the high ones
+            __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pb)), _mm_loadu_ps(pb + 16), 1);
+            __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pb + 4)), _mm_loadu_ps(pb + 20), 1);
+            __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pb + 8)), _mm_loadu_ps(pb + 24), 1);
+            __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pb + 12)), _mm_loadu_ps(pb + 28), 1);
+            const __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpacklo_ps(r2, r3);
+            const __m256 t2 = _mm256_unpackhi_ps(r0, r1), t3 = _mm256_unpackhi_ps(r2, r3);
+            lb[0].v = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+            lb[1].v = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+            lb[2].v = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            lb[3].v = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        }
+#endif
+        else
+#endif
+            for (luint k = 0; k < cb; k++)
+                lb[k] = L::load_strided(pb + k, cb);
+        return overlap_indices<L>(dst, n, first, lanes_overlap<A, B>(la, lb));
+    }
+
+    template<typename L, typename A, typename B>
+    inline luint overlaps_group(luint* dst, const luint n, const soa_view<A>& a, const soa_view<B>& b, const luint first) {
+        L la[soa_view<A>::components], lb[soa_view<B>::components];
+        for (luint k = 0; k < soa_view<A>::components; k++)
+            la[k] = L::load(a.data[k] + first);
+        for (luint k = 0; k < soa_view<B>::components; k++)
+            lb[k] = L::load(b.data[k] + first);
+        return overlap_indices<L>(dst, n, first, lanes_overlap<A, B>(la, lb));
+    }
+
+    /**
+     * @brief Test a primitive against an array of others (spheres, capsules and boxes of floats), 4 or 8 at a time when
+     * MGMATH_SIMD is defined
+     *
+     * @param dst The array to write the indices of the overlapping primitives of b to, with room for count indices
+     * @param a The primitive to test
+     * @param b The primitives to test it against
+     * @param count The number of primitives in b
+     * @return The number of indices written
+     */
+    template<typename A, typename B>
+    inline luint overlaps(luint* dst, const A& a, const B* b, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_overlap, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("overlaps", dst, count, reinterpret_cast<const float*>(&a), soa_view<A>::components, reinterpret_cast<const float*>(b), count * soa_view<B>::components);
+        luint n = 0, i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            n = overlaps_group<float_lanes<8>>(dst, n, a, b, i);
+#endif
+        for (; i + 4 <= count; i += 4)
+            n = overlaps_group<float_lanes<4>>(dst, n, a, b, i);
+#endif
+        for (; i < count; i++)
+            n = overlaps_group<float_lanes<1>>(dst, n, a, b, i);
+        return n;
+    }
+
+    /**
+     * @brief Test pairs of primitives stored as structures of arrays (a[i] against b[i]), 4 or 8 pairs at a time when
+     * MGMATH_SIMD is defined
+     *
+     * @param dst The array to write the indices of the overlapping pairs to, with room for count indices
+     * @param a The first primitive of every pair
+     * @param b The second primitive of every pair
+     * @param count The number of pairs
+     * @return The number of indices written
+     */
+    template<typename A, typename B>
+    inline luint overlaps(luint* dst, const soa_view<A>& a, const soa_view<B>& b, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_overlap, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("overlaps", dst, count, &a, count, &b, count);
+        luint n = 0, i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            n = overlaps_group<float_lanes<8>>(dst, n, a, b, i);
+#endif
+        for (; i + 4 <= count; i += 4)
+            n = overlaps_group<float_lanes<4>>(dst, n, a, b, i);
+#endif
+        for (; i < count; i++)
+            n = overlaps_group<float_lanes<1>>(dst, n, a, b, i);
+        return n;
+    }
+
+
+    //===========
+    // ANIMATION
+    //===========
+
+    /**
+     * @brief How a track interpolates between its keyframes
+     */
+    enum class interpolation {
+        // Hold the value of the previous keyframe
+        step,
+        // lerp for vectors, slerp for quaternions
+        linear,
+        // Catmull-Rom for vectors, squad for quaternions, both going through the keyframes with tangents from the neighbouring ones
+        cubic
+    };
+
+    template<typename V>
+    struct track_traits;
+    template<luint S, typename T>
+    struct track_traits<vec<S, T>> {
+        using scalar = T;
+        static constexpr luint components = S;
+    };
+    template<typename T>
+    struct track_traits<quat<T>> {
+        using scalar = T;
+        static constexpr luint components = 4;
+    };
+
+    /**
+     * @brief Interpolate from `a` to `b` with the neighbouring keyframes `before` and `after` (Catmull-Rom with non uniform times)
+     *
+     * @param dt The time from a to b, with dt_before and dt_after the times from before to a and from b to after (0 at the ends of a track)
+     */
+    template<luint S, typename T>
+    inline vec<S, T> interpolate_cubic(const vec<S, T>& before, const vec<S, T>& a, const vec<S, T>& b, const vec<S, T>& after, const T dt_before, const T dt, const T dt_after, const T weight) {
+        // Tangents scaled to the segment, one sided at the ends
+        const vec<S, T> ta = (b - before) * (dt / (dt_before + dt));
+        const vec<S, T> tb = (after - a) * (dt / (dt + dt_after));
+        const T w2 = weight * weight, w3 = w2 * weight;
+        // Hermite basis
+        const vec<S, T> res = a * (T(2) * w3 - T(3) * w2 + T(1));
+        return vec<S, T>::mad(b, T(3) * w2 - T(2) * w3, vec<S, T>::mad(ta, w3 - T(2) * w2 + weight, vec<S, T>::mad(tb, w3 - w2, res)));
+    }
+
+    /**
+     * @brief Interpolate from `a` to `b` with the neighbouring keyframes `before` and `after` (squad, made of 3 slerps)
+     *
+     * The times only mark the ends of the track, where the keyframe is its own control point
+     */
+    template<typename T>
+    inline quat<T> interpolate_cubic(const quat<T>& before, const quat<T>& a, const quat<T>& b, const quat<T>& after, const T dt_before, const T, const T dt_after, const T weight) {
+        // The neighbours on the same side as a, so the curve takes the shortest path
+        const auto closest = [](const quat<T>& q, const quat<T>& to) {
+            return q.dot(to) < T(0) ? quat<T>(-static_cast<const vec<4, T>&>(q)) : q;
+        };
+        const quat<T> q0 = closest(before, a), q2 = closest(b, a), q3 = closest(after, q2);
+        // Control points s = q * exp(-(log(q^-1 * next) + log(q^-1 * previous)) / 4)
+        const auto control = [](const quat<T>& previous, const quat<T>& q, const quat<T>& next) {
+            const quat<T> inv = q.conjugate();
+            const vec<4, T> sum = static_cast<const vec<4, T>&>((inv * next).log()) + static_cast<const vec<4, T>&>((inv * previous).log());
+            return q * quat<T>(sum * T(-0.25)).exp();
+        };
+        const quat<T> sa = dt_before > T(0) ? control(q0, a, q2) : a, sb = dt_after > T(0) ? control(a, q2, q3) : q2;
+        // slerp without taking the shortest path, which would flip the outer slerp in the middle of the curve
+        const auto arc = [](const vec<4, T>& from, const vec<4, T>& to, const T w) {
+            const T d = from.dot(to);
+            if (d > T(0.9995))
+                return quat<T>(from.lerp(to, w).normalized());
+            const T theta = std::acos(d) * w;
+            return quat<T>(vec<4, T>::mad(from, std::cos(theta), (to - from * d).normalized() * std::sin(theta)));
+        };
+        return arc(arc(a, q2, weight), arc(sa, sb, weight), T(2) * weight * (T(1) - weight));
+    }
+
+    /**
+     * @brief Keyframes of a `vec` or `quat` value, sampled at any time between them
+     *
+     * The track only refers to the keyframes, which stay owned by the caller, so many instances can share them
+     */
+    template<typename V>
+    struct track {
+        using T = typename track_traits<V>::scalar;
+
+        // Sorted from earliest to latest
+        const T* times = nullptr;
+        const V* values = nullptr;
+        luint count = 0;
+        interpolation mode = interpolation::linear;
+
+        /**
+         * @brief Find the keyframe a time falls after, starting from a cursor and moving it there
+         *
+         * The previous and next keyframes of the cursor are checked first, so playing a track forwards (or backwards) is O(1), and seeking
+         * anywhere else falls back to a binary search
+         *
+         * @param time The time to look for
+         * @param cursor The keyframe found by the previous call, kept by every instance playing the track
+         * @return The keyframe before the time, or the first one before the start of the track
+         */
+        luint find(const T time, luint& cursor) const {
+            if (count < 2)
+                return cursor = 0;
+
+            luint k = cursor < count - 1 ? cursor : count - 2;
+            if (time >= times[k]) {
+                if (k + 1 == count - 1 || time < times[k + 1])
+                    return cursor = k;
+                if (k + 2 == count - 1 || time < times[k + 2])
+                    return cursor = k + 1;
+            } else if (k == 0 || time >= times[k - 1]) {
+                return cursor = k == 0 ? 0 : k - 1;
+            }
+
+            // Last keyframe whose time is not after the time
+            luint low = 0, high = count - 1;
+            while (high - low > 1) {
+                const luint middle = low + (high - low) / 2;
+                if (times[middle] <= time)
+                    low = middle;
+                else
+                    high = middle;
+            }
+            return cursor = low;
+        }
+
+        /**
+         * @brief Sample the track, clamped to its first and last keyframes
+         *
+         * @param time The time to sample at
+         * @param cursor The keyframe found by the previous call, kept by every instance playing the track
+         */
+        V sample(const T time, luint& cursor) const {
+            if (count == 0)
+                return V{};
+            const luint k = find(time, cursor);
+            if (count == 1 || time <= times[0])
+                return values[0];
+            if (time >= times[count - 1])
+                return values[count - 1];
+
+            if (mode == interpolation::step)
+                return values[k];
+            const T dt = times[k + 1] - times[k];
+            const T weight = (time - times[k]) / dt;
+            if (mode == interpolation::linear) {
+                if constexpr (std::is_same_v<V, quat<T>>)
+                    return values[k].slerp(values[k + 1], weight);
+                else
+                    return values[k].lerp(values[k + 1], weight);
+            }
+
+            // Repeating the end keyframes gives one sided tangents
+            const luint before = k == 0 ? 0 : k - 1, after = k + 2 < count ? k + 2 : k + 1;
+            return interpolate_cubic(values[before], values[k], values[k + 1], values[after], times[k] - times[before], dt, times[after] - times[k + 1], weight);
+        }
+
+        /**
+         * @brief Sample the track with a binary search, for random access
+         */
+        V sample(const T time) const {
+            luint cursor = 0;
+            return sample(time, cursor);
+        }
+    };
+
+    /**
+     * @brief Sample many tracks at the same time, writing every component to its own array (SoA), ready for blending or skinning
+     *
+     * @param dst The arrays to write every component to (3 for `vec3` tracks, 4 for `quat` tracks: x, y, z, w), of count values each
+     * @param tracks The tracks to sample
+     * @param cursors The cursors of the tracks, updated
+     * @param time The time to sample at
+     * @param count The number of tracks
+     */
+    template<typename V>
+    inline void sample(typename track_traits<V>::scalar* const* dst, const track<V>* tracks, luint* cursors, const typename track_traits<V>::scalar time, const luint count) {
+        using T = typename track_traits<V>::scalar;
+        MGMATH_PROFILE_BATCH(batch_track_sample, T, count, false);
+        constexpr luint components = track_traits<V>::components;
+        for (luint i = 0; i < count; i++) {
+            const track<V>& t = tracks[i];
+            T res[components];
+            MGMATH_CHECK_FLOATS_SCOPE("track_sample", res, components, t.times, t.count, reinterpret_cast<const T*>(t.values), t.count * components);
+            if constexpr (!std::is_same_v<V, quat<T>>) {
+                // Step and linear vector tracks are interpolated one component at a time, same as vec::lerp
+                if (t.mode != interpolation::cubic && t.count >= 2) {
+                    const luint k = t.find(time, cursors[i]);
+                    const T *a = t.values[k].data(), *b = t.values[k + 1].data();
+                    T weight = T(0);
+                    if (time >= t.times[t.count - 1])
+                        a = t.values[t.count - 1].data();
+                    else if (t.mode == interpolation::linear && time > t.times[k])
+                        weight = (time - t.times[k]) / (t.times[k + 1] - t.times[k]);
+                    for (luint c = 0; c < components; c++)
+                        dst[c][i] = res[c] = mad(b[c] - a[c], weight, a[c]);
+                    continue;
+                }
+            }
+
+            const V value = t.sample(time, cursors[i]);
+            for (luint c = 0; c < components; c++)
+                dst[c][i] = res[c] = value.data()[c];
+        }
+    }
+
+
+    //=========
+    // SPLINES
+    //=========
+
+    /**
+     * @brief The kinds of cubic splines, and how their control points are laid out
+     */
+    enum class spline_kind {
+        // Segments of 4 points sharing their ends (p0, c0, c1, p1, c2, c3, p2, ...), going through every third point
+        bezier,
+        // Points each followed by their tangent (p0, m0, p1, m1, ...), going through every point
+        hermite,
+        // Going through every point but the first and the last, which only shape the ends
+        catmull_rom,
+        // Uniform B-spline, smoother than the others (C2) but not going through the points
+        b_spline
+    };
+
+    /**
+     * @brief The basis of every kind of spline: the weight of the point i of a segment is `c[i][0] + c[i][1] * t + c[i][2] * t^2 + c[i][3] * t^3`
+     */
+    template<typename T>
+    struct spline_basis {
+        static constexpr T bezier[4][4] = {{1, -3, 3, -1}, {0, 3, -6, 3}, {0, 0, 3, -3}, {0, 0, 0, 1}};
+        static constexpr T hermite[4][4] = {{1, 0, -3, 2}, {0, 1, -2, 1}, {0, 0, 3, -2}, {0, 0, -1, 1}};
+        static constexpr T catmull_rom[4][4] = {{0, T(-0.5), 1, T(-0.5)}, {1, 0, T(-2.5), T(1.5)}, {0, T(0.5), 2, T(-1.5)}, {0, 0, T(-0.5), T(0.5)}};
+        static constexpr T b_spline[4][4] = {{T(1) / T(6), T(-0.5), T(0.5), T(-1) / T(6)}, {T(2) / T(3), 0, -1, T(0.5)}, {T(1) / T(6), T(0.5), T(0.5), T(-0.5)}, {0, 0, 0, T(1) / T(6)}};
+
+        static const T (&of(const spline_kind kind))[4][4] {
+            switch (kind) {
+                case spline_kind::bezier: return bezier;
+                case spline_kind::hermite: return hermite;
+                case spline_kind::catmull_rom: return catmull_rom;
+                default: return b_spline;
+            }
+        }
+    };
+
+    /**
+     * @brief Compute the segments and weights (or the weights of the derivative) of a spline for L::count parameters at once
+     *
+     * @param t The parameters, from 0 to 1 over the whole spline
+     * @param segments The number of segments of the spline
+     * @param c The basis of the spline
+     * @param derivative Whether to compute the weights of the derivative
+     * @param segment Where to write the segment of every parameter (as a float)
+     * @param w Where to write the 4 weights of every parameter, one array per control point of the segment
+     */
+    template<typename L>
+    inline void lanes_spline_weights(const float* t, const float segments, const float (&c)[4][4], const bool derivative, float* segment, float* const* w) {
+        const L zero = L::set(0.0f), one = L::set(1.0f), n = L::set(segments);
+        const L u = L::min(L::max(L::load(t), zero), one) * n;
+        const L first = L::min(L::floor(u), n - one);
+        const L x = u - first;
+        first.store(segment);
+        for (luint i = 0; i < 4; i++) {
+            if (derivative)
+                (L::mad(L::mad(L::set(3.0f * c[i][3]), x, L::set(2.0f * c[i][2])), x, L::set(c[i][1])) * n).store(w[i]);
+            else
+                L::mad(L::mad(L::mad(L::set(c[i][3]), x, L::set(c[i][2])), x, L::set(c[i][1])), x, L::set(c[i][0])).store(w[i]);
+        }
+    }
+
+    /**
+     * @brief A cubic spline through (or shaped by) an array of `vec` control points, evaluated with a parameter from 0 to 1 over all its segments
+     *
+     * The spline only refers to the control points, which stay owned by the caller. It needs at least 4 of them, and evaluates to zero otherwise
+     */
+    template<luint S, typename T>
+    struct spline {
+        static_assert(std::is_floating_point_v<T>, "Splines are only available for float and double vectors");
+
+        spline_kind kind = spline_kind::catmull_rom;
+        const vec<S, T>* points = nullptr;
+        luint count = 0;
+
+        /**
+         * @brief Get the number of control points between the starts of 2 segments
+         */
+        luint stride() const {
+            return kind == spline_kind::bezier ? 3 : kind == spline_kind::hermite ? 2 : 1;
+        }
+
+        /**
+         * @brief Get the number of cubic segments
+         */
+        luint segments() const {
+            return count < 4 ? 0 : (count - 4) / stride() + 1;
+        }
+
+        /**
+         * @brief Calculate the point at a parameter
+         *
+         * @param t The parameter, from 0 (start of the first segment) to 1 (end of the last one), clamped
+         */
+        vec<S, T> evaluate(const T t) const {
+            vec<S, T> res;
+            evaluate_one(t, false, res);
+            return res;
+        }
+
+        /**
+         * @brief Calculate the derivative (tangent) of the spline at a parameter, relative to the parameter over the whole spline
+         */
+        vec<S, T> derivative(const T t) const {
+            vec<S, T> res;
+            evaluate_one(t, true, res);
+            return res;
+        }
+
+        /**
+         * @brief Calculate the points at many parameters, the weights for 4 or 8 of them at a time for float splines when MGMATH_SIMD is defined
+         *
+         * @param dst The array to write the points to
+         * @param t The parameters
+         * @param n The number of parameters
+         */
+        void evaluate(vec<S, T>* dst, const T* t, const luint n) const {
+            MGMATH_PROFILE_BATCH(batch_spline, T, n, profile_simd_build && std::is_same_v<T, float>);
+            MGMATH_CHECK_FLOATS_SCOPE("spline_evaluate", reinterpret_cast<const T*>(dst), n * S, t, n);
+            evaluate_many(dst, t, n, false);
+        }
+
+        /**
+         * @brief Calculate the derivatives at many parameters
+         *
+         * @param dst The array to write the derivatives to
+         * @param t The parameters
+         * @param n The number of parameters
+         */
+        void derivative(vec<S, T>* dst, const T* t, const luint n) const {
+            MGMATH_PROFILE_BATCH(batch_spline, T, n, profile_simd_build && std::is_same_v<T, float>);
+            MGMATH_CHECK_FLOATS_SCOPE("spline_derivative", reinterpret_cast<const T*>(dst), n * S, t, n);
+            evaluate_many(dst, t, n, true);
+        }
+
+        /**
+         * @brief Split the spline into straight lines, shorter where it bends, so no point of the spline is further than a tolerance from them
+         *
+         * Every segment is halved until the points at a quarter, half and three quarters of a piece are close enough to its chord
+         *
+         * @param dst The array to write the points to, from the start to the end of the spline
+         * @param capacity The number of points dst can hold
+         * @param tolerance The maximum distance between the spline and the lines
+         * @return The number of points of the tessellation, which are only all written when it's not more than capacity
+         */
+        luint tessellate(vec<S, T>* dst, const luint capacity, const T tolerance) const {
+            const luint n = segments();
+            if (n == 0)
+                return 0;
+
+            luint written = 0;
+            const auto emit = [&](const vec<S, T>& p) {
+                if (written < capacity)
+                    dst[written] = p;
+                written++;
+            };
+
+            struct piece {
+                T a, b;
+                vec<S, T> pa, pb;
+                luint depth;
+            };
+            constexpr luint max_depth = 16;
+            const T tolerance_squared = tolerance * tolerance;
+            // Squared distance from a point to the line through 2 others
+            const auto distance_squared = [](const vec<S, T>& p, const vec<S, T>& a, const vec<S, T>& b) {
+                const vec<S, T> d = p - a, e = b - a;
+                const T e2 = e.length_squared(), de = d.dot(e);
+                return e2 > T(0) ? d.length_squared() - de * de / e2 : d.length_squared();
+            };
+
+            emit(evaluate(T(0)));
+            for (luint k = 0; k < n; k++) {
+                // Depth first, left half on top, so the points come out in order
+                piece stack[max_depth + 1];
+                luint top = 0;
+                const T a = T(k) / T(n), b = T(k + 1) / T(n);
+                stack[top++] = piece{a, b, evaluate(a), evaluate(b), 0};
+                while (top > 0) {
+                    const piece p = stack[--top];
+                    const T h = p.b - p.a;
+                    const vec<S, T> mid = evaluate(p.a + h * T(0.5));
+                    const bool flat = p.depth == max_depth || (distance_squared(mid, p.pa, p.pb) <= tolerance_squared &&
+                                                               distance_squared(evaluate(p.a + h * T(0.25)), p.pa, p.pb) <= tolerance_squared &&
+                                                               distance_squared(evaluate(p.a + h * T(0.75)), p.pa, p.pb) <= tolerance_squared);
+                    if (flat) {
+                        emit(p.pb);
+                        continue;
+                    }
+                    const T m = p.a + h * T(0.5);
+                    stack[top++] = piece{m, p.b, mid, p.pb, p.depth + 1};
+                    stack[top++] = piece{p.a, m, p.pa, mid, p.depth + 1};
+                }
+            }
+            return written;
+        }
+
+      private:
+        void weights(const T t, const bool derivative, T w[4], luint& first) const {
+            const luint n = segments();
+            const T u = clamp(T(0), T(1), t) * T(n);
+            const T segment = std::floor(u) < T(n - 1) ? std::floor(u) : T(n - 1);
+            const T x = u - segment;
+            first = static_cast<luint>(segment) * stride();
+            const auto& c = spline_basis<T>::of(kind);
+            for (luint i = 0; i < 4; i++) {
+                if (derivative)
+                    w[i] = mad(mad(T(3) * c[i][3], x, T(2) * c[i][2]), x, c[i][1]) * T(n);
+                else
+                    w[i] = mad(mad(mad(c[i][3], x, c[i][2]), x, c[i][1]), x, c[i][0]);
+            }
+        }
+
+        void combine(const luint first, const T w0, const T w1, const T w2, const T w3, vec<S, T>& dst) const {
+            const T *p0 = points[first].data(), *p1 = points[first + 1].data(), *p2 = points[first + 2].data(), *p3 = points[first + 3].data();
+            T* d = dst.data();
+            for (luint c = 0; c < S; c++)
+                d[c] = mad(w3, p3[c], mad(w2, p2[c], mad(w1, p1[c], w0 * p0[c])));
+        }
+
+        void evaluate_one(const T t, const bool derivative, vec<S, T>& dst) const {
+            if (segments() == 0) {
+                dst = vec<S, T>{};
+                return;
+            }
+            T w[4];
+            luint first;
+            weights(t, derivative, w, first);
+            combine(first, w[0], w[1], w[2], w[3], dst);
+        }
+
+        void evaluate_many(vec<S, T>* dst, const T* t, const luint n, const bool derivative) const {
+            if (segments() == 0) {
+                for (luint i = 0; i < n; i++)
+                    dst[i] = vec<S, T>{};
+                return;
+            }
+
+            // The weights of a block of parameters first (in lanes for float), then the points
+            constexpr luint block = 64;
+            alignas(32) T segment[block], w0[block], w1[block], w2[block], w3[block];
+            T* const w[4] = {w0, w1, w2, w3};
+            for (luint i = 0; i < n; i += block) {
+                const luint m = n - i < block ? n - i : block;
+                luint j = 0;
+                if constexpr (std::is_same_v<T, float>) {
+                    const auto& c = spline_basis<float>::of(kind);
+                    const float segments_f = static_cast<float>(segments());
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+                    for (; j + 8 <= m; j += 8) {
+                        float* const wj[4] = {w0 + j, w1 + j, w2 + j, w3 + j};
+                        lanes_spline_weights<float_lanes<8>>(t + i + j, segments_f, c, derivative, segment + j, wj);
+                    }
+#endif
+                    for (; j + 4 <= m; j += 4) {
+                        float* const wj[4] = {w0 + j, w1 + j, w2 + j, w3 + j};
+                        lanes_spline_weights<float_lanes<4>>(t + i + j, segments_f, c, derivative, segment + j, wj);
+                    }
+#endif
+                    for (; j < m; j++) {
+                        float* const wj[4] = {w0 + j, w1 + j, w2 + j, w3 + j};
+                        lanes_spline_weights<float_lanes<1>>(t + i + j, segments_f, c, derivative, segment + j, wj);
+                    }
+                } else {
+                    for (; j < m; j++) {
+                        T wj[4];
+                        luint first;
+                        weights(t[i + j], derivative, wj, first);
+                        segment[j] = T(first / stride());
+                        for (luint k = 0; k < 4; k++)
+                            w[k][j] = wj[k];
+                    }
+                }
+
+                const luint step = stride();
+                for (j = 0; j < m; j++)
+                    combine(static_cast<luint>(segment[j]) * step, w0[j], w1[j], w2[j], w3[j], dst[i + j]);
+            }
+        }
+    };
+
+    /**
+     * @brief Lengths along a spline at N + 1 evenly spaced parameters, to move along it at a constant speed
+     *
+     * @tparam N The number of intervals, more is more accurate for splines with large changes of speed
+     */
+    template<luint S, typename T, luint N = 64>
+    struct arc_length_table {
+        // The length from the start of the spline to every parameter i / N
+        T lengths[N + 1] = {};
+
+        arc_length_table() = default;
+
+        /**
+         * @brief Measure a spline, with a 3 point Gauss-Legendre quadrature of the length of its derivative on every interval
+         */
+        explicit arc_length_table(const spline<S, T>& curve) {
+            const T offset = std::sqrt(T(0.6)) * T(0.5) / T(N);
+            T t[3 * N];
+            vec<S, T> d[3 * N];
+            for (luint i = 0; i < N; i++) {
+                const T mid = (T(i) + T(0.5)) / T(N);
+                t[i * 3] = mid - offset;
+                t[i * 3 + 1] = mid;
+                t[i * 3 + 2] = mid + offset;
+            }
+            curve.derivative(d, t, 3 * N);
+
+            lengths[0] = T(0);
+            for (luint i = 0; i < N; i++) {
+                const T interval = (T(5) * d[i * 3].length() + T(8) * d[i * 3 + 1].length() + T(5) * d[i * 3 + 2].length()) / (T(18) * T(N));
+                lengths[i + 1] = lengths[i] + interval;
+            }
+        }
+
+        /**
+         * @brief Get the length of the whole spline
+         */
+        T length() const {
+            return lengths[N];
+        }
+
+        /**
+         * @brief Get the parameter at a distance along the spline (clamped to its length)
+         */
+        T parameter(const T distance) const {
+            if (!(distance > T(0)))
+                return T(0);
+            if (distance >= lengths[N])
+                return T(1);
+
+            // Last length not after the distance
+            luint low = 0, high = N;
+            while (high - low > 1) {
+                const luint middle = low + (high - low) / 2;
+                if (lengths[middle] <= distance)
+                    low = middle;
+                else
+                    high = middle;
+            }
+            const T interval = lengths[low + 1] - lengths[low];
+            const T x = interval > T(0) ? (distance - lengths[low]) / interval : T(0);
+            return (T(low) + x) / T(N);
+        }
+
+        /**
+         * @brief Get the parameters at many distances along the spline
+         *
+         * @param dst The array to write the parameters to
+         * @param distances The distances
+         * @param count The number of distances
+         */
+        void parameters(T* dst, const T* distances, const luint count) const {
+            for (luint i = 0; i < count; i++)
+                dst[i] = parameter(distances[i]);
+        }
+    };
+
+
+    //========
+    // RANDOM
+    //========
+
+    /**
+     * @brief Generate 4 random 32 bit values with the Philox 4x32-10 counter based generator (Salmon et al.)
+     *
+     * The values only depend on the seed and the counter, so the n-th values of a sequence can be generated without the ones before it, on any thread
+     *
+     * @param dst Where to write the 4 values
+     * @param seed The key of the generator
+     * @param counter The index of the values in the sequence of the seed
+     */
+    inline void philox4x32(uint32 (&dst)[4], const uint64 seed, const uint64 counter) {
+        uint32 c[4] = {static_cast<uint32>(counter), static_cast<uint32>(counter >> 32), 0, 0};
+        uint32 k0 = static_cast<uint32>(seed), k1 = static_cast<uint32>(seed >> 32);
+        for (luint round = 0; round < 10; round++) {
+            const uint64 p0 = uint64(0xD2511F53) * c[0], p1 = uint64(0xCD9E8D57) * c[2];
+            const uint32 c1 = c[1], c3 = c[3];
+            c[0] = static_cast<uint32>(p1 >> 32) ^ c1 ^ k0;
+            c[1] = static_cast<uint32>(p1);
+            c[2] = static_cast<uint32>(p0 >> 32) ^ c3 ^ k1;
+            c[3] = static_cast<uint32>(p0);
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        for (luint i = 0; i < 4; i++)
+            dst[i] = c[i];
+    }
+
+    /**
+     * @brief Generate the 4 Philox values of consecutive counters, as floats from 0 to 1 (24 bits), in every lane
+     */
+    inline void lanes_random_uniforms(const uint64 seed, const uint64 counter, float_lanes<1> (&u)[4]) {
+        uint32 bits[4];
+        philox4x32(bits, seed, counter);
+        for (luint i = 0; i < 4; i++)
+            u[i] = {static_cast<float>(bits[i] >> 8) * (1.0f / 16777216.0f)};
+    }
+
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+    /**
+     * @brief The 32 bit halves of the products of every lane of a register by a constant
+     */
+    inline void simd_mulhilo_epu32(const __m128i a, const uint32 m, __m128i& lo, __m128i& hi) {
+        // 64 bit products of the even lanes, then of the odd ones
+        const __m128i mm = _mm_set1_epi32(static_cast<int32>(m));
+        const __m128i even = _mm_mul_epu32(a, mm), odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), mm);
+        const __m128i low_halves = _mm_set_epi32(0, -1, 0, -1);
+        lo = _mm_or_si128(_mm_and_si128(even, low_halves), _mm_slli_epi64(odd, 32));
+        hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(low_halves, odd));
+    }
+
+    inline void simd_philox4x32(__m128i (&c)[4], const uint64 seed) {
+        uint32 k0 = static_cast<uint32>(seed), k1 = static_cast<uint32>(seed >> 32);
+        for (luint round = 0; round < 10; round++) {
+            __m128i lo0, hi0, lo1, hi1;
+            simd_mulhilo_epu32(c[0], 0xD2511F53, lo0, hi0);
+            simd_mulhilo_epu32(c[2], 0xCD9E8D57, lo1, hi1);
+            c[0] = _mm_xor_si128(_mm_xor_si128(hi1, c[1]), _mm_set1_epi32(static_cast<int32>(k0)));
+            c[1] = lo1;
+            c[2] = _mm_xor_si128(_mm_xor_si128(hi0, c[3]), _mm_set1_epi32(static_cast<int32>(k1)));
+            c[3] = lo0;
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+    }
+
+    inline void simd_random_uniforms(const uint64 seed, const uint64 counter, __m128 (&u)[4]) {
+        // Built in registers, since a vector load right after scalar stores to the same place stalls
+        const __m128i lo = _mm_add_epi32(_mm_set1_epi32(static_cast<int32>(counter)), _mm_set_epi32(3, 2, 1, 0));
+        // Carry where the low half wrapped around (compared as signed after flipping the top bit)
+        const __m128i flip = _mm_set1_epi32(INT32_MIN);
+        const __m128i carry = _mm_cmplt_epi32(_mm_xor_si128(lo, flip), _mm_xor_si128(_mm_set1_epi32(static_cast<int32>(counter)), flip));
+        __m128i c[4] = {lo, _mm_sub_epi32(_mm_set1_epi32(static_cast<int32>(counter >> 32)), carry), _mm_setzero_si128(), _mm_setzero_si128()};
+        simd_philox4x32(c, seed);
+        for (luint i = 0; i < 4; i++)
+            u[i] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(c[i], 8)), _mm_set1_ps(1.0f / 16777216.0f));
+    }
+
+    inline void lanes_random_uniforms(const uint64 seed, const uint64 counter, float_lanes<4> (&u)[4]) {
+        __m128 v[4];
+        simd_random_uniforms(seed, counter, v);
+        for (luint i = 0; i < 4; i++)
+            u[i] = {v[i]};
+    }
+
+#if defined(__AVX__)
+#if defined(__AVX2__)
+    inline void simd_mulhilo_epu32(const __m256i a, const uint32 m, __m256i& lo, __m256i& hi) {
+        const __m256i mm = _mm256_set1_epi32(static_cast<int32>(m));
+        const __m256i even = _mm256_mul_epu32(a, mm), odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), mm);
+        const __m256i low_halves = _mm256_set1_epi64x(0xFFFFFFFF);
+        lo = _mm256_or_si256(_mm256_and_si256(even, low_halves), _mm256_slli_epi64(odd, 32));
+        hi = _mm256_or_si256(_mm256_srli_epi64(even, 32), _mm256_andnot_si256(low_halves, odd));
+    }
+
+    inline void simd_philox4x32(__m256i (&c)[4], const uint64 seed) {
+        uint32 k0 = static_cast<uint32>(seed), k1 = static_cast<uint32>(seed >> 32);
+        for (luint round = 0; round < 10; round++) {
+            __m256i lo0, hi0, lo1, hi1;
+            simd_mulhilo_epu32(c[0], 0xD2511F53, lo0, hi0);
+            simd_mulhilo_epu32(c[2], 0xCD9E8D57, lo1, hi1);
+            c[0] = _mm256_xor_si256(_mm256_xor_si256(hi1, c[1]), _mm256_set1_epi32(static_cast<int32>(k0)));
+            c[1] = lo1;
+            c[2] = _mm256_xor_si256(_mm256_xor_si256(hi0, c[3]), _mm256_set1_epi32(static_cast<int32>(k1)));
+            c[3] = lo0;
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+    }
+#endif
+
+    inline void lanes_random_uniforms(const uint64 seed, const uint64 counter, float_lanes<8> (&u)[4]) {
+#if defined(__AVX2__)
+        const __m256i lo = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32>(counter)), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        const __m256i flip = _mm256_set1_epi32(INT32_MIN);
+        const __m256i carry = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_set1_epi32(static_cast<int32>(counter)), flip), _mm256_xor_si256(lo, flip));
+        __m256i c[4] = {lo, _mm256_sub_epi32(_mm256_set1_epi32(static_cast<int32>(counter >> 32)), carry), _mm256_setzero_si256(), _mm256_setzero_si256()};
+        simd_philox4x32(c, seed);
+        for (luint i = 0; i < 4; i++)
+            u[i] = {_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c[i], 8)), _mm256_set1_ps(1.0f / 16777216.0f))};
+#else
+        // AVX without AVX2 has no 256 bit integer arithmetic, so both halves are generated separately
+        __m128 low[4], high[4];
+        simd_random_uniforms(seed, counter, low);
+        simd_random_uniforms(seed, counter + 4, high);
+        for (luint i = 0; i < 4; i++)
+            u[i] = {_mm256_insertf128_ps(_mm256_castps128_ps256(low[i]), high[i], 1)};
+#endif
+    }
+#endif
+#endif
+
+    /**
+     * @brief Calculate the sine and cosine of fractions of a full turn in lanes, with polynomials (Cephes) that give the same bits for any lane count
+     */
+    template<typename L>
+    inline void lanes_sincos_turns(const L turns, L& s, L& c) {
+        // Nearest quarter turn, and an angle from -pi / 4 to pi / 4 from it
+        const L quarter = L::floor(L::mad(turns, L::set(4.0f), L::set(0.5f)));
+        const L a = L::mad(turns, L::set(4.0f), -quarter) * L::set(mgmath_fpi * 0.5f);
+        const L a2 = a * a;
+        const L sa = L::mad(L::mad(L::mad(L::set(-1.9515295891e-4f), a2, L::set(8.3321608736e-3f)), a2, L::set(-1.6666654611e-1f)) * a2, a, a);
+        const L ca = L::mad(L::mad(L::mad(L::mad(L::set(2.443315711809948e-5f), a2, L::set(-1.388731625493765e-3f)), a2, L::set(4.166664568298827e-2f)), a2, L::set(-0.5f)), a2, L::set(1.0f));
+
+        const typename L::mask q0 = L::less(quarter, L::set(0.5f)), q1 = L::less(quarter, L::set(1.5f)), q2 = L::less(quarter, L::set(2.5f)), q3 = L::less(quarter, L::set(3.5f));
+        s = L::select(q0, sa, L::select(q1, ca, L::select(q2, -sa, L::select(q3, -ca, sa))));
+        c = L::select(q0, ca, L::select(q1, -sa, L::select(q2, -ca, L::select(q3, sa, ca))));
+    }
+
+    /**
+     * @brief Turn the uniforms of a counter into the float components of one item in every lane, and write them to consecutive items
+     */
+    template<typename L, typename D, typename G>
+    inline void random_lanes_group(D* dst, const uint64 seed, const uint64 counter, const G& generate) {
+        constexpr luint components = sizeof(D) / sizeof(float);
+        L u[4], v[components];
+        lanes_random_uniforms(seed, counter, u);
+        generate(u, v);
+
+        alignas(32) float sv[components][L::count];
+        for (luint i = 0; i < components; i++)
+            v[i].store(sv[i]);
+        for (luint k = 0; k < L::count; k++) {
+            float* d = dst[k].data();
+            for (luint i = 0; i < components; i++)
+                d[i] = sv[i][k];
+        }
+    }
+
+    /**
+     * @brief Fill an array with the items of the counters first to first + count, 4 or 8 at a time when MGMATH_SIMD is defined
+     */
+    template<typename D, typename G>
+    inline void random_fill(D* dst, const luint count, const uint64 seed, const uint64 first, const G& generate) {
+        MGMATH_PROFILE_BATCH(batch_random, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("random_fill", reinterpret_cast<const float*>(dst), count * (sizeof(D) / sizeof(float)));
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            random_lanes_group<float_lanes<8>>(dst + i, seed, first + i, generate);
+#endif
+        for (; i + 4 <= count; i += 4)
+            random_lanes_group<float_lanes<4>>(dst + i, seed, first + i, generate);
+#endif
+        for (luint k = 0, rest = count - i; k < rest; k++)
+            random_lanes_group<float_lanes<1>>(dst + i + k, seed, first + i + k, generate);
+    }
+
+    /**
+     * @brief Generate random points uniformly distributed in a box
+     *
+     * Item i only depends on the seed and first + i, so an array split between threads (each passing the index of its first item) gets the same values
+     *
+     * @param dst The array to write the points to
+     * @param count The number of points
+     * @param low The lowest corner of the box
+     * @param high The highest corner of the box
+     * @param seed The seed of the sequence
+     * @param first The index of the first point in the sequence
+     */
+    template<luint S>
+    inline void random_in_box(vec<S, float>* dst, const luint count, const vec<S, float>& low, const vec<S, float>& high, const uint64 seed, const uint64 first = 0) {
+        static_assert(S <= 4, "Random points in a box are only available for up to 4 dimensions");
+        float origin[S], size[S];
+        for (luint i = 0; i < S; i++) {
+            origin[i] = low.data()[i];
+            size[i] = high.data()[i] - low.data()[i];
+        }
+        random_fill(dst, count, seed, first, [&](const auto* u, auto* v) {
+            using L = std::decay_t<decltype(*u)>;
+            for (luint i = 0; i < S; i++)
+                v[i] = L::mad(u[i], L::set(size[i]), L::set(origin[i]));
+        });
+    }
+
+    /**
+     * @brief Generate random points uniformly distributed in the unit disk
+     *
+     * @param dst The array to write the points to
+     * @param count The number of points
+     * @param seed The seed of the sequence
+     * @param first The index of the first point in the sequence
+     */
+    inline void random_in_disk(vec<2, float>* dst, const luint count, const uint64 seed, const uint64 first = 0) {
+        random_fill(dst, count, seed, first, [](const auto* u, auto* v) {
+            using L = std::decay_t<decltype(*u)>;
+            L s, c;
+            lanes_sincos_turns(u[1], s, c);
+            const L r = L::sqrt(u[0]);
+            v[0] = r * c;
+            v[1] = r * s;
+        });
+    }
+
+    /**
+     * @brief Generate random unit vectors, uniformly distributed on the sphere
+     *
+     * @param dst The array to write the vectors to
+     * @param count The number of vectors
+     * @param seed The seed of the sequence
+     * @param first The index of the first vector in the sequence
+     */
+    inline void random_on_sphere(vec<3, float>* dst, const luint count, const uint64 seed, const uint64 first = 0) {
+        random_fill(dst, count, seed, first, [](const auto* u, auto* v) {
+            using L = std::decay_t<decltype(*u)>;
+            // Uniform height (Archimedes), with the radius at that height from 1 - z^2 = 4u(1 - u)
+            L s, c;
+            lanes_sincos_turns(u[1], s, c);
+            const L r = L::set(2.0f) * L::sqrt(u[0] * (L::set(1.0f) - u[0]));
+            v[0] = r * c;
+            v[1] = r * s;
+            v[2] = L::mad(u[0], L::set(-2.0f), L::set(1.0f));
+        });
+    }
+
+    /**
+     * @brief Generate random points uniformly distributed in the unit ball
+     *
+     * @param dst The array to write the points to
+     * @param count The number of points
+     * @param seed The seed of the sequence
+     * @param first The index of the first point in the sequence
+     */
+    inline void random_in_sphere(vec<3, float>* dst, const luint count, const uint64 seed, const uint64 first = 0) {
+        random_fill(dst, count, seed, first, [](const auto* u, auto* v) {
+            using L = std::decay_t<decltype(*u)>;
+            L s, c;
+            lanes_sincos_turns(u[1], s, c);
+            // A direction, scaled by the cube root of a uniform (moved half a step away from 0)
+            const L scale = L::cbrt(u[2] + L::set(0.5f / 16777216.0f));
+            const L r = L::set(2.0f) * L::sqrt(u[0] * (L::set(1.0f) - u[0])) * scale;
+            v[0] = r * c;
+            v[1] = r * s;
+            v[2] = L::mad(u[0], L::set(-2.0f), L::set(1.0f)) * scale;
+        });
+    }
+
+    /**
+     * @brief Generate random unit vectors on the hemisphere around a normal, with a density proportional to the cosine of their angle with it
+     *
+     * @param dst The array to write the vectors to
+     * @param count The number of vectors
+     * @param normal The unit normal of the hemisphere
+     * @param seed The seed of the sequence
+     * @param first The index of the first vector in the sequence
+     */
+    inline void random_cosine_hemisphere(vec<3, float>* dst, const luint count, const vec<3, float>& normal, const uint64 seed, const uint64 first = 0) {
+        // Tangents of the normal without branches (Duff et al.)
+        const float* n = normal.data();
+        const float sign = std::copysign(1.0f, n[2]);
+        const float a = -1.0f / (sign + n[2]), b = n[0] * n[1] * a;
+        const float tangent[3] = {1.0f + sign * n[0] * n[0] * a, sign * b, -sign * n[0]};
+        const float bitangent[3] = {b, sign + n[1] * n[1] * a, -n[1]};
+        const float up[3] = {n[0], n[1], n[2]};
+
+        random_fill(dst, count, seed, first, [&](const auto* u, auto* v) {
+            using L = std::decay_t<decltype(*u)>;
+            // A point of the unit disk, lifted to the hemisphere (Malley)
+            L s, c;
+            lanes_sincos_turns(u[1], s, c);
+            const L r = L::sqrt(u[0]);
+            const L x = r * c, y = r * s, z = L::sqrt(L::set(1.0f) - u[0]);
+            for (luint i = 0; i < 3; i++)
+                v[i] = L::mad(x, L::set(tangent[i]), L::mad(y, L::set(bitangent[i]), z * L::set(up[i])));
+        });
+    }
+
+    /**
+     * @brief Generate random rotations, uniformly distributed (Shoemake)
+     *
+     * @param dst The array to write the unit quaternions to
+     * @param count The number of quaternions
+     * @param seed The seed of the sequence
+     * @param first The index of the first quaternion in the sequence
+     */
+    inline void random_rotations(quat<float>* dst, const luint count, const uint64 seed, const uint64 first = 0) {
+        random_fill(dst, count, seed, first, [](const auto* u, auto* v) {
+            using L = std::decay_t<decltype(*u)>;
+            L s1, c1, s2, c2;
+            lanes_sincos_turns(u[1], s1, c1);
+            lanes_sincos_turns(u[2], s2, c2);
+            const L r1 = L::sqrt(L::set(1.0f) - u[0]), r2 = L::sqrt(u[0]);
+            v[0] = r1 * s1;
+            v[1] = r1 * c1;
+            v[2] = r2 * s2;
+            v[3] = r2 * c2;
+        });
+    }
+
+
+    //=======
+    // NOISE
+    //=======
+
+    /**
+     * @brief The gradients picked by the hashes of lattice points: unit directions in 2D, and the edges of the cube (Perlin) or hypercube in 3D and 4D
+     */
+    template<luint N>
+    struct noise_gradients;
+
+    template<>
+    struct noise_gradients<2> {
+        static constexpr luint count = 8;
+        static constexpr float values[8][2] = {{1.0f, 0.0f}, {-1.0f, 0.0f}, {0.0f, 1.0f}, {0.0f, -1.0f}, {0.70710678f, 0.70710678f}, {-0.70710678f, 0.70710678f}, {0.70710678f, -0.70710678f}, {-0.70710678f, -0.70710678f}};
+    };
+
+    template<>
+    struct noise_gradients<3> {
+        // The 12 edges, and 4 of them again so a hash picks one with a mask
+        static constexpr luint count = 16;
+        static constexpr float values[16][3] = {{1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0}, {1, 0, 1}, {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1},
+                                                {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1}, {1, 1, 0}, {-1, 1, 0}, {0, -1, 1}, {0, -1, -1}};
+    };
+
+    template<>
+    struct noise_gradients<4> {
+        static constexpr luint count = 32;
+        static constexpr float values[32][4] = {{0, 1, 1, 1}, {0, 1, 1, -1}, {0, 1, -1, 1}, {0, 1, -1, -1}, {0, -1, 1, 1}, {0, -1, 1, -1}, {0, -1, -1, 1}, {0, -1, -1, -1},
+                                                {1, 0, 1, 1}, {1, 0, 1, -1}, {1, 0, -1, 1}, {1, 0, -1, -1}, {-1, 0, 1, 1}, {-1, 0, 1, -1}, {-1, 0, -1, 1}, {-1, 0, -1, -1},
+                                                {1, 1, 0, 1}, {1, 1, 0, -1}, {1, -1, 0, 1}, {1, -1, 0, -1}, {-1, 1, 0, 1}, {-1, 1, 0, -1}, {-1, -1, 0, 1}, {-1, -1, 0, -1},
+                                                {1, 1, 1, 0}, {1, 1, -1, 0}, {1, -1, 1, 0}, {1, -1, -1, 0}, {-1, 1, 1, 0}, {-1, 1, -1, 0}, {-1, -1, 1, 0}, {-1, -1, -1, 0}};
+    };
+
+    /**
+     * @brief Get the storage of lanes as integers, rounded towards zero
+     */
+    template<typename L>
+    inline void lanes_store_int(const L a, int32* dst) {
+        alignas(32) float s[L::count];
+        a.store(s);
+        for (luint k = 0; k < L::count; k++)
+            dst[k] = static_cast<int32>(s[k]);
+    }
+
+    /**
+     * @brief Hash axis I of the corners of the cell of lane k, from the hashes h of the first 2^I corners
+     */
+    template<luint I, luint N, luint L>
+    inline void lanes_perlin_hash_axis(const uint8* perm, const int32 (&cell)[N][L], const luint k, uint32 (&h)[luint(1) << N], int32 (&index)[luint(1) << N][L]) {
+        // Axis by axis as template arguments, so every loop has a constant length and is unrolled
+        const uint32 x = static_cast<uint32>(cell[I][k]) & 255;
+        if constexpr (I + 1 < N) {
+            for (luint e = 0; e < (luint(1) << I); e++) {
+                h[e | (luint(1) << I)] = perm[h[e] + x + 1];
+                h[e] = perm[h[e] + x];
+            }
+            lanes_perlin_hash_axis<I + 1, N>(perm, cell, k, h, index);
+        } else {
+            // The last axis writes the offsets of the gradients directly
+            for (luint e = 0; e < (luint(1) << I); e++) {
+                index[e | (luint(1) << I)][k] = static_cast<int32>((perm[h[e] + x + 1] & (noise_gradients<N>::count - 1)) * N);
+                index[e][k] = static_cast<int32>((perm[h[e] + x] & (noise_gradients<N>::count - 1)) * N);
+            }
+        }
+    }
+
+    /**
+     * @brief Hash the 2^N corners of the cells of every lane (with coordinates wrapped every 256) through a permutation, into the offsets of their gradients
+     *
+     * @param perm A permutation of 0 to 255, repeated twice
+     * @param cell The lowest corner of the cell of every lane
+     * @param index Where to write the offsets in noise_gradients<N>::values, by corner (bit i set for the high side of axis i) and lane
+     */
+    template<luint N, luint L>
+    inline void lanes_perlin_hashes(const uint8* perm, const int32 (&cell)[N][L], int32 (&index)[luint(1) << N][L]) {
+        for (luint k = 0; k < L; k++) {
+            // The hashes of both sides of an axis share those of the axes before it
+            uint32 h[luint(1) << N] = {};
+            lanes_perlin_hash_axis<0, N>(perm, cell, k, h, index);
+        }
+    }
+
+    /**
+     * @brief Calculate Perlin noise (with a quintic fade) in lanes, and optionally its gradient
+     *
+     * @param perm A permutation of 0 to 255, repeated twice
+     * @param p The coordinates of the points
+     * @param value Where to write the noise, between -1 and 1
+     * @param gradient Where to write the gradient of the noise, when G is true
+     */
+    template<luint N, bool G, typename L>
+    inline void lanes_perlin(const uint8* perm, const L* p, L& value, L* gradient) {
+        // Bound of the dot products of the gradients with the offsets from the corners
+        constexpr float scale = N == 2 ? 1.41421356f : N == 3 ? 1.0f : 2.0f / 3.0f;
+        const L one = L::set(1.0f);
+        L f[N], u[N], du[N];
+        int32 cell[N][L::count];
+        for (luint i = 0; i < N; i++) {
+            const L c = L::floor(p[i]);
+            lanes_store_int(c, cell[i]);
+            f[i] = p[i] - c;
+            // 6f^5 - 15f^4 + 10f^3, and its derivative 30f^2 (f - 1)^2
+            const L f2 = f[i] * f[i], g = f[i] - one;
+            u[i] = f2 * f[i] * L::mad(f[i], L::mad(f[i], L::set(6.0f), L::set(-15.0f)), L::set(10.0f));
+            du[i] = L::set(30.0f) * f2 * g * g;
+        }
+
+        constexpr luint corners = luint(1) << N;
+        int32 index[corners][L::count];
+        lanes_perlin_hashes(perm, cell, index);
+
+        // The dot product of the gradient of every corner with the offset from it, whose own gradient is the corner's gradient
+        L n[corners], dn[corners][N];
+        for (luint c = 0; c < corners; c++) {
+            n[c] = L::set(0.0f);
+            for (luint i = 0; i < N; i++) {
+                const L g = L::gather(noise_gradients<N>::values[0] + i, index[c]);
+                n[c] = L::mad(g, ((c >> i) & 1) ? f[i] - one : f[i], n[c]);
+                dn[c][i] = g;
+            }
+        }
+
+        // Interpolated one axis at a time, which halves the number of corners
+        for (luint i = 0; i < N; i++) {
+            for (luint e = 0; e < (corners >> (i + 1)); e++) {
+                const L diff = n[2 * e + 1] - n[2 * e];
+                n[e] = L::mad(u[i], diff, n[2 * e]);
+                if constexpr (G) {
+                    for (luint j = 0; j < N; j++)
+                        dn[e][j] = L::mad(u[i], dn[2 * e + 1][j] - dn[2 * e][j], dn[2 * e][j]);
+                    dn[e][i] = L::mad(du[i], diff, dn[e][i]);
+                }
+            }
+        }
+        value = n[0] * L::set(scale);
+        if constexpr (G)
+            for (luint i = 0; i < N; i++)
+                gradient[i] = dn[0][i] * L::set(scale);
+    }
+
+    /**
+     * @brief Calculate simplex noise in lanes, and optionally its gradient
+     *
+     * @param perm A permutation of 0 to 255, repeated twice
+     * @param p The coordinates of the points
+     * @param value Where to write the noise, close to -1 to 1
+     * @param gradient Where to write the gradient of the noise, when G is true
+     */
+    template<luint N, bool G, typename L>
+    inline void lanes_simplex(const uint8* perm, const L* p, L& value, L* gradient) {
+        // Skew (sqrt(N + 1) - 1) / N and unskew (1 - 1 / sqrt(N + 1)) / N of the lattice, and the measured bound of the sum of the kernels
+        constexpr float skew = N == 2 ? 0.36602540f : N == 3 ? 1.0f / 3.0f : 0.30901699f;
+        constexpr float unskew = N == 2 ? 0.21132487f : N == 3 ? 1.0f / 6.0f : 0.13819660f;
+        constexpr float scale = N == 2 ? 99.2f : N == 3 ? 76.5f : 62.5f;
+
+        L sum = p[0];
+        for (luint i = 1; i < N; i++)
+            sum = sum + p[i];
+        const L s = sum * L::set(skew);
+        L x0[N], cell_sum = L::set(0.0f);
+        int32 cell[N][L::count];
+        for (luint i = 0; i < N; i++) {
+            const L c = L::floor(p[i] + s);
+            lanes_store_int(c, cell[i]);
+            x0[i] = p[i] - c;
+            cell_sum = cell_sum + c;
+        }
+        const L t = cell_sum * L::set(unskew);
+        for (luint i = 0; i < N; i++)
+            x0[i] = x0[i] + t;
+
+        // The corners of the simplex step along the axes from the largest offset to the smallest, ranked by pairwise comparisons
+        L rank[N];
+        for (luint i = 0; i < N; i++)
+            rank[i] = L::set(0.0f);
+        for (luint i = 0; i < N; i++) {
+            for (luint j = i + 1; j < N; j++) {
+                const typename L::mask larger = L::less(x0[j], x0[i]);
+                rank[i] = rank[i] + L::select(larger, L::set(1.0f), L::set(0.0f));
+                rank[j] = rank[j] + L::select(larger, L::set(0.0f), L::set(1.0f));
+            }
+        }
+        // Corner k has stepped along the axes of the k largest ranks
+        int32 ranks[N][L::count];
+        for (luint i = 0; i < N; i++)
+            lanes_store_int(rank[i], ranks[i]);
+        int32 index[N + 1][L::count];
+        for (luint m = 0; m < L::count; m++) {
+            for (luint k = 0; k <= N; k++) {
+                luint h = 0;
+                for (luint i = 0; i < N; i++)
+                    h = perm[h + ((static_cast<uint32>(cell[i][m]) + (ranks[i][m] >= int32(N - k))) & 255)];
+                index[k][m] = static_cast<int32>((h & (noise_gradients<N>::count - 1)) * N);
+            }
+        }
+
+        value = L::set(0.0f);
+        if constexpr (G)
+            for (luint i = 0; i < N; i++)
+                gradient[i] = L::set(0.0f);
+        for (luint k = 0; k <= N; k++) {
+            L d[N], g[N];
+            L r = L::set(0.5f);
+            for (luint i = 0; i < N; i++) {
+                const typename L::mask stepped = L::less(L::set(float(N - k) - 0.5f), rank[i]);
+                d[i] = x0[i] - L::select(stepped, L::set(1.0f), L::set(0.0f)) + L::set(float(k) * unskew);
+                r = r - d[i] * d[i];
+                g[i] = L::gather(noise_gradients<N>::values[0] + i, index[k]);
+            }
+            r = L::max(r, L::set(0.0f));
+
+            L n = g[0] * d[0];
+            for (luint i = 1; i < N; i++)
+                n = L::mad(g[i], d[i], n);
+            const L r2 = r * r, r4 = r2 * r2;
+            value = L::mad(r4, n, value);
+            if constexpr (G) {
+                // Derivative of r^4 (g . d), with r = 0.5 - |d|^2
+                const L slope = L::set(-8.0f) * r2 * r * n;
+                for (luint i = 0; i < N; i++)
+                    gradient[i] = L::mad(r4, g[i], L::mad(slope, d[i], gradient[i]));
+            }
+        }
+
+        value = value * L::set(scale);
+        if constexpr (G)
+            for (luint i = 0; i < N; i++)
+                gradient[i] = gradient[i] * L::set(scale);
+    }
+
+    /**
+     * @brief The kinds of gradient noise
+     */
+    enum class noise_kind {
+        // Interpolated on a square (cube, hypercube) lattice, with 2^N lookups per point
+        perlin,
+        // Summed over the corners of a simplex, with N + 1 lookups per point and fewer axis aligned artifacts
+        simplex
+    };
+
+    /**
+     * @brief Sum octaves of noise of increasing frequency and decreasing amplitude in lanes, normalized by the sum of the amplitudes
+     *
+     * @param ridged Whether to sum (1 - |noise|)^2 (ridges where the noise crosses 0, from 0 to 1) rather than the noise itself (fBm)
+     * @tparam G Whether to also write the gradient
+     */
+    template<luint N, bool G, typename L>
+    inline void lanes_octaves(const uint8* perm, const noise_kind kind, const bool ridged, const L* p, const luint octaves, const float lacunarity, const float gain, L& value, L* gradient) {
+        float frequency = 1.0f, amplitude = 1.0f, total = 0.0f;
+        value = L::set(0.0f);
+        if constexpr (G)
+            for (luint i = 0; i < N; i++)
+                gradient[i] = L::set(0.0f);
+        for (luint o = 0; o < octaves; o++) {
+            // Every octave is shifted, or they would all be 0 at the origin
+            L q[N], n, gn[N];
+            for (luint i = 0; i < N; i++)
+                q[i] = L::mad(p[i], L::set(frequency), L::set(float(o) * 19.19f));
+            if (kind == noise_kind::perlin)
+                lanes_perlin<N, G>(perm, q, n, gn);
+            else
+                lanes_simplex<N, G>(perm, q, n, gn);
+
+            L slope = L::set(amplitude * frequency);
+            if (ridged) {
+                const L r = L::set(1.0f) - L::abs(n);
+                value = L::mad(L::set(amplitude), r * r, value);
+                slope = slope * L::set(-2.0f) * L::select(L::less(n, L::set(0.0f)), -r, r);
+            } else
+                value = L::mad(L::set(amplitude), n, value);
+            if constexpr (G)
+                for (luint i = 0; i < N; i++)
+                    gradient[i] = L::mad(slope, gn[i], gradient[i]);
+
+            total += amplitude;
+            frequency *= lacunarity;
+            amplitude *= gain;
+        }
+
+        if (total > 0.0f) {
+            const L inv_total = L::set(1.0f / total);
+            value = value * inv_total;
+            if constexpr (G)
+                for (luint i = 0; i < N; i++)
+                    gradient[i] = gradient[i] * inv_total;
+        }
+    }
+
+    /**
+     * @brief Run a noise function on L points of an array, and write their values (and gradients)
+     */
+    template<typename L, luint N, typename K>
+    inline void noise_lanes_group(float* dst, vec<N, float>* gradients, const vec<N, float>* points, const K& kernel) {
+        constexpr luint stride = sizeof(vec<N, float>) / sizeof(float);
+        L p[N], value, g[N];
+        for (luint i = 0; i < N; i++)
+            p[i] = L::load_strided(points[0].data() + i, stride);
+        // The kernels only compute gradients when asked to at compile time
+        if (gradients)
+            kernel(std::true_type(), p, value, g);
+        else
+            kernel(std::false_type(), p, value, g);
+        value.store(dst);
+        if (gradients) {
+            alignas(32) float sg[N][L::count];
+            for (luint i = 0; i < N; i++)
+                g[i].store(sg[i]);
+            for (luint k = 0; k < L::count; k++) {
+                float* d = gradients[k].data();
+                for (luint i = 0; i < N; i++)
+                    d[i] = sg[i][k];
+            }
+        }
+    }
+
+    /**
+     * @brief Run a noise function on every point of an array, 4 or 8 at a time when MGMATH_SIMD is defined
+     */
+    template<luint N, typename K>
+    inline void noise_fill(float* dst, vec<N, float>* gradients, const vec<N, float>* points, const luint count, const K& kernel) {
+        MGMATH_PROFILE_BATCH(batch_noise, float, count, profile_simd_build);
+        MGMATH_CHECK_FLOATS_SCOPE("noise_fill", dst, count, reinterpret_cast<const float*>(points), count * N);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(__AVX__)
+        for (; i + 8 <= count; i += 8)
+            noise_lanes_group<float_lanes<8>>(dst + i, gradients ? gradients + i : nullptr, points + i, kernel);
+#endif
+        for (; i + 4 <= count; i += 4)
+            noise_lanes_group<float_lanes<4>>(dst + i, gradients ? gradients + i : nullptr, points + i, kernel);
+#endif
+        for (luint k = 0, rest = count - i; k < rest; k++)
+            noise_lanes_group<float_lanes<1>>(dst + i + k, gradients ? gradients + i + k : nullptr, points + i + k, kernel);
+    }
+
+    /**
+     * @brief A seeded permutation for gradient noise in 2, 3 or 4 dimensions, with a period of 256 along every axis
+     *
+     * The table never changes once built, so a single table can be sampled from any number of threads
+     */
+    struct noise_table {
+        // A permutation of 0 to 255, repeated so lookups of a value plus a coordinate don't wrap
+        uint8 perm[512];
+
+        /**
+         * @brief Shuffle the permutation (Fisher-Yates) with values of philox4x32
+         */
+        explicit noise_table(const uint64 seed = 0) {
+            for (luint i = 0; i < 256; i++)
+                perm[i] = static_cast<uint8>(i);
+            for (luint i = 255; i > 0; i--) {
+                uint32 r[4];
+                philox4x32(r, seed, i);
+                const luint j = r[0] % (i + 1);
+                const uint8 tmp = perm[i];
+                perm[i] = perm[j];
+                perm[j] = tmp;
+            }
+            for (luint i = 0; i < 256; i++)
+                perm[256 + i] = perm[i];
+        }
+
+        /**
+         * @brief Calculate Perlin noise at a point, between -1 and 1
+         */
+        template<luint N>
+        float perlin(const vec<N, float>& p) const {
+            return sample<N>(p, nullptr, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_perlin<N, decltype(with_gradient)::value>(perm, q, v, g); });
+        }
+
+        /**
+         * @brief Calculate Perlin noise and its gradient at a point
+         */
+        template<luint N>
+        float perlin(const vec<N, float>& p, vec<N, float>& gradient) const {
+            return sample<N>(p, &gradient, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_perlin<N, decltype(with_gradient)::value>(perm, q, v, g); });
+        }
+
+        /**
+         * @brief Calculate Perlin noise at many points
+         *
+         * @param dst The array to write the noise to
+         * @param points The points
+         * @param count The number of points
+         */
+        template<luint N>
+        void perlin(float* dst, const vec<N, float>* points, const luint count) const {
+            perlin<N>(dst, nullptr, points, count);
+        }
+
+        /**
+         * @brief Calculate Perlin noise and its gradient at many points
+         *
+         * @param dst The array to write the noise to
+         * @param gradients The array to write the gradients to (or nullptr)
+         * @param points The points
+         * @param count The number of points
+         */
+        template<luint N>
+        void perlin(float* dst, vec<N, float>* gradients, const vec<N, float>* points, const luint count) const {
+            noise_fill<N>(dst, gradients, points, count, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_perlin<N, decltype(with_gradient)::value>(perm, q, v, g); });
+        }
+
+        /**
+         * @brief Calculate simplex noise at a point, close to -1 to 1
+         */
+        template<luint N>
+        float simplex(const vec<N, float>& p) const {
+            return sample<N>(p, nullptr, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_simplex<N, decltype(with_gradient)::value>(perm, q, v, g); });
+        }
+
+        /**
+         * @brief Calculate simplex noise and its gradient at a point
+         */
+        template<luint N>
+        float simplex(const vec<N, float>& p, vec<N, float>& gradient) const {
+            return sample<N>(p, &gradient, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_simplex<N, decltype(with_gradient)::value>(perm, q, v, g); });
+        }
+
+        /**
+         * @brief Calculate simplex noise at many points
+         *
+         * @param dst The array to write the noise to
+         * @param points The points
+         * @param count The number of points
+         */
+        template<luint N>
+        void simplex(float* dst, const vec<N, float>* points, const luint count) const {
+            simplex<N>(dst, nullptr, points, count);
+        }
+
+        /**
+         * @brief Calculate simplex noise and its gradient at many points
+         *
+         * @param dst The array to write the noise to
+         * @param gradients The array to write the gradients to (or nullptr)
+         * @param points The points
+         * @param count The number of points
+         */
+        template<luint N>
+        void simplex(float* dst, vec<N, float>* gradients, const vec<N, float>* points, const luint count) const {
+            noise_fill<N>(dst, gradients, points, count, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_simplex<N, decltype(with_gradient)::value>(perm, q, v, g); });
+        }
+
+        /**
+         * @brief Calculate fractal Brownian motion (octaves of noise, normalized to the range of the noise) at a point
+         *
+         * @param kind The noise of every octave
+         * @param p The point
+         * @param octaves The number of octaves
+         * @param lacunarity The frequency of every octave relative to the previous one
+         * @param gain The amplitude of every octave relative to the previous one
+         */
+        template<luint N>
+        float fbm(const noise_kind kind, const vec<N, float>& p, const luint octaves, const float lacunarity = 2.0f, const float gain = 0.5f) const {
+            return sample<N>(p, nullptr, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_octaves<N, decltype(with_gradient)::value>(perm, kind, false, q, octaves, lacunarity, gain, v, g); });
+        }
+
+        /**
+         * @brief Calculate fractal Brownian motion and its gradient at many points
+         *
+         * @param dst The array to write the values to
+         * @param gradients The array to write the gradients to (or nullptr)
+         * @param points The points
+         * @param count The number of points
+         * @param kind The noise of every octave
+         * @param octaves The number of octaves
+         * @param lacunarity The frequency of every octave relative to the previous one
+         * @param gain The amplitude of every octave relative to the previous one
+         */
+        template<luint N>
+        void fbm(float* dst, vec<N, float>* gradients, const vec<N, float>* points, const luint count, const noise_kind kind, const luint octaves, const float lacunarity = 2.0f, const float gain = 0.5f) const {
+            noise_fill<N>(dst, gradients, points, count, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_octaves<N, decltype(with_gradient)::value>(perm, kind, false, q, octaves, lacunarity, gain, v, g); });
+        }
+
+        /**
+         * @brief Calculate ridged noise (octaves of (1 - |noise|)^2, from 0 to 1, highest where the noise crosses 0) at a point
+         *
+         * @param kind The noise of every octave
+         * @param p The point
+         * @param octaves The number of octaves
+         * @param lacunarity The frequency of every octave relative to the previous one
+         * @param gain The amplitude of every octave relative to the previous one
+         */
+        template<luint N>
+        float ridged(const noise_kind kind, const vec<N, float>& p, const luint octaves, const float lacunarity = 2.0f, const float gain = 0.5f) const {
+            return sample<N>(p, nullptr, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_octaves<N, decltype(with_gradient)::value>(perm, kind, true, q, octaves, lacunarity, gain, v, g); });
+        }
+
+        /**
+         * @brief Calculate ridged noise and its gradient at many points
+         *
+         * @param dst The array to write the values to
+         * @param gradients The array to write the gradients to (or nullptr)
+         * @param points The points
+         * @param count The number of points
+         * @param kind The noise of every octave
+         * @param octaves The number of octaves
+         * @param lacunarity The frequency of every octave relative to the previous one
+         * @param gain The amplitude of every octave relative to the previous one
+         */
+        template<luint N>
+        void ridged(float* dst, vec<N, float>* gradients, const vec<N, float>* points, const luint count, const noise_kind kind, const luint octaves, const float lacunarity = 2.0f, const float gain = 0.5f) const {
+            noise_fill<N>(dst, gradients, points, count, [&](auto with_gradient, const auto* q, auto& v, auto* g) { lanes_octaves<N, decltype(with_gradient)::value>(perm, kind, true, q, octaves, lacunarity, gain, v, g); });
+        }
+
+      private:
+        template<luint N, typename K>
+        static float sample(const vec<N, float>& p, vec<N, float>* gradient, const K& kernel) {
+            float value;
+            noise_lanes_group<float_lanes<1>>(&value, gradient, &p, kernel);
+            return value;
+        }
+    };
+
+
+    //=========
+    // PACKING
+    //=========
+
+    // Error bounds (absolute, per component, for inputs inside the representable range):
+    // - snorm8:  1 / 254       (~3.9e-3)     - unorm8:  1 / 510       (~2.0e-3)
+    // - snorm16: 1 / 65534     (~1.5e-5)     - unorm16: 1 / 131070    (~7.6e-6)
+    // - 10:10:10:2 unorm: 1 / 2046 for xyz, 1 / 6 for w
+    // - 10:10:10:2 snorm: 1 / 1022 for xyz, 1 / 2 for w
+    // - octahedral 2x16 (4 bytes): max angular error ~0.0037 degrees
+    // - octahedral 2x8 (2 bytes):  max angular error ~0.96 degrees
+    // Values outside the range are clamped; NaN inputs produce unspecified results
+
+    /**
+     * @brief Quantize a float in [-1, 1] to a signed normalized integer (int8 or int16)
+     *
+     * @param v The value to quantize
+     */
+    template<typename I>
+    inline I pack_snorm(const float v) {
+        static_assert(std::is_same_v<I, int8> || std::is_same_v<I, int16>, "snorm packing supports int8 and int16");
+        constexpr float scale = static_cast<float>(std::numeric_limits<I>::max());
+        return static_cast<I>(std::lrint(clamp(-1.0f, 1.0f, v) * scale));
+    }
+
+    /**
+     * @brief Convert a signed normalized integer (int8 or int16) back to a float in [-1, 1]
+     *
+     * @param v The quantized value
+     */
+    template<typename I>
+    inline float unpack_snorm(const I v) {
+        static_assert(std::is_same_v<I, int8> || std::is_same_v<I, int16>, "snorm packing supports int8 and int16");
+        constexpr float inv_scale = 1.0f / static_cast<float>(std::numeric_limits<I>::max());
+        return max(static_cast<float>(v) * inv_scale, -1.0f);
+    }
+
+    /**
+     * @brief Quantize a float in [0, 1] to an unsigned normalized integer (uint8 or uint16)
+     *
+     * @param v The value to quantize
+     */
+    template<typename I>
+    inline I pack_unorm(const float v) {
+        static_assert(std::is_same_v<I, uint8> || std::is_same_v<I, uint16>, "unorm packing supports uint8 and uint16");
+        constexpr float scale = static_cast<float>(std::numeric_limits<I>::max());
+        return static_cast<I>(std::lrint(clamp(0.0f, 1.0f, v) * scale));
+    }
+
+    /**
+     * @brief Convert an unsigned normalized integer (uint8 or uint16) back to a float in [0, 1]
+     *
+     * @param v The quantized value
+     */
+    template<typename I>
+    inline float unpack_unorm(const I v) {
+        static_assert(std::is_same_v<I, uint8> || std::is_same_v<I, uint16>, "unorm packing supports uint8 and uint16");
+        constexpr float inv_scale = 1.0f / static_cast<float>(std::numeric_limits<I>::max());
+        return static_cast<float>(v) * inv_scale;
+    }
+
+    /**
+     * @brief Quantize every component of a vector to a signed normalized integer
+     *
+     * @param v The vector to quantize, with components in [-1, 1]
+     */
+    template<typename I, luint S>
+    inline vec<S, I> pack_snorm(const vec<S, float>& v) {
+        vec<S, I> res;
+        for (luint i = 0; i < S; i++)
+            res[i] = pack_snorm<I>(v[i]);
+        return res;
+    }
+
+    /**
+     * @brief Convert a vector of signed normalized integers back to floats
+     *
+     * @param v The quantized vector
+     */
+    template<typename I, luint S>
+    inline vec<S, float> unpack_snorm(const vec<S, I>& v) {
+        vec<S, float> res;
+        for (luint i = 0; i < S; i++)
+            res[i] = unpack_snorm<I>(v[i]);
+        return res;
+    }
+
+    /**
+     * @brief Quantize every component of a vector to an unsigned normalized integer
+     *
+     * @param v The vector to quantize, with components in [0, 1]
+     */
+    template<typename I, luint S>
+    inline vec<S, I> pack_unorm(const vec<S, float>& v) {
+        vec<S, I> res;
+        for (luint i = 0; i < S; i++)
+            res[i] = pack_unorm<I>(v[i]);
+        return res;
+    }
+
+    /**
+     * @brief Convert a vector of unsigned normalized integers back to floats
+     *
+     * @param v The quantized vector
+     */
+    template<typename I, luint S>
+    inline vec<S, float> unpack_unorm(const vec<S, I>& v) {
+        vec<S, float> res;
+        for (luint i = 0; i < S; i++)
+            res[i] = unpack_unorm<I>(v[i]);
+        return res;
+    }
+
+    /**
+     * @brief Pack a vector with components in [0, 1] into 10:10:10:2 bits (x in the lowest bits, w in the highest)
+     *
+     * @param v The vector to pack
+     */
+    inline uint32 pack_unorm10_10_10_2(const vec<4, float>& v) {
+        const auto x = static_cast<uint32>(std::lrint(clamp(0.0f, 1.0f, v.x) * 1023.0f));
+        const auto y = static_cast<uint32>(std::lrint(clamp(0.0f, 1.0f, v.y) * 1023.0f));
+        const auto z = static_cast<uint32>(std::lrint(clamp(0.0f, 1.0f, v.z) * 1023.0f));
+        const auto w = static_cast<uint32>(std::lrint(clamp(0.0f, 1.0f, v.w) * 3.0f));
+        return x | (y << 10) | (z << 20) | (w << 30);
+    }
+
+    /**
+     * @brief Unpack a 10:10:10:2 unsigned normalized value into a vector with components in [0, 1]
+     *
+     * @param p The packed value
+     */
+    inline vec<4, float> unpack_unorm10_10_10_2(const uint32 p) {
+        return vec<4, float>{
+            static_cast<float>(p & 0x3ff) * (1.0f / 1023.0f),
+            static_cast<float>((p >> 10) & 0x3ff) * (1.0f / 1023.0f),
+            static_cast<float>((p >> 20) & 0x3ff) * (1.0f / 1023.0f),
+            static_cast<float>(p >> 30) * (1.0f / 3.0f)
+        };
+    }
+
+    /**
+     * @brief Pack a vector with components in [-1, 1] into signed 10:10:10:2 bits (x in the lowest bits, w in the highest)
+     *
+     * @param v The vector to pack
+     */
+    inline uint32 pack_snorm10_10_10_2(const vec<4, float>& v) {
+        const auto x = static_cast<uint32>(std::lrint(clamp(-1.0f, 1.0f, v.x) * 511.0f)) & 0x3ff;
+        const auto y = static_cast<uint32>(std::lrint(clamp(-1.0f, 1.0f, v.y) * 511.0f)) & 0x3ff;
+        const auto z = static_cast<uint32>(std::lrint(clamp(-1.0f, 1.0f, v.z) * 511.0f)) & 0x3ff;
+        const auto w = static_cast<uint32>(std::lrint(clamp(-1.0f, 1.0f, v.w))) & 0x3;
+        return x | (y << 10) | (z << 20) | (w << 30);
+    }
+
+    /**
+     * @brief Unpack a signed 10:10:10:2 normalized value into a vector with components in [-1, 1]
+     *
+     * @param p The packed value
+     */
+    inline vec<4, float> unpack_snorm10_10_10_2(const uint32 p) {
+        const auto x = static_cast<int32>(p << 22) >> 22;
+        const auto y = static_cast<int32>(p << 12) >> 22;
+        const auto z = static_cast<int32>(p << 2) >> 22;
+        const auto w = static_cast<int32>(p) >> 30;
+        return vec<4, float>{
+            max(static_cast<float>(x) * (1.0f / 511.0f), -1.0f),
+            max(static_cast<float>(y) * (1.0f / 511.0f), -1.0f),
+            max(static_cast<float>(z) * (1.0f / 511.0f), -1.0f),
+            max(static_cast<float>(w), -1.0f)
+        };
+    }
+
+    /**
+     * @brief Project a unit vector onto the octahedron, unfolded into the [-1, 1] square
+     *
+     * @param n The normalized vector
+     */
+    inline vec<2, float> oct_encode(const vec<3, float>& n) {
+        const float inv_l1 = 1.0f / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+        float x = n.x * inv_l1;
+        float y = n.y * inv_l1;
+        if (n.z < 0.0f) {
+            const float fx = (1.0f - std::abs(y)) * std::copysign(1.0f, x);
+            const float fy = (1.0f - std::abs(x)) * std::copysign(1.0f, y);
+            x = fx;
+            y = fy;
+        }
+        return vec<2, float>{x, y};
+    }
+
+    /**
+     * @brief Reconstruct a unit vector from its octahedral projection
+     *
+     * @param p The projected point in the [-1, 1] square
+     */
+    inline vec<3, float> oct_decode(const vec<2, float>& p) {
+        vec<3, float> n{p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y)};
+        const float t = max(-n.z, 0.0f);
+        n.x -= std::copysign(t, n.x);
+        n.y -= std::copysign(t, n.y);
+        return n / std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+    }
+
+    /**
+     * @brief Compress a unit vector into 2x16 bits using octahedral encoding
+     *
+     * @param n The normalized vector
+     */
+    inline vec<2, int16> pack_oct16(const vec<3, float>& n) {
+        return pack_snorm<int16>(oct_encode(n));
+    }
+
+    /**
+     * @brief Decompress a unit vector from 2x16 bits of octahedral encoding
+     *
+     * @param p The packed vector
+     */
+    inline vec<3, float> unpack_oct16(const vec<2, int16>& p) {
+        return oct_decode(unpack_snorm(p));
+    }
+
+    /**
+     * @brief Compress a unit vector into 2x8 bits using octahedral encoding
+     *
+     * @param n The normalized vector
+     */
+    inline vec<2, int8> pack_oct8(const vec<3, float>& n) {
+        return pack_snorm<int8>(oct_encode(n));
+    }
+
+    /**
+     * @brief Decompress a unit vector from 2x8 bits of octahedral encoding
+     *
+     * @param p The packed vector
+     */
+    inline vec<3, float> unpack_oct8(const vec<2, int8>& p) {
+        return oct_decode(unpack_snorm(p));
+    }
+
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+    /**
+     * @brief Load 4 consecutive vec3f and split them into one register per component
+     */
+    inline void simd_load_soa3(const float* p, __m128& x, __m128& y, __m128& z) {
+        const __m128 a = _mm_loadu_ps(p);
+        const __m128 b = _mm_loadu_ps(p + 4);
+        const __m128 c = _mm_loadu_ps(p + 8);
+        x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+    }
+
+    /**
+     * @brief Interleave one register per component back into 4 consecutive vec3f
+     */
+    inline void simd_store_soa3(float* p, const __m128 x, const __m128 y, const __m128 z) {
+        const __m128 a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        _mm_storeu_ps(p, a);
+        _mm_storeu_ps(p + 4, b);
+        _mm_storeu_ps(p + 8, c);
+    }
+
+    /**
+     * @brief Quantize 16 floats, already clamped and scaled, and store them as 8 or 16 bit integers
+     */
+    template<typename I>
+    inline void simd_store_quantized16(I* dst, const __m128 a, const __m128 b, const __m128 c, const __m128 d) {
+        const __m128i ia = _mm_cvtps_epi32(a), ib = _mm_cvtps_epi32(b), ic = _mm_cvtps_epi32(c), id = _mm_cvtps_epi32(d);
+        if constexpr (std::is_same_v<I, int8>)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packs_epi16(_mm_packs_epi32(ia, ib), _mm_packs_epi32(ic, id)));
+        else if constexpr (std::is_same_v<I, uint8>)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(_mm_packs_epi32(ia, ib), _mm_packs_epi32(ic, id)));
+        else if constexpr (std::is_same_v<I, int16>) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packs_epi32(ia, ib));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_packs_epi32(ic, id));
+        }
+        else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi32(ia, ib));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_packus_epi32(ic, id));
+        }
+    }
+
+    /**
+     * @brief Load 4 consecutive 8 or 16 bit integers and widen them to floats
+     */
+    template<typename I>
+    inline __m128 simd_load_widened4(const I* src) {
+        __m128i v;
+        if constexpr (sizeof(I) == 1) {
+            int32 bits;
+            memcpy(&bits, src, sizeof(bits));
+            v = _mm_cvtsi32_si128(bits);
+        }
+        else
+            v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+
+        if constexpr (std::is_same_v<I, int8>)
+            v = _mm_cvtepi8_epi32(v);
+        else if constexpr (std::is_same_v<I, uint8>)
+            v = _mm_cvtepu8_epi32(v);
+        else if constexpr (std::is_same_v<I, int16>)
+            v = _mm_cvtepi16_epi32(v);
+        else
+            v = _mm_cvtepu16_epi32(v);
+        return _mm_cvtepi32_ps(v);
+    }
+#endif
+
+    /**
+     * @brief Quantize an array of vectors with components in [-1, 1] to signed normalized integers
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of vectors to convert
+     */
+    template<typename I, luint S>
+    inline void pack_snorm(vec<S, I>* dst, const vec<S, float>* src, const luint count) {
+        static_assert(sizeof(vec<S, I>) == S * sizeof(I) && sizeof(vec<S, float>) == S * sizeof(float), "Vectors must be tightly packed");
+        MGMATH_PROFILE_BATCH(batch_pack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("pack_snorm", dst, count, reinterpret_cast<const float*>(src), count * S);
+        const float* in = src->data();
+        I* out = dst->data();
+        const luint n = count * S;
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(static_cast<float>(std::numeric_limits<I>::max()));
+        for (; i + 16 <= n; i += 16) {
+            const __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi), scale);
+            const __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi), scale);
+            const __m128 c = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 8), lo), hi), scale);
+            const __m128 d = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 12), lo), hi), scale);
+            simd_store_quantized16(out + i, a, b, c, d);
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = pack_snorm<I>(in[i]);
+    }
+
+    /**
+     * @brief Convert an array of signed normalized integer vectors back to floats
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of vectors to convert
+     */
+    template<typename I, luint S>
+    inline void unpack_snorm(vec<S, float>* dst, const vec<S, I>* src, const luint count) {
+        static_assert(sizeof(vec<S, I>) == S * sizeof(I) && sizeof(vec<S, float>) == S * sizeof(float), "Vectors must be tightly packed");
+        MGMATH_PROFILE_BATCH(batch_unpack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("unpack_snorm", reinterpret_cast<const float*>(dst), count * S);
+        const I* in = src->data();
+        float* out = dst->data();
+        const luint n = count * S;
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 lo = _mm_set1_ps(-1.0f);
+        const __m128 inv_scale = _mm_set1_ps(1.0f / static_cast<float>(std::numeric_limits<I>::max()));
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(out + i, _mm_max_ps(_mm_mul_ps(simd_load_widened4(in + i), inv_scale), lo));
+#endif
+        for (; i < n; i++)
+            out[i] = unpack_snorm<I>(in[i]);
+    }
+
+    /**
+     * @brief Quantize an array of vectors with components in [0, 1] to unsigned normalized integers
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of vectors to convert
+     */
+    template<typename I, luint S>
+    inline void pack_unorm(vec<S, I>* dst, const vec<S, float>* src, const luint count) {
+        static_assert(sizeof(vec<S, I>) == S * sizeof(I) && sizeof(vec<S, float>) == S * sizeof(float), "Vectors must be tightly packed");
+        MGMATH_PROFILE_BATCH(batch_pack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("pack_unorm", dst, count, reinterpret_cast<const float*>(src), count * S);
+        const float* in = src->data();
+        I* out = dst->data();
+        const luint n = count * S;
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(static_cast<float>(std::numeric_limits<I>::max()));
+        for (; i + 16 <= n; i += 16) {
+            const __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi), scale);
+            const __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi), scale);
+            const __m128 c = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 8), lo), hi), scale);
+            const __m128 d = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 12), lo), hi), scale);
+            simd_store_quantized16(out + i, a, b, c, d);
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = pack_unorm<I>(in[i]);
+    }
+
+    /**
+     * @brief Convert an array of unsigned normalized integer vectors back to floats
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of vectors to convert
+     */
+    template<typename I, luint S>
+    inline void unpack_unorm(vec<S, float>* dst, const vec<S, I>* src, const luint count) {
+        static_assert(sizeof(vec<S, I>) == S * sizeof(I) && sizeof(vec<S, float>) == S * sizeof(float), "Vectors must be tightly packed");
+        MGMATH_PROFILE_BATCH(batch_unpack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("unpack_unorm", reinterpret_cast<const float*>(dst), count * S);
+        const I* in = src->data();
+        float* out = dst->data();
+        const luint n = count * S;
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 inv_scale = _mm_set1_ps(1.0f / static_cast<float>(std::numeric_limits<I>::max()));
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(out + i, _mm_mul_ps(simd_load_widened4(in + i), inv_scale));
+#endif
+        for (; i < n; i++)
+            out[i] = unpack_unorm<I>(in[i]);
+    }
+
+    /**
+     * @brief Pack an array of vectors into 10:10:10:2 unsigned normalized values
+     *
+     * @param dst The destination array, with room for count values
+     * @param src The source array
+     * @param count The number of vectors to pack
+     */
+    inline void pack_unorm10_10_10_2(uint32* dst, const vec<4, float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_pack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("pack_unorm10_10_10_2", dst, count, reinterpret_cast<const float*>(src), count * 4);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set_ps(3.0f, 1023.0f, 1023.0f, 1023.0f);
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(src[i].data()), y = _mm_loadu_ps(src[i + 1].data());
+            __m128 z = _mm_loadu_ps(src[i + 2].data()), w = _mm_loadu_ps(src[i + 3].data());
+            x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, lo), hi), scale);
+            y = _mm_mul_ps(_mm_min_ps(_mm_max_ps(y, lo), hi), scale);
+            z = _mm_mul_ps(_mm_min_ps(_mm_max_ps(z, lo), hi), scale);
+            w = _mm_mul_ps(_mm_min_ps(_mm_max_ps(w, lo), hi), scale);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            __m128i res = _mm_cvtps_epi32(x);
+            res = _mm_or_si128(res, _mm_slli_epi32(_mm_cvtps_epi32(y), 10));
+            res = _mm_or_si128(res, _mm_slli_epi32(_mm_cvtps_epi32(z), 20));
+            res = _mm_or_si128(res, _mm_slli_epi32(_mm_cvtps_epi32(w), 30));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), res);
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = pack_unorm10_10_10_2(src[i]);
+    }
+
+    /**
+     * @brief Unpack an array of 10:10:10:2 unsigned normalized values
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of values to unpack
+     */
+    inline void unpack_unorm10_10_10_2(vec<4, float>* dst, const uint32* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_unpack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("unpack_unorm10_10_10_2", reinterpret_cast<const float*>(dst), count * 4);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128i mask = _mm_set1_epi32(0x3ff);
+        const __m128 inv_scale = _mm_set_ps(1.0f / 3.0f, 1.0f / 1023.0f, 1.0f / 1023.0f, 1.0f / 1023.0f);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128 x = _mm_cvtepi32_ps(_mm_and_si128(p, mask));
+            __m128 y = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 10), mask));
+            __m128 z = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 20), mask));
+            __m128 w = _mm_cvtepi32_ps(_mm_srli_epi32(p, 30));
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(dst[i].data(), _mm_mul_ps(x, inv_scale));
+            _mm_storeu_ps(dst[i + 1].data(), _mm_mul_ps(y, inv_scale));
+            _mm_storeu_ps(dst[i + 2].data(), _mm_mul_ps(z, inv_scale));
+            _mm_storeu_ps(dst[i + 3].data(), _mm_mul_ps(w, inv_scale));
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = unpack_unorm10_10_10_2(src[i]);
+    }
+
+    /**
+     * @brief Pack an array of vectors into signed 10:10:10:2 normalized values
+     *
+     * @param dst The destination array, with room for count values
+     * @param src The source array
+     * @param count The number of vectors to pack
+     */
+    inline void pack_snorm10_10_10_2(uint32* dst, const vec<4, float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_pack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("pack_snorm10_10_10_2", dst, count, reinterpret_cast<const float*>(src), count * 4);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set_ps(1.0f, 511.0f, 511.0f, 511.0f);
+        const __m128i mask10 = _mm_set1_epi32(0x3ff);
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(src[i].data()), y = _mm_loadu_ps(src[i + 1].data());
+            __m128 z = _mm_loadu_ps(src[i + 2].data()), w = _mm_loadu_ps(src[i + 3].data());
+            x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, lo), hi), scale);
+            y = _mm_mul_ps(_mm_min_ps(_mm_max_ps(y, lo), hi), scale);
+            z = _mm_mul_ps(_mm_min_ps(_mm_max_ps(z, lo), hi), scale);
+            w = _mm_mul_ps(_mm_min_ps(_mm_max_ps(w, lo), hi), scale);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            __m128i res = _mm_and_si128(_mm_cvtps_epi32(x), mask10);
+            res = _mm_or_si128(res, _mm_slli_epi32(_mm_and_si128(_mm_cvtps_epi32(y), mask10), 10));
+            res = _mm_or_si128(res, _mm_slli_epi32(_mm_and_si128(_mm_cvtps_epi32(z), mask10), 20));
+            res = _mm_or_si128(res, _mm_slli_epi32(_mm_cvtps_epi32(w), 30));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), res);
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = pack_snorm10_10_10_2(src[i]);
+    }
+
+    /**
+     * @brief Unpack an array of signed 10:10:10:2 normalized values
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of values to unpack
+     */
+    inline void unpack_snorm10_10_10_2(vec<4, float>* dst, const uint32* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_unpack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("unpack_snorm10_10_10_2", reinterpret_cast<const float*>(dst), count * 4);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 lo = _mm_set1_ps(-1.0f);
+        const __m128 inv_scale = _mm_set_ps(1.0f, 1.0f / 511.0f, 1.0f / 511.0f, 1.0f / 511.0f);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128 x = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(p, 22), 22));
+            __m128 y = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(p, 12), 22));
+            __m128 z = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(p, 2), 22));
+            __m128 w = _mm_cvtepi32_ps(_mm_srai_epi32(p, 30));
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(dst[i].data(), _mm_max_ps(_mm_mul_ps(x, inv_scale), lo));
+            _mm_storeu_ps(dst[i + 1].data(), _mm_max_ps(_mm_mul_ps(y, inv_scale), lo));
+            _mm_storeu_ps(dst[i + 2].data(), _mm_max_ps(_mm_mul_ps(z, inv_scale), lo));
+            _mm_storeu_ps(dst[i + 3].data(), _mm_max_ps(_mm_mul_ps(w, inv_scale), lo));
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = unpack_snorm10_10_10_2(src[i]);
+    }
+
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+    /**
+     * @brief Octahedral projection of 4 unit vectors at once, scaled to the integer range
+     */
+    inline void simd_oct_encode(const float* src, const __m128 scale, __m128i& x, __m128i& y) {
+        const __m128 sign_mask = _mm_set1_ps(-0.0f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 nx, ny, nz;
+        simd_load_soa3(src, nx, ny, nz);
+        const __m128 l1 = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign_mask, nx), _mm_andnot_ps(sign_mask, ny)), _mm_andnot_ps(sign_mask, nz));
+        const __m128 inv_l1 = _mm_div_ps(one, l1);
+        const __m128 px = _mm_mul_ps(nx, inv_l1);
+        const __m128 py = _mm_mul_ps(ny, inv_l1);
+        const __m128 fx = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, py)), _mm_or_ps(one, _mm_and_ps(px, sign_mask)));
+        const __m128 fy = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, px)), _mm_or_ps(one, _mm_and_ps(py, sign_mask)));
+        const __m128 folded = _mm_cmplt_ps(nz, _mm_setzero_ps());
+        const __m128 ox = _mm_min_ps(_mm_max_ps(_mm_blendv_ps(px, fx, folded), _mm_sub_ps(_mm_setzero_ps(), one)), one);
+        const __m128 oy = _mm_min_ps(_mm_max_ps(_mm_blendv_ps(py, fy, folded), _mm_sub_ps(_mm_setzero_ps(), one)), one);
+        x = _mm_cvtps_epi32(_mm_mul_ps(ox, scale));
+        y = _mm_cvtps_epi32(_mm_mul_ps(oy, scale));
+    }
+
+    /**
+     * @brief Reconstruct 4 unit vectors at once from their integer octahedral projections
+     */
+    inline void simd_oct_decode(float* dst, const __m128i ix, const __m128i iy, const __m128 inv_scale) {
+        const __m128 sign_mask = _mm_set1_ps(-0.0f);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 x = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(ix), inv_scale), _mm_sub_ps(_mm_setzero_ps(), one));
+        const __m128 y = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(iy), inv_scale), _mm_sub_ps(_mm_setzero_ps(), one));
+        const __m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, x)), _mm_andnot_ps(sign_mask, y));
+        const __m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+        const __m128 nx = _mm_sub_ps(x, _mm_or_ps(t, _mm_and_ps(x, sign_mask)));
+        const __m128 ny = _mm_sub_ps(y, _mm_or_ps(t, _mm_and_ps(y, sign_mask)));
+        const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(z, z)));
+        simd_store_soa3(dst, _mm_div_ps(nx, len), _mm_div_ps(ny, len), _mm_div_ps(z, len));
+    }
+#endif
+
+    /**
+     * @brief Compress an array of unit vectors into 2x16 bits each using octahedral encoding
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array of normalized vectors
+     * @param count The number of vectors to compress
+     */
+    inline void pack_oct16(vec<2, int16>* dst, const vec<3, float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_pack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("pack_oct16", dst, count, reinterpret_cast<const float*>(src), count * 3);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        const __m128i low16 = _mm_set1_epi32(0xffff);
+        for (; i + 4 <= count; i += 4) {
+            __m128i x, y;
+            simd_oct_encode(src[i].data(), scale, x, y);
+            const __m128i res = _mm_or_si128(_mm_and_si128(x, low16), _mm_slli_epi32(y, 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[i].data()), res);
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = pack_oct16(src[i]);
+    }
+
+    /**
+     * @brief Decompress an array of 2x16 bit octahedral encoded unit vectors
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of vectors to decompress
+     */
+    inline void unpack_oct16(vec<3, float>* dst, const vec<2, int16>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_unpack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("unpack_oct16", reinterpret_cast<const float*>(dst), count * 3);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 inv_scale = _mm_set1_ps(1.0f / 32767.0f);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[i].data()));
+            simd_oct_decode(dst[i].data(), _mm_srai_epi32(_mm_slli_epi32(p, 16), 16), _mm_srai_epi32(p, 16), inv_scale);
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = unpack_oct16(src[i]);
+    }
+
+    /**
+     * @brief Compress an array of unit vectors into 2x8 bits each using octahedral encoding
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array of normalized vectors
+     * @param count The number of vectors to compress
+     */
+    inline void pack_oct8(vec<2, int8>* dst, const vec<3, float>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_pack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("pack_oct8", dst, count, reinterpret_cast<const float*>(src), count * 3);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 scale = _mm_set1_ps(127.0f);
+        const __m128i low8 = _mm_set1_epi32(0xff);
+        for (; i + 4 <= count; i += 4) {
+            __m128i x, y;
+            simd_oct_encode(src[i].data(), scale, x, y);
+            const __m128i res = _mm_or_si128(_mm_and_si128(x, low8), _mm_slli_epi32(_mm_and_si128(y, low8), 8));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[i].data()), _mm_packus_epi32(res, res));
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = pack_oct8(src[i]);
+    }
+
+    /**
+     * @brief Decompress an array of 2x8 bit octahedral encoded unit vectors
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of vectors to decompress
+     */
+    inline void unpack_oct8(vec<3, float>* dst, const vec<2, int8>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_unpack, float, count, profile_simd_sse4_1_build);
+        MGMATH_CHECK_FLOATS_SCOPE("unpack_oct8", reinterpret_cast<const float*>(dst), count * 3);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        const __m128 inv_scale = _mm_set1_ps(1.0f / 127.0f);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i p = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[i].data())));
+            simd_oct_decode(dst[i].data(), _mm_srai_epi32(_mm_slli_epi32(p, 24), 24), _mm_srai_epi32(_mm_slli_epi32(p, 16), 24), inv_scale);
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = unpack_oct8(src[i]);
+    }
+
+    // Smallest three quaternion packing: the largest component is dropped (and made positive by negating the
+    // quaternion, which represents the same rotation), and the other three are quantized to Bits bits each over
+    // [-1/sqrt(2), 1/sqrt(2)]. The index of the dropped component takes the 2 highest used bits.
+    // Maximum rotation angle error for unit quaternions is 4.95 / (2^Bits - 1) radians:
+    // - 10 bits (uint32): ~0.28 degrees
+    // - 15 bits (uint64, 47 bits used): ~0.0087 degrees
+    // - 20 bits (uint64, 62 bits used): ~0.0003 degrees (close to float precision)
+    // 21 bits per component would need 65 bits with the index, so 20 is the most that fits in a uint64
+
+    template<uint Bits>
+    using packed_quat = std::conditional_t<(3 * Bits + 2 <= 32), uint32, uint64>;
+
+    /**
+     * @brief Compress a unit quaternion using smallest three packing
+     *
+     * @param q The normalized quaternion to compress
+     * @return The packed quaternion (uint32 for Bits = 10, uint64 for larger sizes)
+     */
+    template<uint Bits, typename T>
+    inline packed_quat<Bits> pack_quat(const quat<T>& q) {
+        static_assert(Bits >= 2 && 3 * Bits + 2 <= 64, "Smallest three packing needs 2 to 20 bits per component");
+        using P = packed_quat<Bits>;
+        constexpr T max_value = static_cast<T>((P(1) << Bits) - 1);
+        constexpr T sqrt1_2 = static_cast<T>(0.707106781186547524400844362104849039);
+
+        const T* c = q.data();
+        uint32 largest = 0;
+        for (uint32 i = 1; i < 4; i++)
+            if (std::abs(c[i]) > std::abs(c[largest]))
+                largest = i;
+        const T sign = c[largest] < T(0) ? T(-1) : T(1);
+
+        P res = P(largest) << (3 * Bits);
+        uint32 shift = 0;
+        for (uint32 i = 0; i < 4; i++) {
+            if (i == largest)
+                continue;
+            const T u = clamp(T(0), max_value, (c[i] * sign * sqrt1_2 + T(0.5)) * max_value);
+            res |= static_cast<P>(std::llrint(u)) << shift;
+            shift += Bits;
+        }
+        return res;
+    }
+
+    /**
+     * @brief Decompress a quaternion compressed using smallest three packing
+     *
+     * @param p The packed quaternion
+     * @return The decompressed unit quaternion
+     */
+    template<uint Bits, typename T = float>
+    inline quat<T> unpack_quat(const packed_quat<Bits> p) {
+        static_assert(Bits >= 2 && 3 * Bits + 2 <= 64, "Smallest three packing needs 2 to 20 bits per component");
+        using P = packed_quat<Bits>;
+        constexpr P mask = (P(1) << Bits) - 1;
+        constexpr T scale = T(2) / static_cast<T>(mask);
+        constexpr T sqrt1_2 = static_cast<T>(0.707106781186547524400844362104849039);
+
+        const uint32 largest = static_cast<uint32>(p >> (3 * Bits)) & 3;
+        T c[4]{};
+        T sum = T(0);
+        uint32 shift = 0;
+        for (uint32 i = 0; i < 4; i++) {
+            if (i == largest)
+                continue;
+            c[i] = (static_cast<T>((p >> shift) & mask) * scale - T(1)) * sqrt1_2;
+            sum += c[i] * c[i];
+            shift += Bits;
+        }
+        c[largest] = std::sqrt(max(T(0), T(1) - sum));
+        return quat<T>{c[0], c[1], c[2], c[3]};
+    }
+
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+    /**
+     * @brief Smallest three quantization of 4 quaternions at once, producing the index and the 3 kept components
+     */
+    inline void simd_quantize_quat4(const float* src, const float max_value, __m128i& idx, __m128i& a, __m128i& b, __m128i& c) {
+        const __m128 sign_mask = _mm_set1_ps(-0.0f);
+        __m128 x = _mm_loadu_ps(src), y = _mm_loadu_ps(src + 4), z = _mm_loadu_ps(src + 8), w = _mm_loadu_ps(src + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        const __m128 ax = _mm_andnot_ps(sign_mask, x), ay = _mm_andnot_ps(sign_mask, y);
+        const __m128 az = _mm_andnot_ps(sign_mask, z), aw = _mm_andnot_ps(sign_mask, w);
+        const __m128 m = _mm_max_ps(_mm_max_ps(ax, ay), _mm_max_ps(az, aw));
+
+        // Lowest index wins on ties, same as the scalar version
+        const __m128 is_x = _mm_cmpeq_ps(ax, m);
+        const __m128 is_y = _mm_andnot_ps(is_x, _mm_cmpeq_ps(ay, m));
+        const __m128 is_z = _mm_andnot_ps(_mm_or_ps(is_x, is_y), _mm_cmpeq_ps(az, m));
+        const __m128 is_w = _mm_andnot_ps(_mm_or_ps(_mm_or_ps(is_x, is_y), is_z), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+        idx = _mm_and_si128(_mm_castps_si128(is_y), _mm_set1_epi32(1));
+        idx = _mm_or_si128(idx, _mm_and_si128(_mm_castps_si128(is_z), _mm_set1_epi32(2)));
+        idx = _mm_or_si128(idx, _mm_and_si128(_mm_castps_si128(is_w), _mm_set1_epi32(3)));
+
+        __m128 largest = _mm_blendv_ps(w, z, is_z);
+        largest = _mm_blendv_ps(largest, y, is_y);
+        largest = _mm_blendv_ps(largest, x, is_x);
+        const __m128 sign = _mm_and_ps(largest, sign_mask);
+
+        const __m128 va = _mm_xor_ps(_mm_blendv_ps(x, y, is_x), sign);
+        const __m128 vb = _mm_xor_ps(_mm_blendv_ps(y, z, _mm_or_ps(is_x, is_y)), sign);
+        const __m128 vc = _mm_xor_ps(_mm_blendv_ps(z, w, _mm_andnot_ps(is_w, _mm_castsi128_ps(_mm_set1_epi32(-1)))), sign);
+
+        const __m128 k = _mm_set1_ps(0.707106781186547524400844362104849039f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 mx = _mm_set1_ps(max_value);
+        const __m128 zero = _mm_setzero_ps();
+        a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(va, k), half), mx), zero), mx));
+        b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(vb, k), half), mx), zero), mx));
+        c = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(vc, k), half), mx), zero), mx));
+    }
+
+    /**
+     * @brief Reconstruct 4 quaternions at once from their smallest three index and quantized components
+     */
+    inline void simd_dequantize_quat4(float* dst, const float max_value, const __m128i idx, const __m128i ia, const __m128i ib, const __m128i ic) {
+        const __m128 scale = _mm_set1_ps(2.0f / max_value);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 k = _mm_set1_ps(0.707106781186547524400844362104849039f);
+        const __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(ia), scale), one), k);
+        const __m128 b = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(ib), scale), one), k);
+        const __m128 c = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(ic), scale), one), k);
+        const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)), _mm_mul_ps(c, c));
+        const __m128 m = _mm_sqrt_ps(_mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(one, sum)));
+
+        const __m128 is_x = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_setzero_si128()));
+        const __m128 is_y = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_set1_epi32(1)));
+        const __m128 is_z = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_set1_epi32(2)));
+        const __m128 is_w = _mm_castsi128_ps(_mm_cmpeq_epi32(idx, _mm_set1_epi32(3)));
+        __m128 x = _mm_blendv_ps(a, m, is_x);
+        __m128 y = _mm_blendv_ps(_mm_blendv_ps(b, m, is_y), a, is_x);
+        __m128 z = _mm_blendv_ps(_mm_blendv_ps(c, m, is_z), b, _mm_or_ps(is_x, is_y));
+        __m128 w = _mm_blendv_ps(c, m, is_w);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(dst, x);
+        _mm_storeu_ps(dst + 4, y);
+        _mm_storeu_ps(dst + 8, z);
+        _mm_storeu_ps(dst + 12, w);
+    }
+#endif
+
+    /**
+     * @brief Compress an array of unit quaternions using smallest three packing
+     *
+     * @param dst The destination array, with room for count packed quaternions
+     * @param src The source array of normalized quaternions
+     * @param count The number of quaternions to compress
+     */
+    template<uint Bits, typename T>
+    inline void pack_quat(packed_quat<Bits>* dst, const quat<T>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_pack, T, count, profile_simd_sse4_1_build && std::is_same_v<T, float>);
+        MGMATH_CHECK_FLOATS_SCOPE("pack_quat", dst, count, reinterpret_cast<const T*>(src), count * 4);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        if constexpr (std::is_same_v<T, float>) {
+            constexpr float max_value = static_cast<float>((packed_quat<Bits>(1) << Bits) - 1);
+            for (; i + 4 <= count; i += 4) {
+                __m128i idx, a, b, c;
+                simd_quantize_quat4(src[i].data(), max_value, idx, a, b, c);
+                if constexpr (std::is_same_v<packed_quat<Bits>, uint32>) {
+                    __m128i res = _mm_or_si128(a, _mm_slli_epi32(b, Bits));
+                    res = _mm_or_si128(res, _mm_slli_epi32(c, 2 * Bits));
+                    res = _mm_or_si128(res, _mm_slli_epi32(idx, 3 * Bits));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), res);
+                }
+                else {
+                    alignas(16) int32 li[4], la[4], lb[4], lc[4];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(li), idx);
+                    _mm_store_si128(reinterpret_cast<__m128i*>(la), a);
+                    _mm_store_si128(reinterpret_cast<__m128i*>(lb), b);
+                    _mm_store_si128(reinterpret_cast<__m128i*>(lc), c);
+                    for (luint j = 0; j < 4; j++)
+                        dst[i + j] = uint64(uint32(la[j])) | (uint64(uint32(lb[j])) << Bits) | (uint64(uint32(lc[j])) << (2 * Bits)) | (uint64(uint32(li[j])) << (3 * Bits));
+                }
+            }
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = pack_quat<Bits>(src[i]);
+    }
+
+    /**
+     * @brief Decompress an array of quaternions compressed using smallest three packing
+     *
+     * @param dst The destination array, with room for count quaternions
+     * @param src The source array of packed quaternions
+     * @param count The number of quaternions to decompress
+     */
+    template<uint Bits, typename T>
+    inline void unpack_quat(quat<T>* dst, const packed_quat<Bits>* src, const luint count) {
+        MGMATH_PROFILE_BATCH(batch_unpack, T, count, profile_simd_sse4_1_build && std::is_same_v<T, float>);
+        MGMATH_CHECK_FLOATS_SCOPE("unpack_quat", reinterpret_cast<const T*>(dst), count * 4);
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD) && defined(MGMATH_SSE4_1)
+        if constexpr (std::is_same_v<T, float>) {
+            constexpr uint32 mask = (uint32(1) << Bits) - 1;
+            constexpr float max_value = static_cast<float>(mask);
+            for (; i + 4 <= count; i += 4) {
+                if constexpr (std::is_same_v<packed_quat<Bits>, uint32>) {
+                    const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                    const __m128i m = _mm_set1_epi32(mask);
+                    simd_dequantize_quat4(
+                        dst[i].data(), max_value, _mm_srli_epi32(p, 3 * Bits), _mm_and_si128(p, m),
+                        _mm_and_si128(_mm_srli_epi32(p, Bits), m), _mm_and_si128(_mm_srli_epi32(p, 2 * Bits), m)
+                    );
+                }
+                else {
+                    alignas(16) int32 li[4], la[4], lb[4], lc[4];
+                    for (luint j = 0; j < 4; j++) {
+                        const uint64 p = src[i + j];
+                        li[j] = static_cast<int32>((p >> (3 * Bits)) & 3);
+                        la[j] = static_cast<int32>(p & mask);
+                        lb[j] = static_cast<int32>((p >> Bits) & mask);
+                        lc[j] = static_cast<int32>((p >> (2 * Bits)) & mask);
+                    }
+                    simd_dequantize_quat4(
+                        dst[i].data(), max_value, _mm_load_si128(reinterpret_cast<const __m128i*>(li)), _mm_load_si128(reinterpret_cast<const __m128i*>(la)),
+                        _mm_load_si128(reinterpret_cast<const __m128i*>(lb)), _mm_load_si128(reinterpret_cast<const __m128i*>(lc))
+                    );
+                }
+            }
+        }
+#endif
+        for (; i < count; i++)
+            dst[i] = unpack_quat<Bits, T>(src[i]);
+    }
+
+
+    //=============
+    // CONVERSIONS
+    //=============
+
+    /**
+     * @brief How convert rounds floating point values to integers
+     */
+    enum class convert_rounding : uint8 {
+        truncate, // Toward zero, like static_cast
+        nearest,  // To the nearest integer, ties to even (in the default rounding mode)
+        floor,    // Toward negative infinity
+        ceil      // Toward positive infinity
+    };
+
+    /**
+     * @brief What convert does with values that don't fit in the destination type
+     */
+    enum class convert_overflow : uint8 {
+        saturate, // Clamp to the closest representable value, NaN becomes 0
+        unchecked // The caller guarantees that every value fits, the results are unspecified otherwise
+    };
+
+    /**
+     * @brief Convert a scalar to U. The rounding and overflow policies only matter for floating point to integer
+     * conversions and narrowing integer conversions, everything else is a static_cast
+     *
+     * @param x The value to convert
+     */
+    template<typename U, convert_rounding R = convert_rounding::truncate, convert_overflow O = convert_overflow::saturate, typename T>
+    inline U convert(const T x) {
+        if constexpr (std::is_floating_point_v<T> && std::is_integral_v<U>) {
+            T r;
+            if constexpr (R == convert_rounding::truncate)
+                r = std::trunc(x);
+            else if constexpr (R == convert_rounding::nearest)
+                r = std::nearbyint(x);
+            else if constexpr (R == convert_rounding::floor)
+                r = std::floor(x);
+            else
+                r = std::ceil(x);
+            if constexpr (O == convert_overflow::saturate) {
+                if (r != r)
+                    return U(0);
+                // The limits are powers of two (or one less, which rounds up to a power of two in T), and r is integral
+                if (r <= static_cast<T>(std::numeric_limits<U>::lowest()))
+                    return std::numeric_limits<U>::lowest();
+                if (r >= static_cast<T>(std::numeric_limits<U>::max()))
+                    return std::numeric_limits<U>::max();
+            }
+            return static_cast<U>(r);
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_integral_v<U> && O == convert_overflow::saturate) {
+            if constexpr (std::is_signed_v<T>) {
+                if (x < 0) {
+                    if constexpr (!std::is_signed_v<U>)
+                        return U(0);
+                    else if (static_cast<int64>(x) < static_cast<int64>(std::numeric_limits<U>::lowest()))
+                        return std::numeric_limits<U>::lowest();
+                    else
+                        return static_cast<U>(x);
+                }
+            }
+            if (static_cast<uint64>(x) > static_cast<uint64>(std::numeric_limits<U>::max()))
+                return std::numeric_limits<U>::max();
+            return static_cast<U>(x);
+        }
+        else
+            return static_cast<U>(x);
+    }
+
+    /**
+     * @brief Convert every component of a vector to U, see the scalar convert for the policies
+     *
+     * @param v The vector to convert
+     */
+    template<typename U, convert_rounding R = convert_rounding::truncate, convert_overflow O = convert_overflow::saturate, luint S, typename T>
+    inline vec<S, U> convert(const vec<S, T>& v) {
+        vec<S, U> res;
+        for (luint i = 0; i < S; i++)
+            res[i] = convert<U, R, O>(v[i]);
+        return res;
+    }
+
+    /**
+     * @brief Whether the batch convert from T to U uses SIMD in this build
+     */
+    template<typename T, typename U, convert_rounding R = convert_rounding::truncate>
+    constexpr bool convert_simd() {
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+#if defined(MGMATH_SSE4_1)
+        constexpr bool sse4_1 = true;
+#else
+        constexpr bool sse4_1 = false;
+#endif
+        constexpr bool small_int = std::is_same_v<T, int8> || std::is_same_v<T, uint8> || std::is_same_v<T, int16> || std::is_same_v<T, uint16>;
+        constexpr bool small_out = std::is_same_v<U, int8> || std::is_same_v<U, uint8> || std::is_same_v<U, int16> || std::is_same_v<U, uint16>;
+        constexpr bool rounds = R == convert_rounding::truncate || R == convert_rounding::nearest || sse4_1;
+        if constexpr (std::is_same_v<T, int32>)
+            return std::is_same_v<U, float> || std::is_same_v<U, double>;
+        else if constexpr (std::is_same_v<T, float>)
+            return std::is_same_v<U, double> || (std::is_same_v<U, int32> && rounds) || (small_out && sse4_1);
+        else if constexpr (std::is_same_v<T, double>)
+            return std::is_same_v<U, float> || (std::is_same_v<U, int32> && rounds);
+        else
+            return small_int && std::is_same_v<U, float> && sse4_1;
+#else
+        return false;
+#endif
+    }
+
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+    template<convert_rounding R>
+    static constexpr int simd_round_mode = (R == convert_rounding::truncate  ? _MM_FROUND_TO_ZERO
+                                            : R == convert_rounding::floor ? _MM_FROUND_TO_NEG_INF
+                                            : R == convert_rounding::ceil  ? _MM_FROUND_TO_POS_INF
+                                                                           : _MM_FROUND_CUR_DIRECTION) |
+                                           _MM_FROUND_NO_EXC;
+
+    /**
+     * @brief Convert 4 floats to 32 bit integers (floor and ceil need SSE4.1)
+     */
+    template<convert_rounding R, convert_overflow O>
+    inline __m128i simd_convert_epi32(const __m128 x) {
+        __m128i r;
+        if constexpr (R == convert_rounding::truncate)
+            r = _mm_cvttps_epi32(x);
+        else if constexpr (R == convert_rounding::nearest)
+            r = _mm_cvtps_epi32(x);
+        else {
+#if defined(MGMATH_SSE4_1)
+            r = _mm_cvttps_epi32(_mm_round_ps(x, simd_round_mode<R>));
+#else
+            static_assert(R == convert_rounding::truncate, "Rounding floats down or up to integers needs SSE4.1");
+#endif
+        }
+        if constexpr (O == convert_overflow::saturate) {
+            // Out of range lanes convert to 0x80000000, which is right for negative ones; flip it to 0x7fffffff
+            // for positive ones, and clear NaN lanes
+            const __m128 over = _mm_cmpge_ps(x, _mm_set1_ps(2147483648.0f));
+            const __m128 ordered = _mm_cmpord_ps(x, x);
+            r = _mm_and_si128(_mm_xor_si128(r, _mm_castps_si128(over)), _mm_castps_si128(ordered));
+        }
+        return r;
+    }
+
+#if defined(__AVX__)
+    /**
+     * @brief Convert 8 floats to 32 bit integers
+     */
+    template<convert_rounding R, convert_overflow O>
+    inline __m256i simd_convert_epi32(const __m256 x) {
+        __m256i r;
+        if constexpr (R == convert_rounding::truncate)
+            r = _mm256_cvttps_epi32(x);
+        else if constexpr (R == convert_rounding::nearest)
+            r = _mm256_cvtps_epi32(x);
+        else
+            r = _mm256_cvttps_epi32(_mm256_round_ps(x, simd_round_mode<R>));
+        if constexpr (O == convert_overflow::saturate) {
+            const __m256 over = _mm256_cmp_ps(x, _mm256_set1_ps(2147483648.0f), _CMP_GE_OQ);
+            const __m256 ordered = _mm256_cmp_ps(x, x, _CMP_ORD_Q);
+            r = _mm256_castps_si256(_mm256_and_ps(_mm256_xor_ps(_mm256_castsi256_ps(r), over), ordered));
+        }
+        return r;
+    }
+#endif
+#endif
+
+    /**
+     * @brief Convert an array of n scalars, see the batch convert
+     */
+    template<convert_rounding R, convert_overflow O, typename T, typename U>
+    inline void convert_lanes(U* out, const T* in, const luint n) {
+        luint i = 0;
+#if (defined(__x86_64) || defined(__amd64) || defined(_M_X64) || defined(_M_AMD64)) && defined(MGMATH_SIMD)
+        if constexpr (!convert_simd<T, U, R>()) {}
+        else if constexpr (std::is_same_v<T, int32> && std::is_same_v<U, float>) {
+#if defined(__AVX__)
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_ps(out + i, _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i))));
+#endif
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(out + i, _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+        }
+        else if constexpr (std::is_same_v<T, int32> && std::is_same_v<U, double>) {
+#if defined(__AVX__)
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(out + i, _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+#endif
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(out + i, _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i))));
+        }
+        else if constexpr (std::is_same_v<T, float> && std::is_same_v<U, double>) {
+#if defined(__AVX__)
+            for (; i + 4 <= n; i += 4)
+                _mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm_loadu_ps(in + i)));
+#endif
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(out + i, _mm_cvtps_pd(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(in + i))));
+        }
+        else if constexpr (std::is_same_v<T, double> && std::is_same_v<U, float>) {
+#if defined(__AVX__)
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_loadu_pd(in + i)));
+#endif
+            for (; i + 2 <= n; i += 2)
+                _mm_storel_pi(reinterpret_cast<__m64*>(out + i), _mm_cvtpd_ps(_mm_loadu_pd(in + i)));
+        }
+        else if constexpr (std::is_same_v<T, float> && std::is_same_v<U, int32>) {
+#if defined(__AVX__)
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), simd_convert_epi32<R, O>(_mm256_loadu_ps(in + i)));
+#endif
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), simd_convert_epi32<R, O>(_mm_loadu_ps(in + i)));
+        }
+        else if constexpr (std::is_same_v<T, double> && std::is_same_v<U, int32>) {
+            // Every int32 is a double, so clamping before the conversion saturates exactly
+            const __m128d lo = _mm_set1_pd(-2147483648.0), hi = _mm_set1_pd(2147483647.0);
+            for (; i + 2 <= n; i += 2) {
+                __m128d x = _mm_loadu_pd(in + i);
+                if constexpr (O == convert_overflow::saturate)
+                    x = _mm_min_pd(_mm_max_pd(_mm_and_pd(x, _mm_cmpord_pd(x, x)), lo), hi);
+                __m128i r;
+                if constexpr (R == convert_rounding::truncate)
+                    r = _mm_cvttpd_epi32(x);
+                else if constexpr (R == convert_rounding::nearest)
+                    r = _mm_cvtpd_epi32(x);
+                else {
+#if defined(MGMATH_SSE4_1)
+                    r = _mm_cvttpd_epi32(_mm_round_pd(x, simd_round_mode<R>));
+#endif
+                }
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), r);
+            }
+        }
+#if defined(MGMATH_SSE4_1)
+        else if constexpr (std::is_same_v<T, float>) {
+            // 8 and 16 bit integers: round in float, then the packing instructions saturate
+            const __m128 lo = _mm_set1_ps(static_cast<float>(std::numeric_limits<U>::lowest()));
+            const __m128 hi = _mm_set1_ps(static_cast<float>(std::numeric_limits<U>::max()));
+            const auto prepare = [&](__m128 x) {
+                if constexpr (O == convert_overflow::saturate)
+                    x = _mm_min_ps(_mm_max_ps(_mm_and_ps(x, _mm_cmpord_ps(x, x)), lo), hi);
+                if constexpr (R != convert_rounding::nearest)
+                    x = _mm_round_ps(x, simd_round_mode<R>);
+                return x;
+            };
+            for (; i + 16 <= n; i += 16)
+                simd_store_quantized16(out + i, prepare(_mm_loadu_ps(in + i)), prepare(_mm_loadu_ps(in + i + 4)), prepare(_mm_loadu_ps(in + i + 8)), prepare(_mm_loadu_ps(in + i + 12)));
+        }
+        else {
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(out + i, simd_load_widened4(in + i));
+        }
+#endif
+#endif
+        for (; i < n; i++)
+            out[i] = convert<U, R, O>(in[i]);
+    }
+
+    /**
+     * @brief Convert an array of vectors to another component type, using SIMD for int32 to float or double, between
+     * float and double, floats or doubles to int32, and between floats and 8 or 16 bit integers
+     *
+     * For floating point to integer conversions, R chooses the rounding and O what happens to values out of range
+     * (by default they are truncated and saturated); the results are the same with and without SIMD
+     *
+     * @param dst The destination array, with room for count vectors
+     * @param src The source array
+     * @param count The number of vectors to convert
+     */
+    template<convert_rounding R = convert_rounding::truncate, convert_overflow O = convert_overflow::saturate, luint S, typename T, typename U>
+    inline void convert(vec<S, U>* dst, const vec<S, T>* src, const luint count) {
+        static_assert(sizeof(vec<S, T>) == S * sizeof(T) && sizeof(vec<S, U>) == S * sizeof(U), "Vectors must be tightly packed");
+        MGMATH_PROFILE_BATCH(batch_convert, T, count, convert_simd<T, U, R>());
+        MGMATH_CHECK_FLOATS_SCOPE("convert", reinterpret_cast<const U*>(dst), count * S, reinterpret_cast<const T*>(src), count * S);
+        convert_lanes<R, O>(reinterpret_cast<U*>(dst), reinterpret_cast<const T*>(src), count * S);
+    }
+
+
+    //========
+    // MEMORY
+    //========
+
+    /**
+     * @brief Standard allocator for arrays aligned to Alignment bytes, so arrays start on a 64-byte boundary (a cache line) by default
+     */
+    template<typename T, luint Alignment = 64>
+    class aligned_allocator {
+        static_assert((Alignment & (Alignment - 1)) == 0 && Alignment >= alignof(T), "The alignment must be a power of 2, and at least the alignment of T");
+
+      public:
+        using value_type = T;
+
+        template<typename U>
+        struct rebind {
+            using other = aligned_allocator<U, Alignment>;
+        };
+
+        aligned_allocator() = default;
+        template<typename U>
+        aligned_allocator(const aligned_allocator<U, Alignment>&) {}
+
+        T* allocate(const luint count) {
+            if (count > std::numeric_limits<luint>::max() / sizeof(T))
+                throw std::bad_array_new_length{};
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+        }
+
+        void deallocate(T* p, const luint) {
+            ::operator delete(p, std::align_val_t{Alignment});
+        }
+
+        template<typename U>
+        bool operator==(const aligned_allocator<U, Alignment>&) const { return true; }
+        template<typename U>
+        bool operator!=(const aligned_allocator<U, Alignment>&) const { return false; }
+    };
+
+    /**
+     * @brief A std::vector whose elements start on a cache line (`aligned_vector<vec4f>`, `aligned_vector<mat4f>`, ...)
+     */
+    template<typename T>
+    using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+    /**
+     * @brief Linear allocator for scratch arrays that only live for a frame, such as the outputs of the batch functions
+     *
+     * The memory is allocated once when the arena is created; an allocation only moves an offset forward, and `reset`
+     * frees everything at once, so processing frames never touches the heap once the arena is large enough (`peak`
+     * tells how much was needed). Arrays are not initialized and nothing is destroyed, so they must be trivially
+     * destructible types that are written before being read
+     */
+    class frame_arena {
+        unsigned char* memory = nullptr;
+        luint size = 0;
+        luint offset = 0;
+        luint high_water = 0;
+
+      public:
+        /**
+         * @brief Allocate the memory of an arena
+         *
+         * @param capacity The number of bytes of the arena
+         */
+        explicit frame_arena(const luint capacity)
+            : memory(static_cast<unsigned char*>(::operator new(capacity, std::align_val_t{64}))), size(capacity) {}
+
+        frame_arena(const frame_arena&) = delete;
+        frame_arena& operator=(const frame_arena&) = delete;
+
+        frame_arena(frame_arena&& other) noexcept
+            : memory(other.memory), size(other.size), offset(other.offset), high_water(other.high_water) {
+            other.memory = nullptr;
+            other.size = other.offset = other.high_water = 0;
+        }
+
+        frame_arena& operator=(frame_arena&& other) noexcept {
+            if (this != &other) {
+                ::operator delete(memory, std::align_val_t{64});
+                memory = other.memory, size = other.size, offset = other.offset, high_water = other.high_water;
+                other.memory = nullptr;
+                other.size = other.offset = other.high_water = 0;
+            }
+            return *this;
+        }
+
+        ~frame_arena() {
+            ::operator delete(memory, std::align_val_t{64});
+        }
+
+        /**
+         * @brief Allocate an uninitialized array, valid until the arena is reset (or rewound before it)
+         *
+         * @param count The number of elements
+         * @param alignment The alignment of the first element (power of 2, a cache line by default)
+         * @return The array (throws if the arena is full)
+         */
+        template<typename T>
+        T* allocate(const luint count, const luint alignment = 64) {
+            static_assert(std::is_trivially_destructible_v<T>, "Arrays in a frame arena are never destroyed");
+            if ((alignment & (alignment - 1)) != 0 || alignment < alignof(T) || alignment > 64)
+                throw std::runtime_error{"Invalid frame arena alignment"};
+            const luint start = (offset + alignment - 1) & ~(alignment - 1);
+            if (start > size || count > (size - start) / sizeof(T))
+                throw std::runtime_error{"Frame arena is full"};
+            offset = start + count * sizeof(T);
+            high_water = max(high_water, offset);
+            return reinterpret_cast<T*>(memory + start);
+        }
+
+        /**
+         * @brief The current position in the arena, to free everything allocated after it with `rewind`
+         */
+        luint mark() const { return offset; }
+
+        /**
+         * @brief Free everything allocated since `mark` returned m
+         */
+        void rewind(const luint m) {
+            if (m > offset)
+                throw std::runtime_error{"Rewinding a frame arena forward"};
+            offset = m;
+        }
+
+        /**
+         * @brief Free every array of the arena at once, usually at the start of a frame
+         */
+        void reset() { offset = 0; }
+
+        /**
+         * @brief The number of bytes allocated since the last reset
+         */
+        luint used() const { return offset; }
+
+        /**
+         * @brief The largest number of bytes ever used at once, to size the arena
+         */
+        luint peak() const { return high_water; }
+
+        luint capacity() const { return size; }
+    };
+
+
+    //======
+    // TEXT
+    //======
+
+    /**
+     * @brief Separators used when formatting and parsing arrays of vectors as text
+     */
+    struct text_format {
+        // Written between the components of a vector
+        std::string_view component_separator = " ";
+        // Written after every vector, including the last one
+        std::string_view element_separator = "\n";
+    };
+
+    /**
+     * @brief The maximum number of characters needed to format a single scalar of type T
+     */
+    template<typename T>
+    constexpr luint max_formatted_scalar_size() {
+        if constexpr (std::is_floating_point_v<T>)
+            // Sign, digits, decimal point and exponent of the shortest round-trip representation
+            return static_cast<luint>(std::numeric_limits<T>::max_digits10) + 9;
+        else
+            return static_cast<luint>(std::numeric_limits<T>::digits10) + 2;
+    }
+
+    /**
+     * @brief The size of a buffer large enough to format count vectors with format_to
+     *
+     * @param count The number of vectors
+     * @param format The separators to use
+     */
+    template<luint S, typename T>
+    constexpr luint max_formatted_size(const luint count, const text_format& format = {}) {
+        return count * (S * max_formatted_scalar_size<T>() + (S - 1) * format.component_separator.size() + format.element_separator.size());
+    }
+
+    /**
+     * @brief Format an array of vectors as text, using the shortest representation that parses back to the same value
+     *
+     * @param buf The output buffer, with room for at least max_formatted_size<S, T>(count, format) characters
+     * @param src The vectors to format
+     * @param count The number of vectors
+     * @param format The separators to use
+     * @return A pointer past the last written character (no null terminator is written)
+     */
+    template<luint S, typename T>
+    char* format_to(char* buf, const vec<S, T>* src, const luint count, const text_format& format = {}) {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Only vectors of numbers can be formatted");
+        constexpr luint max_scalar = max_formatted_scalar_size<T>();
+        const char* const comp_sep = format.component_separator.data();
+        const luint comp_sep_size = format.component_separator.size();
+        const char* const elem_sep = format.element_separator.data();
+        const luint elem_sep_size = format.element_separator.size();
+
+        for (luint i = 0; i < count; i++) {
+            const T* v = src[i].data();
+            for (luint j = 0; j < S; j++) {
+                if (j != 0) {
+                    memcpy(buf, comp_sep, comp_sep_size);
+                    buf += comp_sep_size;
+                }
+                buf = std::to_chars(buf, buf + max_scalar, v[j]).ptr;
+            }
+            memcpy(buf, elem_sep, elem_sep_size);
+            buf += elem_sep_size;
+        }
+        return buf;
+    }
+
+    /**
+     * @brief Format an array of vectors as text, appending to a string
+     *
+     * @param out The string to append to
+     * @param src The vectors to format
+     * @param count The number of vectors
+     * @param format The separators to use
+     */
+    template<luint S, typename T>
+    void format_to(std::string& out, const vec<S, T>* src, const luint count, const text_format& format = {}) {
+        const luint old_size = out.size();
+        out.resize(old_size + max_formatted_size<S, T>(count, format));
+        char* const end = format_to(out.data() + old_size, src, count, format);
+        out.resize(static_cast<luint>(end - out.data()));
+    }
+
+    /**
+     * @brief Parse an array of vectors from text
+     * @details Whitespace and the characters of both separators are all treated as delimiters, so the exact separators
+     * don't have to match (for example "1,2,3\n" and "1 2 3 " both parse with the default format)
+     *
+     * @param text The text to parse
+     * @param dst The destination array, with room for count vectors
+     * @param count The maximum number of vectors to parse
+     * @param format The separators used in the text
+     * @return The number of vectors parsed (smaller than count if the text ended first)
+     */
+    template<luint S, typename T>
+    luint parse(const std::string_view text, vec<S, T>* dst, const luint count, const text_format& format = {}) {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Only vectors of numbers can be parsed");
+        bool delimiter[256]{};
+        delimiter[static_cast<unsigned char>(' ')] = delimiter[static_cast<unsigned char>('\t')] = true;
+        delimiter[static_cast<unsigned char>('\n')] = delimiter[static_cast<unsigned char>('\r')] = true;
+        for (const char ch : format.component_separator)
+            delimiter[static_cast<unsigned char>(ch)] = true;
+        for (const char ch : format.element_separator)
+            delimiter[static_cast<unsigned char>(ch)] = true;
+
+        const char* p = text.data();
+        const char* const end = p + text.size();
+        for (luint i = 0; i < count; i++) {
+            T* v = dst[i].data();
+            for (luint j = 0; j < S; j++) {
+                while (p != end && delimiter[static_cast<unsigned char>(*p)])
+                    ++p;
+                if (p == end) {
+                    if (j == 0)
+                        return i;
+                    throw std::runtime_error{"Unexpected end of text while parsing vector"};
+                }
+                if (*p == '+')
+                    ++p;
+                const auto res = std::from_chars(p, end, v[j]);
+                if (res.ec != std::errc{})
+                    throw std::runtime_error{"Invalid number while parsing vector"};
+                p = res.ptr;
+            }
+        }
+        return count;
+    }
+
+
+#if defined(MGMATH_IO)
+    //==============
+    // BINARY FILES
+    //==============
+
+    // Container format for arrays of scalars, vectors, matrices and quaternions (little endian):
+    // an array_file_header, zero padding up to data_offset, then count tightly packed elements.
+    // data_offset is a multiple of the alignment stored in the header, so mapped data can be used with aligned loads
+
+    enum class scalar_type : uint8 {
+        u8,
+        i8,
+        u16,
+        i16,
+        u32,
+        i32,
+        u64,
+        i64,
+        f32,
+        f64
+    };
+
+    enum class element_kind : uint8 {
+        scalar,
+        vector,
+        matrix,
+        quaternion
+    };
+
+    template<typename T>
+    constexpr scalar_type scalar_type_of() {
+        if constexpr (std::is_same_v<T, uint8>) return scalar_type::u8;
+        else if constexpr (std::is_same_v<T, int8>) return scalar_type::i8;
+        else if constexpr (std::is_same_v<T, uint16>) return scalar_type::u16;
+        else if constexpr (std::is_same_v<T, int16>) return scalar_type::i16;
+        else if constexpr (std::is_same_v<T, uint32>) return scalar_type::u32;
+        else if constexpr (std::is_same_v<T, int32>) return scalar_type::i32;
+        else if constexpr (std::is_same_v<T, uint64>) return scalar_type::u64;
+        else if constexpr (std::is_same_v<T, int64>) return scalar_type::i64;
+        else if constexpr (std::is_same_v<T, float>) return scalar_type::f32;
+        else {
+            static_assert(std::is_same_v<T, double>, "Unsupported scalar type");
+            return scalar_type::f64;
+        }
+    }
+
+    /**
+     * @brief Describes how an element type is stored in a binary array file
+     */
+    template<typename E>
+    struct element_traits {
+        using scalar = E;
+        static constexpr element_kind kind = element_kind::scalar;
+        static constexpr uint32 lines = 1;
+        static constexpr uint32 columns = 1;
+    };
+    template<luint S, typename T>
+    struct element_traits<vec<S, T>> {
+        using scalar = T;
+        static constexpr element_kind kind = element_kind::vector;
+        static constexpr uint32 lines = 1;
+        static constexpr uint32 columns = static_cast<uint32>(S);
+    };
+    template<luint l, luint c, typename T>
+    struct element_traits<mat<l, c, T>> {
+        using scalar = T;
+        static constexpr element_kind kind = element_kind::matrix;
+        static constexpr uint32 lines = static_cast<uint32>(l);
+        static constexpr uint32 columns = static_cast<uint32>(c);
+    };
+    template<typename T>
+    struct element_traits<quat<T>> {
+        using scalar = T;
+        static constexpr element_kind kind = element_kind::quaternion;
+        static constexpr uint32 lines = 1;
+        static constexpr uint32 columns = 4;
+    };
+
+    struct array_file_header {
+        static constexpr uint16 current_version = 1;
+        static constexpr uint16 byte_order_mark = 0xfeff;
+
+        char magic[4] = {'M', 'G', 'M', 'A'};
+        uint16 version = current_version;
+        uint16 byte_order = byte_order_mark;
+        element_kind kind = element_kind::scalar;
+        scalar_type scalar = scalar_type::f32;
+        uint16 reserved = 0;
+        uint32 lines = 1;
+        uint32 columns = 1;
+        uint32 alignment = 64;
+        uint64 count = 0;
+        uint64 data_offset = 0;
+
+        /**
+         * @brief Create a header describing an array of elements of type E
+         *
+         * @param count The number of elements in the array
+         * @param alignment The alignment of the first element in the file (power of 2)
+         */
+        template<typename E>
+        static array_file_header describe(const uint64 count = 0, const uint32 alignment = 64) {
+            using traits = element_traits<E>;
+            static_assert(sizeof(E) == traits::lines * traits::columns * sizeof(typename traits::scalar), "Elements must be tightly packed");
+            if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+                throw std::runtime_error{"Alignment must be a power of 2"};
+
+            array_file_header h{};
+            h.kind = traits::kind;
+            h.scalar = scalar_type_of<typename traits::scalar>();
+            h.lines = traits::lines;
+            h.columns = traits::columns;
+            h.alignment = max(alignment, static_cast<uint32>(alignof(E)));
+            h.count = count;
+            h.data_offset = (sizeof(array_file_header) + h.alignment - 1) / h.alignment * h.alignment;
+            return h;
+        }
+
+        /**
+         * @brief Check whether a header read from a file is valid and describes an array of elements of type E
+         */
+        template<typename E>
+        bool matches() const {
+            using traits = element_traits<E>;
+            return memcmp(magic, "MGMA", 4) == 0
+                && version == current_version
+                && byte_order == byte_order_mark
+                && kind == traits::kind
+                && scalar == scalar_type_of<typename traits::scalar>()
+                && lines == traits::lines
+                && columns == traits::columns
+                && data_offset >= sizeof(array_file_header)
+                && data_offset % alignof(E) == 0;
+        }
+    };
+    static_assert(sizeof(array_file_header) == 40, "array_file_header must not contain padding");
+
+    /**
+     * @brief Streaming writer for binary array files; elements can be appended in any number of chunks
+     */
+    template<typename E>
+    class array_file_writer {
+        std::FILE* file = nullptr;
+        array_file_header header{};
+
+      public:
+        /**
+         * @brief Create (or overwrite) a binary array file
+         *
+         * @param path The path of the file
+         * @param alignment The alignment of the first element in the file (power of 2)
+         */
+        explicit array_file_writer(const char* path, const uint32 alignment = 64)
+            : header(array_file_header::describe<E>(0, alignment)) {
+            file = std::fopen(path, "wb");
+            if (file == nullptr)
+                throw std::runtime_error{"Cannot open file for writing"};
+
+            char padding[256]{};
+            bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+            for (luint left = header.data_offset - sizeof(header); written && left > 0;) {
+                const luint chunk = min(left, static_cast<luint>(sizeof(padding)));
+                written = std::fwrite(padding, 1, chunk, file) == chunk;
+                left -= chunk;
+            }
+            if (!written) {
+                // The destructor doesn't run when the constructor throws
+                std::fclose(file);
+                file = nullptr;
+                throw std::runtime_error{"Cannot write file header"};
+            }
+        }
+
+        array_file_writer(const array_file_writer&) = delete;
+        array_file_writer& operator=(const array_file_writer&) = delete;
+
+        ~array_file_writer() {
+            if (file != nullptr) {
+                std::fseek(file, 0, SEEK_SET);
+                std::fwrite(&header, sizeof(header), 1, file);
+                std::fclose(file);
+            }
+        }
+
+        /**
+         * @brief Append elements to the file
+         *
+         * @param data The elements to append
+         * @param count The number of elements
+         */
+        void write(const E* data, const luint count) {
+            if (file == nullptr)
+                throw std::runtime_error{"Writing to a closed file"};
+            if (std::fwrite(data, sizeof(E), count, file) != count)
+                throw std::runtime_error{"Cannot write to file"};
+            header.count += count;
+        }
+
+        /**
+         * @brief Append a single element to the file
+         */
+        void write(const E& element) {
+            write(&element, 1);
+        }
+
+        /**
+         * @brief The number of elements written so far
+         */
+        uint64 size() const { return header.count; }
+
+        /**
+         * @brief Write the final element count into the header and close the file
+         */
+        void close() {
+            if (file == nullptr)
+                return;
+            const bool ok = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+            const bool closed = std::fclose(file) == 0;
+            file = nullptr;
+            if (!ok || !closed)
+                throw std::runtime_error{"Cannot finalize file"};
+        }
+    };
+
+    /**
+     * @brief Read-only, zero-copy view of a binary array file, mapped into memory
+     */
+    template<typename E>
+    class mapped_array {
+        const void* mapping = nullptr;
+        luint mapping_size = 0;
+        array_file_header header{};
+#if defined(_WIN32)
+        HANDLE file_handle = INVALID_HANDLE_VALUE;
+        HANDLE mapping_handle = nullptr;
+#endif
+
+        void release() {
+#if defined(_WIN32)
+            if (mapping != nullptr)
+                UnmapViewOfFile(mapping);
+            if (mapping_handle != nullptr)
+                CloseHandle(mapping_handle);
+            if (file_handle != INVALID_HANDLE_VALUE)
+                CloseHandle(file_handle);
+            file_handle = INVALID_HANDLE_VALUE;
+            mapping_handle = nullptr;
+#else
+            if (mapping != nullptr)
+                munmap(const_cast<void*>(mapping), mapping_size);
+#endif
+            mapping = nullptr;
+            mapping_size = 0;
+        }
+
+      public:
+        mapped_array() = default;
+
+        /**
+         * @brief Map a binary array file into memory, and validate that it contains elements of type E
+         *
+         * @param path The path of the file
+         */
+        explicit mapped_array(const char* path) {
+#if defined(_WIN32)
+            file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file_handle == INVALID_HANDLE_VALUE)
+                throw std::runtime_error{"Cannot open file for reading"};
+            LARGE_INTEGER size{};
+            if (!GetFileSizeEx(file_handle, &size)) {
+                release();
+                throw std::runtime_error{"Cannot read file size"};
+            }
+            mapping_size = static_cast<luint>(size.QuadPart);
+            if (mapping_size < sizeof(array_file_header)) {
+                release();
+                throw std::runtime_error{"File is too small to be an array file"};
+            }
+            mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_handle != nullptr)
+                mapping = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+            if (mapping == nullptr) {
+                release();
+                throw std::runtime_error{"Cannot map file"};
+            }
+#else
+            const int fd = open(path, O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error{"Cannot open file for reading"};
+            struct stat st{};
+            if (fstat(fd, &st) != 0 || static_cast<luint>(st.st_size) < sizeof(array_file_header)) {
+                ::close(fd);
+                throw std::runtime_error{"File is too small to be an array file"};
+            }
+            mapping_size = static_cast<luint>(st.st_size);
+            void* m = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (m == MAP_FAILED)
+                throw std::runtime_error{"Cannot map file"};
+            mapping = m;
+#endif
+            memcpy(&header, mapping, sizeof(header));
+            if (!header.matches<E>()) {
+                release();
+                throw std::runtime_error{"File does not contain an array of the requested element type"};
+            }
+            if (header.data_offset > mapping_size || header.count > (mapping_size - header.data_offset) / sizeof(E)) {
+                release();
+                throw std::runtime_error{"File is truncated"};
+            }
+        }
+
+        mapped_array(const mapped_array&) = delete;
+        mapped_array& operator=(const mapped_array&) = delete;
+
+        mapped_array(mapped_array&& other) noexcept {
+            *this = std::move(other);
+        }
+        mapped_array& operator=(mapped_array&& other) noexcept {
+            if (this != &other) {
+                release();
+                mapping = other.mapping;
+                mapping_size = other.mapping_size;
+                header = other.header;
+#if defined(_WIN32)
+                file_handle = other.file_handle;
+                mapping_handle = other.mapping_handle;
+                other.file_handle = INVALID_HANDLE_VALUE;
+                other.mapping_handle = nullptr;
+#endif
+                other.mapping = nullptr;
+                other.mapping_size = 0;
+                other.header = array_file_header{};
+            }
+            return *this;
+        }
+
+        ~mapped_array() {
+            release();
+        }
+
+        const E* data() const {
+            if (mapping == nullptr)
+                return nullptr;
+            return reinterpret_cast<const E*>(static_cast<const char*>(mapping) + header.data_offset);
+        }
+        luint size() const { return mapping != nullptr ? static_cast<luint>(header.count) : 0; }
+        bool empty() const { return size() == 0; }
+
+        const E* begin() const { return data(); }
+        const E* end() const { return data() + size(); }
+
+        const E& operator[](const luint i) const {
+#if !defined(NDEBUG)
+            if (i >= size())
+                throw std::runtime_error{"Index out of range"};
+#endif
+            return data()[i];
+        }
+
+        /**
+         * @brief Get a view of the whole array, without copying anything
+         */
+        std::span<const E> view() const { return std::span<const E>{data(), size()}; }
+        operator std::span<const E>() const { return view(); }
+
+        /**
+         * @brief The header stored at the start of the file
+         */
+        const array_file_header& file_header() const { return header; }
+    };
+#endif
 } // namespace mgm